@@ -0,0 +1,107 @@
+#ifndef FLOW_FUTEX_HEADER
+#define FLOW_FUTEX_HEADER
+
+#include <bits/stdc++.h>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace flow_futex_tools {
+	// Size of a cache line, used to keep data that is written by different
+	// threads on different cache lines
+
+	constexpr size_t CACHE_LINE_SIZE = 64;
+};
+
+namespace flow {
+	using namespace flow_futex_tools;
+
+	/**
+	 *  @brief  Blocks the calling thread as long as a 32-bit word holds an
+	 *  expected value. May return spuriously, callers must check the
+	 *  condition they are waiting for again.
+	 *  @param  word  The word to wait on.
+	 *  @param  expected  The value the word is expected to hold. If it holds
+	 *  another value, the call returns immediately.
+	 */
+	inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+			FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+	}
+
+	/**
+	 *  @brief  Wakes threads that are blocked in futex_wait() on a word.
+	 *  @param  word  The word the threads are waiting on.
+	 *  @param  count  The maximum number of threads to wake.
+	 */
+	inline void futex_wake(std::atomic<uint32_t>& word, uint32_t count = INT_MAX)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+			FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+	}
+
+	/**
+	 *  @brief  Lets threads sleep until a condition becomes true, without
+	 *  a mutex. Waiting is done in three steps: prepare_wait() registers the
+	 *  waiter, the condition is checked again, then wait() sleeps unless
+	 *  notify() was called in between. notify() is a single load when there
+	 *  are no waiters, so the producing side stays cheap.
+	 */
+	class EventCount {
+		private:
+			std::atomic<uint32_t> epoch = 0;
+			std::atomic<uint32_t> waiters = 0;
+
+		public:
+			/**
+			 *  @brief  Registers the calling thread as a waiter.
+			 *  @returns  A key to pass to wait().
+			 */
+			uint32_t prepare_wait()
+			{
+				waiters.fetch_add(1, std::memory_order_seq_cst);
+				return epoch.load(std::memory_order_seq_cst);
+			}
+
+			/**
+			 *  @brief  Unregisters the calling thread, used when the condition
+			 *  became true after prepare_wait().
+			 */
+			void cancel_wait()
+			{
+				waiters.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			/**
+			 *  @brief  Sleeps until notify() is called, unless it was already
+			 *  called since prepare_wait() returned the key.
+			 *  @param  key  The key returned by prepare_wait().
+			 */
+			void wait(uint32_t key)
+			{
+				while (epoch.load(std::memory_order_acquire) == key) {
+					futex_wait(epoch, key);
+				}
+
+				waiters.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			/**
+			 *  @brief  Wakes waiting threads. Must be called after the change
+			 *  that makes the condition true is visible.
+			 *  @param  count  The maximum number of threads to wake.
+			 */
+			void notify(uint32_t count = INT_MAX)
+			{
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (waiters.load(std::memory_order_relaxed) == 0) return;
+
+				epoch.fetch_add(1, std::memory_order_release);
+				futex_wake(epoch, count);
+			}
+	};
+};
+
+#endif
@@ -0,0 +1,682 @@
+#ifndef FLOW_FUTURE_HEADER
+#define FLOW_FUTURE_HEADER
+
+#include <bits/stdc++.h>
+
+#include "thread-pool.hpp"
+#include "../data-structures/dynamic-array.hpp"
+#include "../events/inplace-function.hpp"
+#include "../memory/arena.hpp"
+#include "../memory/block-pool.hpp"
+#include "../memory/shared-pointer.hpp"
+
+// Shared states up to this size are pooled, bigger ones use the heap
+
+#ifndef FLOW_FUTURE_STATE_POOL_MAX_SIZE
+#define FLOW_FUTURE_STATE_POOL_MAX_SIZE (size_t) 1024
+#endif
+
+namespace flow {
+	template <typename T>
+	class Future;
+
+	template <typename T>
+	class Promise;
+
+	enum class FutureErrors {
+		BROKEN_PROMISE,
+		PROMISE_ALREADY_SATISFIED,
+		FUTURE_ALREADY_RETRIEVED,
+		FUTURE_NOT_READY,
+		EMPTY_FUTURE,
+		NO_FUTURES
+	};
+
+	/**
+	 *  @brief  The result of when_any(): the index of the Future that
+	 *  became ready first, and its value.
+	 */
+	template <typename T>
+	struct WhenAnyResult {
+		size_t index;
+		T value;
+	};
+};
+
+namespace flow_future_tools {
+	enum class FutureStatus : uint8_t {
+		PENDING,
+		CONTINUATION_SET,
+		READY
+	};
+
+	// A Future<void> stores an Empty value, so it shares the code of other Futures
+
+	struct Empty {};
+
+	template <typename T>
+	using stored_t = std::conditional_t<std::is_void_v<T>, Empty, T>;
+
+	// States are freed to the pool of the thread that drops the last reference
+
+	inline thread_local flow::BlockPool<FLOW_FUTURE_STATE_POOL_MAX_SIZE> state_pool;
+
+	/**
+	 *  @brief  Base of objects that are shared between threads and
+	 *  allocated from the state pool of the thread.
+	 */
+	struct PooledState : public flow::RefCounted<true> {
+		static void *operator new(size_t size)
+		{
+			return state_pool.allocate(size);
+		}
+
+		static void operator delete(void *ptr, size_t size)
+		{
+			state_pool.deallocate(ptr, size);
+		}
+	};
+
+	/**
+	 *  @brief  The state shared by a Promise and its Future: the value or
+	 *  exception, and the continuation that consumes it.
+	 *  Whoever comes second of the producer and the continuation runs the
+	 *  continuation, so no lock is needed.
+	 */
+	template <typename T>
+	class FutureState : public PooledState {
+		public:
+			using Value = stored_t<T>;
+
+			typedef flow::InplaceFunction<void(FutureState<T> *), FLOW_TASK_SIZE>
+				continuation_t;
+
+		private:
+			std::atomic<FutureStatus> status = FutureStatus::PENDING;
+
+			alignas(Value) unsigned char storage[sizeof(Value)];
+			bool has_value = false;
+
+			std::exception_ptr exception;
+			continuation_t continuation;
+
+			void publish()
+			{
+				if (status.exchange(FutureStatus::READY, std::memory_order_acq_rel)
+					!= FutureStatus::CONTINUATION_SET) return;
+
+				continuation(this);
+				continuation.reset();
+			}
+
+		public:
+			FutureState() {}
+
+			FutureState(const FutureState& other) = delete;
+			FutureState& operator=(const FutureState& other) = delete;
+
+			~FutureState()
+			{
+				if (has_value) value().~Value();
+			}
+
+			bool is_ready() const
+			{
+				return status.load(std::memory_order_acquire) == FutureStatus::READY;
+			}
+
+			Value& value()
+			{
+				return *std::launder(reinterpret_cast<Value *>(storage));
+			}
+
+			const std::exception_ptr& get_exception() const
+			{
+				return exception;
+			}
+
+			template <typename... Args>
+			void set_value(Args&&... args)
+			{
+				// The value lives as long as the state, which may outlive the
+				// Arena bound on the thread that satisfies it
+
+				{
+					flow::ArenaScope heap_scope(NULL);
+					new (storage) Value(std::forward<Args>(args)...);
+				}
+
+				has_value = true;
+				publish();
+			}
+
+			void set_exception(std::exception_ptr exception)
+			{
+				this->exception = exception;
+				publish();
+			}
+
+			/**
+			 *  @brief  Sets the continuation, or runs it right away on the
+			 *  calling thread if the state is ready.
+			 */
+			void on_ready(continuation_t&& fn)
+			{
+				continuation = std::move(fn);
+
+				FutureStatus expected = FutureStatus::PENDING;
+
+				if (status.compare_exchange_strong(expected, FutureStatus::CONTINUATION_SET,
+					std::memory_order_acq_rel, std::memory_order_acquire)) return;
+
+				continuation(this);
+				continuation.reset();
+			}
+	};
+
+	template <typename T>
+	struct unwrap_future {
+		using type = T;
+	};
+
+	template <typename T>
+	struct unwrap_future<flow::Future<T>> {
+		using type = T;
+	};
+
+	template <typename T>
+	constexpr bool is_future = false;
+
+	template <typename T>
+	constexpr bool is_future<flow::Future<T>> = true;
+
+	/**
+	 *  @brief  The type a continuation returns when it is called with the
+	 *  value of a FutureState<T>.
+	 */
+	template <typename T, typename Callable>
+	struct continuation_result {
+		using type = std::invoke_result_t<Callable&, T&&>;
+	};
+
+	template <typename Callable>
+	struct continuation_result<void, Callable> {
+		using type = std::invoke_result_t<Callable&>;
+	};
+
+	template <typename T, typename Callable>
+	using continuation_result_t = typename continuation_result<T, Callable>::type;
+
+	/**
+	 *  @brief  Something continuations can be scheduled on: a ThreadPool,
+	 *  a SocketServer or any type with the same methods.
+	 */
+	template <typename Executor>
+	concept FutureExecutor = requires(Executor& executor, flow::task_t&& fn) {
+		{ executor.runs_on_current_thread() } -> std::convertible_to<bool>;
+	} && (
+		requires(Executor& executor, flow::task_t&& fn) { executor.post(std::move(fn)); }
+		|| requires(Executor& executor, flow::task_t&& fn) { executor.submit(std::move(fn)); }
+	);
+
+	template <FutureExecutor Executor>
+	void execute_on(Executor& executor, flow::task_t&& fn)
+	{
+		if constexpr (requires { executor.post(std::move(fn)); }) {
+			executor.post(std::move(fn));
+		} else {
+			executor.submit(std::move(fn));
+		}
+	}
+
+	/**
+	 *  @brief  Gives the combinators access to the state of a Future.
+	 */
+	struct FutureAccess {
+		template <typename T>
+		static flow::IntrusivePointer<FutureState<T>> take_state(flow::Future<T>& future)
+		{
+			return future.take_state();
+		}
+	};
+};
+
+namespace flow {
+	using namespace flow_future_tools;
+
+	/**
+	 *  @brief  The producing end of a Future. A Promise that is destroyed
+	 *  without a value or exception breaks its Future with
+	 *  FutureErrors::BROKEN_PROMISE.
+	 *  @tparam  T  The type of the value, may be void.
+	 */
+	template <typename T>
+	class Promise {
+		private:
+			IntrusivePointer<FutureState<T>> state;
+			bool future_retrieved = false;
+
+			void check_unsatisfied()
+			{
+				if (!state) throw FutureErrors::PROMISE_ALREADY_SATISFIED;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates a Promise and its shared state.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1), pooled
+			 */
+			Promise() : state(new FutureState<T>()) {}
+
+			Promise(const Promise& other) = delete;
+			Promise& operator=(const Promise& other) = delete;
+
+			Promise(Promise&& other) noexcept
+				: state(std::move(other.state)), future_retrieved(other.future_retrieved) {}
+
+			Promise& operator=(Promise&& other)
+			{
+				if (this == &other) return *this;
+
+				break_promise();
+				state = std::move(other.state);
+				future_retrieved = other.future_retrieved;
+
+				return *this;
+			}
+
+			~Promise()
+			{
+				break_promise();
+			}
+
+			/**
+			 *  @brief  Returns the Future of this Promise, can only be called once.
+			 */
+			Future<T> get_future()
+			{
+				check_unsatisfied();
+				if (future_retrieved) throw FutureErrors::FUTURE_ALREADY_RETRIEVED;
+
+				future_retrieved = true;
+				return Future<T>(state);
+			}
+
+			/**
+			 *  @brief  Makes the Future ready with a value. The continuation
+			 *  of the Future, if set, runs on the calling thread.
+			 *  @param  args  The arguments to construct the value from,
+			 *  none for a Promise<void>.
+			 */
+			template <typename... Args>
+			void set_value(Args&&... args)
+			{
+				check_unsatisfied();
+
+				IntrusivePointer<FutureState<T>> satisfied = std::move(state);
+				satisfied->set_value(std::forward<Args>(args)...);
+			}
+
+			/**
+			 *  @brief  Makes the Future ready with an exception, which is
+			 *  rethrown by Future::get() and skips continuations.
+			 */
+			void set_exception(std::exception_ptr exception)
+			{
+				check_unsatisfied();
+
+				IntrusivePointer<FutureState<T>> satisfied = std::move(state);
+				satisfied->set_exception(exception);
+			}
+
+			/**
+			 *  @brief  Breaks the Future if the Promise was not satisfied yet.
+			 */
+			void break_promise()
+			{
+				if (!state) return;
+				set_exception(std::make_exception_ptr(FutureErrors::BROKEN_PROMISE));
+			}
+	};
+
+	/**
+	 *  @brief  A value that becomes available later, produced by a Promise.
+	 *  Work is chained with then(): the continuation runs on the thread
+	 *  that makes the Future ready, or inline if it is ready already.
+	 *  A continuation can also be scheduled on an executor such as a
+	 *  ThreadPool or a SocketServer, it runs inline if the calling thread
+	 *  belongs to the executor. A Future is move-only and has at most one
+	 *  continuation. Shared states are allocated from a thread local pool.
+	 *  @tparam  T  The type of the value, may be void.
+	 */
+	template <typename T>
+	class Future {
+		private:
+			IntrusivePointer<FutureState<T>> state;
+
+			friend class Promise<T>;
+			friend struct flow_future_tools::FutureAccess;
+
+			template <typename U>
+			friend class Future;
+
+			Future(const IntrusivePointer<FutureState<T>>& state) : state(state) {}
+
+			IntrusivePointer<FutureState<T>> take_state()
+			{
+				if (!state) throw FutureErrors::EMPTY_FUTURE;
+				return std::move(state);
+			}
+
+			/**
+			 *  @brief  Calls fn with the value of a ready state and
+			 *  satisfies the next Promise with the result. Exceptions of
+			 *  the state and of fn go to the next Promise.
+			 */
+			template <typename Callable, typename U>
+			static void continue_with(FutureState<T> *ready, Callable& fn, Promise<U>& next)
+			{
+				if (ready->get_exception()) {
+					next.set_exception(ready->get_exception());
+					return;
+				}
+
+				using Result = continuation_result_t<T, Callable>;
+
+				try {
+					if constexpr (is_future<Result>) {
+						invoke(ready, fn).forward_to(std::move(next));
+					} else if constexpr (std::is_void_v<Result>) {
+						invoke(ready, fn);
+						next.set_value();
+					} else {
+						next.set_value(invoke(ready, fn));
+					}
+				} catch (...) {
+					next.set_exception(std::current_exception());
+				}
+			}
+
+			template <typename Callable>
+			static decltype(auto) invoke(FutureState<T> *ready, Callable& fn)
+			{
+				if constexpr (std::is_void_v<T>) return fn();
+				else return fn(std::move(ready->value()));
+			}
+
+			/**
+			 *  @brief  Satisfies a Promise with the outcome of this Future.
+			 */
+			void forward_to(Promise<T>&& promise)
+			{
+				take_state()->on_ready([promise = std::move(promise)]
+					(FutureState<T> *ready) mutable
+				{
+					if (ready->get_exception()) promise.set_exception(ready->get_exception());
+					else if constexpr (std::is_void_v<T>) promise.set_value();
+					else promise.set_value(std::move(ready->value()));
+				});
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an empty Future, without a Promise.
+			 */
+			Future() {}
+
+			Future(const Future& other) = delete;
+			Future& operator=(const Future& other) = delete;
+
+			Future(Future&& other) noexcept : state(std::move(other.state)) {}
+
+			Future& operator=(Future&& other)
+			{
+				state = std::move(other.state);
+				return *this;
+			}
+
+			/**
+			 *  @brief  Returns whether the Future has a state, which it loses
+			 *  when it is consumed by get() or then().
+			 */
+			bool valid() const
+			{
+				return (bool) state;
+			}
+
+			/**
+			 *  @brief  Returns whether the value or exception is available.
+			 */
+			bool is_ready() const
+			{
+				return state && state->is_ready();
+			}
+
+			/**
+			 *  @brief  Takes the value of a ready Future, or rethrows its
+			 *  exception. Throws FutureErrors::FUTURE_NOT_READY if the Future
+			 *  is not ready, it never blocks.
+			 */
+			T get()
+			{
+				if (!state) throw FutureErrors::EMPTY_FUTURE;
+				if (!state->is_ready()) throw FutureErrors::FUTURE_NOT_READY;
+
+				IntrusivePointer<FutureState<T>> ready = std::move(state);
+
+				if (ready->get_exception()) std::rethrow_exception(ready->get_exception());
+				if constexpr (!std::is_void_v<T>) return std::move(ready->value());
+			}
+
+			/**
+			 *  @brief  Chains a function that is called with the value of
+			 *  this Future. It runs inline if the Future is ready, and on the
+			 *  thread that satisfies the Promise otherwise.
+			 *  @param  fn  Takes a T&&, or nothing for a Future<void>. May return
+			 *  a value, nothing or another Future, which is then waited for.
+			 *  Its captures must fit in a task_t, next to a Promise.
+			 *  @returns  A Future of the result of fn. An exception of this
+			 *  Future or of fn skips fn and is passed on.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1), pooled
+			 */
+			template <typename Callable>
+			auto then(Callable&& fn)
+			{
+				using U = typename unwrap_future<
+					continuation_result_t<T, std::decay_t<Callable>>>::type;
+
+				Promise<U> next;
+				Future<U> result = next.get_future();
+
+				take_state()->on_ready([
+					fn = std::forward<Callable>(fn),
+					next = std::move(next)
+				](FutureState<T> *ready) mutable {
+					continue_with(ready, fn, next);
+				});
+
+				return result;
+			}
+
+			/**
+			 *  @brief  Chains a function that runs on an executor, e.g. a
+			 *  ThreadPool for CPU work or the SocketServer whose Sockets the
+			 *  function writes to. It runs inline if the Future becomes ready
+			 *  on a thread of the executor.
+			 *  @param  executor  The executor, must outlive the Future.
+			 *  @param  fn  Like the function of then(Callable&&).
+			 *  @returns  A Future of the result of fn.
+			 */
+			template <FutureExecutor Executor, typename Callable>
+			auto then(Executor& executor, Callable&& fn)
+			{
+				using U = typename unwrap_future<
+					continuation_result_t<T, std::decay_t<Callable>>>::type;
+
+				Promise<U> next;
+				Future<U> result = next.get_future();
+
+				take_state()->on_ready([
+					executor = &executor,
+					fn = std::forward<Callable>(fn),
+					next = std::move(next)
+				](FutureState<T> *ready) mutable {
+					if (executor->runs_on_current_thread()) {
+						continue_with(ready, fn, next);
+						return;
+					}
+
+					execute_on(*executor, [
+						ready = IntrusivePointer<FutureState<T>>(ready),
+						fn = std::move(fn),
+						next = std::move(next)
+					]() mutable {
+						continue_with(ready.get(), fn, next);
+					});
+				});
+
+				return result;
+			}
+	};
+
+	/**
+	 *  @brief  Returns a Future that is ready with a value.
+	 */
+	template <typename T, typename... Args>
+	Future<T> make_ready_future(Args&&... args)
+	{
+		Promise<T> promise;
+		Future<T> future = promise.get_future();
+		promise.set_value(std::forward<Args>(args)...);
+
+		return future;
+	}
+};
+
+namespace flow_future_tools {
+	template <typename T>
+	using when_all_t = std::conditional_t<std::is_void_v<T>, void, flow::DynamicArray<T>>;
+
+	template <typename T>
+	using when_any_t = std::conditional_t<std::is_void_v<T>, size_t, flow::WhenAnyResult<T>>;
+
+	/**
+	 *  @brief  The state of a when_all(), shared by the continuations
+	 *  of its Futures.
+	 */
+	template <typename T>
+	struct WhenAllState : public PooledState {
+		flow::DynamicArray<stored_t<T>> values;
+		std::atomic<size_t> remaining;
+		std::atomic<bool> failed = false;
+		flow::Promise<when_all_t<T>> promise;
+
+		WhenAllState(size_t count) : values(std::max(count, (size_t) 1)), remaining(count)
+		{
+			for (size_t i = 0; i < count; i++) values.append(stored_t<T>());
+		}
+	};
+
+	/**
+	 *  @brief  The state of a when_any(), shared by the continuations
+	 *  of its Futures.
+	 */
+	template <typename T>
+	struct WhenAnyState : public PooledState {
+		std::atomic<bool> done = false;
+		flow::Promise<when_any_t<T>> promise;
+	};
+};
+
+namespace flow {
+	/**
+	 *  @brief  Waits for all Futures of an array.
+	 *  @param  futures  The Futures, they are consumed.
+	 *  @returns  A Future of the values, in the order of the Futures, or of
+	 *  nothing if T is void. It gets the first exception of the Futures.
+	 *  @note  Runtime: O(n), n = futures.size()
+	 *  @note  Memory: O(n), n = futures.size()
+	 */
+	template <typename T>
+	Future<when_all_t<T>> when_all(DynamicArray<Future<T>>& futures)
+	{
+		size_t count = futures.size();
+
+		// The values are written by the threads that satisfy the Futures,
+		// so they must not grow on an Arena of this thread
+
+		ArenaScope heap_scope(NULL);
+
+		IntrusivePointer<WhenAllState<T>> all(new WhenAllState<T>(count));
+		Future<when_all_t<T>> result = all->promise.get_future();
+
+		if (count == 0) {
+			if constexpr (std::is_void_v<T>) all->promise.set_value();
+			else all->promise.set_value(DynamicArray<T>());
+
+			return result;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			FutureAccess::take_state(futures[i])->on_ready([all, i]
+				(FutureState<T> *ready)
+			{
+				if (ready->get_exception()) {
+					if (!all->failed.exchange(true, std::memory_order_acq_rel)) {
+						all->promise.set_exception(ready->get_exception());
+					}
+				} else if constexpr (!std::is_void_v<T>) {
+					all->values[i] = std::move(ready->value());
+				}
+
+				if (all->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+				if (all->failed.load(std::memory_order_relaxed)) return;
+
+				if constexpr (std::is_void_v<T>) all->promise.set_value();
+				else all->promise.set_value(std::move(all->values));
+			});
+		}
+
+		return result;
+	}
+
+	/**
+	 *  @brief  Waits for the first Future of an array to become ready.
+	 *  @param  futures  The Futures, they are consumed. Must not be empty.
+	 *  @returns  A Future of the index and value of the first ready Future,
+	 *  or of only the index if T is void. It gets the exception of the
+	 *  first ready Future, if it has one.
+	 *  @note  Runtime: O(n), n = futures.size()
+	 *  @note  Memory: O(n), n = futures.size()
+	 */
+	template <typename T>
+	Future<when_any_t<T>> when_any(DynamicArray<Future<T>>& futures)
+	{
+		if (futures.size() == 0) throw FutureErrors::NO_FUTURES;
+
+		IntrusivePointer<WhenAnyState<T>> any(new WhenAnyState<T>());
+		Future<when_any_t<T>> result = any->promise.get_future();
+
+		for (size_t i = 0; i < futures.size(); i++) {
+			FutureAccess::take_state(futures[i])->on_ready([any, i]
+				(FutureState<T> *ready)
+			{
+				if (any->done.exchange(true, std::memory_order_acq_rel)) return;
+
+				if (ready->get_exception()) {
+					any->promise.set_exception(ready->get_exception());
+				} else if constexpr (std::is_void_v<T>) {
+					any->promise.set_value(i);
+				} else {
+					any->promise.set_value(WhenAnyResult<T> { i, std::move(ready->value()) });
+				}
+			});
+		}
+
+		return result;
+	}
+};
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef FLOW_MPMC_QUEUE_HEADER
+#define FLOW_MPMC_QUEUE_HEADER
+
+#include <bits/stdc++.h>
+
+#include "futex.hpp"
+#include "../memory/arena.hpp"
+
+namespace flow_mpmc_queue_tools {
+	/**
+	 *  @brief  A slot of an MPMCQueue. The sequence number tells which
+	 *  lap of the ring the slot is ready for: when it equals the position
+	 *  of a producer the slot is free, when it equals the position of a
+	 *  consumer plus one the slot holds a value.
+	 */
+	template <typename type>
+	struct MPMCQueueCell {
+		std::atomic<size_t> sequence;
+		alignas(type) unsigned char storage[sizeof(type)];
+
+		type *value()
+		{
+			return reinterpret_cast<type *>(storage);
+		}
+	};
+};
+
+namespace flow {
+	using namespace flow_mpmc_queue_tools;
+
+	/**
+	 *  @brief  A bounded, lock-free queue for any number of producer and
+	 *  consumer threads, after Dmitry Vyukov's design. Producers and
+	 *  consumers claim a position with a single compare-and-swap, and
+	 *  synchronise with each other through a sequence number per slot.
+	 *  @tparam  type  The type of the elements.
+	 *  @tparam  blocking  Enables push() and pop(), which sleep on a futex
+	 *  while the queue is full or empty. This adds a fence to every
+	 *  operation, so it is off by default.
+	 */
+	template <typename type, bool blocking = false>
+	class MPMCQueue {
+		private:
+			MPMCQueueCell<type> *cells;
+			size_t mask;
+
+			std::allocator<MPMCQueueCell<type>> allocator;
+
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos = 0;
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos = 0;
+
+			alignas(CACHE_LINE_SIZE) EventCount not_empty;
+			EventCount not_full;
+
+			template <typename value_type>
+			bool emplace_back(value_type&& value)
+			{
+				size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+				MPMCQueueCell<type> *cell;
+
+				while (true) {
+					cell = cells + (pos & mask);
+					size_t sequence = cell->sequence.load(std::memory_order_acquire);
+					intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+
+					if (diff == 0) {
+						if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+							std::memory_order_relaxed)) break;
+					} else if (diff < 0) {
+						// The slot still holds a value from the previous lap
+
+						return false;
+					} else {
+						pos = enqueue_pos.load(std::memory_order_relaxed);
+					}
+				}
+
+				// Values are handed to another thread, keep them off its Arena
+
+				ArenaScope heap_scope(NULL);
+				new (cell->value()) type(std::forward<value_type>(value));
+				cell->sequence.store(pos + 1, std::memory_order_release);
+
+				if constexpr (blocking) not_empty.notify(1);
+				return true;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an MPMCQueue.
+			 *  @param  capacity  The maximum number of elements, rounded up
+			 *  to a power of 2.
+			 */
+			MPMCQueue(size_t capacity)
+			{
+				size_t size = std::bit_ceil(std::max(capacity, (size_t) 2));
+
+				cells = allocator.allocate(size);
+				mask = size - 1;
+
+				for (size_t i = 0; i < size; i++) {
+					new (&cells[i].sequence) std::atomic<size_t>(i);
+				}
+			}
+
+			MPMCQueue(const MPMCQueue<type, blocking>& other) = delete;
+			MPMCQueue<type, blocking>& operator=(
+				const MPMCQueue<type, blocking>& other) = delete;
+
+			/**
+			 *  @brief  Deletes all elements on this MPMCQueue.
+			 *  No thread may use the queue anymore.
+			 */
+			~MPMCQueue()
+			{
+				size_t end = enqueue_pos.load(std::memory_order_acquire);
+
+				for (size_t pos = dequeue_pos.load(std::memory_order_acquire);
+					pos != end; pos++) {
+					cells[pos & mask].value()->~type();
+				}
+
+				allocator.deallocate(cells, mask + 1);
+			}
+
+			/**
+			 *  @brief  Returns the maximum number of elements.
+			 */
+			size_t capacity() const
+			{
+				return mask + 1;
+			}
+
+			/**
+			 *  @brief  Returns the number of elements. Only exact when called
+			 *  while no other thread uses the queue.
+			 */
+			size_t size_approx() const
+			{
+				size_t end = enqueue_pos.load(std::memory_order_acquire);
+				size_t start = dequeue_pos.load(std::memory_order_acquire);
+
+				return end > start ? end - start : 0;
+			}
+
+			/**
+			 *  @brief  Places a value at the end of the queue.
+			 *  @param  value  The value to push.
+			 *  @returns  False if the queue is full, true otherwise.
+			 *  @note  Runtime: O(1), lock-free
+			 *  @note  Memory: O(1)
+			 */
+			bool try_push(const type& value)
+			{
+				return emplace_back(value);
+			}
+
+			/**
+			 *  @brief  Places a value at the end of the queue.
+			 *  @param  value  The value to push. It is only moved from if
+			 *  the push succeeds.
+			 *  @returns  False if the queue is full, true otherwise.
+			 *  @note  Runtime: O(1), lock-free
+			 *  @note  Memory: O(1)
+			 */
+			bool try_push(type&& value)
+			{
+				return emplace_back(std::move(value));
+			}
+
+			/**
+			 *  @brief  Places values at the end of the queue until all values
+			 *  are pushed or the queue is full. Values of other producers may
+			 *  be interleaved.
+			 *  @param  values  The values to push, they are moved from.
+			 *  @param  count  The number of values.
+			 *  @returns  The number of values that were pushed.
+			 *  @note  Runtime: O(n), n = count
+			 *  @note  Memory: O(1)
+			 */
+			size_t try_push_batch(type *values, size_t count)
+			{
+				size_t pushed = 0;
+
+				while (pushed < count && emplace_back(std::move(values[pushed]))) {
+					pushed++;
+				}
+
+				return pushed;
+			}
+
+			/**
+			 *  @brief  Removes the first element of the queue.
+			 *  @param  value  Where the element is moved to.
+			 *  @returns  False if the queue is empty, true otherwise.
+			 *  @note  Runtime: O(1), lock-free
+			 *  @note  Memory: O(1)
+			 */
+			bool try_pop(type& value)
+			{
+				size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+				MPMCQueueCell<type> *cell;
+
+				while (true) {
+					cell = cells + (pos & mask);
+					size_t sequence = cell->sequence.load(std::memory_order_acquire);
+					intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+
+					if (diff == 0) {
+						if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+							std::memory_order_relaxed)) break;
+					} else if (diff < 0) {
+						// The slot has not been filled yet
+
+						return false;
+					} else {
+						pos = dequeue_pos.load(std::memory_order_relaxed);
+					}
+				}
+
+				value = std::move(*cell->value());
+				cell->value()->~type();
+				cell->sequence.store(pos + mask + 1, std::memory_order_release);
+
+				if constexpr (blocking) not_full.notify(1);
+				return true;
+			}
+
+			/**
+			 *  @brief  Removes elements from the front of the queue until
+			 *  a given number is removed or the queue is empty.
+			 *  @param  values  Where the elements are moved to.
+			 *  @param  max_count  The maximum number of elements to remove.
+			 *  @returns  The number of elements that were removed.
+			 *  @note  Runtime: O(n), n = max_count
+			 *  @note  Memory: O(1)
+			 */
+			size_t try_pop_batch(type *values, size_t max_count)
+			{
+				size_t popped = 0;
+
+				while (popped < max_count && try_pop(values[popped])) {
+					popped++;
+				}
+
+				return popped;
+			}
+
+			/**
+			 *  @brief  Places a value at the end of the queue, sleeps while
+			 *  the queue is full.
+			 *  @param  value  The value to push.
+			 */
+			template <typename value_type>
+			void push(value_type&& value)
+			{
+				static_assert(blocking, "MPMCQueue::push() needs blocking = true");
+
+				while (!emplace_back(std::forward<value_type>(value))) {
+					uint32_t key = not_full.prepare_wait();
+
+					if (emplace_back(std::forward<value_type>(value))) {
+						not_full.cancel_wait();
+						return;
+					}
+
+					not_full.wait(key);
+				}
+			}
+
+			/**
+			 *  @brief  Removes the first element of the queue and returns it,
+			 *  sleeps while the queue is empty.
+			 */
+			type pop()
+			{
+				static_assert(blocking, "MPMCQueue::pop() needs blocking = true");
+
+				type value;
+
+				while (!try_pop(value)) {
+					uint32_t key = not_empty.prepare_wait();
+
+					if (try_pop(value)) {
+						not_empty.cancel_wait();
+						break;
+					}
+
+					not_empty.wait(key);
+				}
+
+				return value;
+			}
+	};
+};
+
+#endif
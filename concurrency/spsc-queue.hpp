@@ -0,0 +1,304 @@
+#ifndef FLOW_SPSC_QUEUE_HEADER
+#define FLOW_SPSC_QUEUE_HEADER
+
+#include <bits/stdc++.h>
+
+#include "futex.hpp"
+#include "../memory/arena.hpp"
+
+namespace flow {
+	/**
+	 *  @brief  A bounded, wait-free queue for exactly one producer thread
+	 *  and one consumer thread. The producer and consumer positions live on
+	 *  separate cache lines, and each side caches the position of the other
+	 *  side so it only reads the shared one when the queue looks full or empty.
+	 *  @tparam  type  The type of the elements.
+	 *  @tparam  blocking  Enables push() and pop(), which sleep on a futex
+	 *  while the queue is full or empty. This adds a fence to every
+	 *  operation, so it is off by default.
+	 */
+	template <typename type, bool blocking = false>
+	class SPSCQueue {
+		private:
+			type *buffer;
+			size_t mask;
+
+			std::allocator<type> allocator;
+
+			// Written by the producer
+
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail = 0;
+			size_t cached_head = 0;
+
+			// Written by the consumer
+
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> head = 0;
+			size_t cached_tail = 0;
+
+			alignas(CACHE_LINE_SIZE) EventCount not_empty;
+			EventCount not_full;
+
+			void notify_not_empty()
+			{
+				if constexpr (blocking) not_empty.notify();
+			}
+
+			void notify_not_full()
+			{
+				if constexpr (blocking) not_full.notify();
+			}
+
+			/**
+			 *  @brief  Returns the number of free slots, as seen by the producer.
+			 *  The position of the consumer is only reloaded if less than the
+			 *  wanted number of slots seem to be free.
+			 */
+			size_t free_slots(size_t t, size_t wanted = 1)
+			{
+				size_t free = mask + 1 - (t - cached_head);
+
+				if (free < wanted) {
+					cached_head = head.load(std::memory_order_acquire);
+					free = mask + 1 - (t - cached_head);
+				}
+
+				return free;
+			}
+
+			/**
+			 *  @brief  Returns the number of filled slots, as seen by the consumer.
+			 *  The position of the producer is only reloaded if less than the
+			 *  wanted number of slots seem to be filled.
+			 */
+			size_t filled_slots(size_t h, size_t wanted = 1)
+			{
+				if (cached_tail - h < wanted) {
+					cached_tail = tail.load(std::memory_order_acquire);
+				}
+
+				return cached_tail - h;
+			}
+
+			template <typename value_type>
+			bool emplace_back(value_type&& value)
+			{
+				size_t t = tail.load(std::memory_order_relaxed);
+				if (free_slots(t) == 0) return false;
+
+				// Values are handed to another thread, keep them off its Arena
+
+				ArenaScope heap_scope(NULL);
+				new (buffer + (t & mask)) type(std::forward<value_type>(value));
+				tail.store(t + 1, std::memory_order_release);
+
+				notify_not_empty();
+				return true;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an SPSCQueue.
+			 *  @param  capacity  The maximum number of elements, rounded up
+			 *  to a power of 2.
+			 */
+			SPSCQueue(size_t capacity)
+			{
+				size_t size = std::bit_ceil(std::max(capacity, (size_t) 2));
+
+				buffer = allocator.allocate(size);
+				mask = size - 1;
+			}
+
+			SPSCQueue(const SPSCQueue<type, blocking>& other) = delete;
+			SPSCQueue<type, blocking>& operator=(
+				const SPSCQueue<type, blocking>& other) = delete;
+
+			/**
+			 *  @brief  Deletes all elements on this SPSCQueue.
+			 *  No thread may use the queue anymore.
+			 */
+			~SPSCQueue()
+			{
+				size_t t = tail.load(std::memory_order_acquire);
+
+				for (size_t h = head.load(std::memory_order_acquire); h != t; h++) {
+					buffer[h & mask].~type();
+				}
+
+				allocator.deallocate(buffer, mask + 1);
+			}
+
+			/**
+			 *  @brief  Returns the maximum number of elements.
+			 */
+			size_t capacity() const
+			{
+				return mask + 1;
+			}
+
+			/**
+			 *  @brief  Returns the number of elements. Only exact when called
+			 *  while neither side is active.
+			 */
+			size_t size_approx() const
+			{
+				return tail.load(std::memory_order_acquire)
+					- head.load(std::memory_order_acquire);
+			}
+
+			/**
+			 *  @brief  Places a value at the end of the queue.
+			 *  May only be called by the producer.
+			 *  @param  value  The value to push.
+			 *  @returns  False if the queue is full, true otherwise.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			bool try_push(const type& value)
+			{
+				return emplace_back(value);
+			}
+
+			/**
+			 *  @brief  Places a value at the end of the queue.
+			 *  May only be called by the producer.
+			 *  @param  value  The value to push. It is only moved from if
+			 *  the push succeeds.
+			 *  @returns  False if the queue is full, true otherwise.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			bool try_push(type&& value)
+			{
+				return emplace_back(std::move(value));
+			}
+
+			/**
+			 *  @brief  Places as many values as fit at the end of the queue,
+			 *  and publishes them to the consumer at once.
+			 *  May only be called by the producer.
+			 *  @param  values  The values to push, they are moved from.
+			 *  @param  count  The number of values.
+			 *  @returns  The number of values that were pushed.
+			 *  @note  Runtime: O(n), n = count
+			 *  @note  Memory: O(1)
+			 */
+			size_t try_push_batch(type *values, size_t count)
+			{
+				size_t t = tail.load(std::memory_order_relaxed);
+				size_t pushed = std::min(count, free_slots(t, count));
+				ArenaScope heap_scope(NULL);
+
+				for (size_t i = 0; i < pushed; i++) {
+					new (buffer + ((t + i) & mask)) type(std::move(values[i]));
+				}
+
+				if (pushed == 0) return 0;
+
+				tail.store(t + pushed, std::memory_order_release);
+				notify_not_empty();
+
+				return pushed;
+			}
+
+			/**
+			 *  @brief  Removes the first element of the queue.
+			 *  May only be called by the consumer.
+			 *  @param  value  Where the element is moved to.
+			 *  @returns  False if the queue is empty, true otherwise.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			bool try_pop(type& value)
+			{
+				size_t h = head.load(std::memory_order_relaxed);
+				if (filled_slots(h) == 0) return false;
+
+				type *slot = buffer + (h & mask);
+				value = std::move(*slot);
+				slot->~type();
+
+				head.store(h + 1, std::memory_order_release);
+				notify_not_full();
+
+				return true;
+			}
+
+			/**
+			 *  @brief  Removes up to a given number of elements from the front
+			 *  of the queue, and releases their slots to the producer at once.
+			 *  May only be called by the consumer.
+			 *  @param  values  Where the elements are moved to.
+			 *  @param  max_count  The maximum number of elements to remove.
+			 *  @returns  The number of elements that were removed.
+			 *  @note  Runtime: O(n), n = max_count
+			 *  @note  Memory: O(1)
+			 */
+			size_t try_pop_batch(type *values, size_t max_count)
+			{
+				size_t h = head.load(std::memory_order_relaxed);
+				size_t popped = std::min(max_count, filled_slots(h, max_count));
+
+				for (size_t i = 0; i < popped; i++) {
+					type *slot = buffer + ((h + i) & mask);
+					values[i] = std::move(*slot);
+					slot->~type();
+				}
+
+				if (popped == 0) return 0;
+
+				head.store(h + popped, std::memory_order_release);
+				notify_not_full();
+
+				return popped;
+			}
+
+			/**
+			 *  @brief  Places a value at the end of the queue, sleeps while
+			 *  the queue is full. May only be called by the producer.
+			 *  @param  value  The value to push.
+			 */
+			template <typename value_type>
+			void push(value_type&& value)
+			{
+				static_assert(blocking, "SPSCQueue::push() needs blocking = true");
+
+				while (!emplace_back(std::forward<value_type>(value))) {
+					uint32_t key = not_full.prepare_wait();
+
+					if (emplace_back(std::forward<value_type>(value))) {
+						not_full.cancel_wait();
+						return;
+					}
+
+					not_full.wait(key);
+				}
+			}
+
+			/**
+			 *  @brief  Removes the first element of the queue and returns it,
+			 *  sleeps while the queue is empty. May only be called by the consumer.
+			 */
+			type pop()
+			{
+				static_assert(blocking, "SPSCQueue::pop() needs blocking = true");
+
+				type value;
+
+				while (!try_pop(value)) {
+					uint32_t key = not_empty.prepare_wait();
+
+					if (try_pop(value)) {
+						not_empty.cancel_wait();
+						break;
+					}
+
+					not_empty.wait(key);
+				}
+
+				return value;
+			}
+	};
+};
+
+#endif
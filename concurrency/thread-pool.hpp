@@ -0,0 +1,388 @@
+#ifndef FLOW_THREAD_POOL_HEADER
+#define FLOW_THREAD_POOL_HEADER
+
+#include <bits/stdc++.h>
+
+#include "futex.hpp"
+#include "work-stealing-deque.hpp"
+#include "../data-structures/queue.hpp"
+#include "../events/inplace-function.hpp"
+
+// Inline storage of a task, captures must fit in it
+
+#ifndef FLOW_TASK_SIZE
+#define FLOW_TASK_SIZE (size_t) (16 * sizeof(void *))
+#endif
+
+namespace flow {
+	class ThreadPool;
+	class TaskGroup;
+
+	typedef InplaceFunction<void(), FLOW_TASK_SIZE> task_t;
+};
+
+namespace flow_thread_pool_tools {
+	using namespace flow_futex_tools;
+
+	struct ThreadPoolTask {
+		flow::task_t fn;
+		flow::TaskGroup *group;
+	};
+
+	/**
+	 *  @brief  A worker thread of a ThreadPool and its deque of tasks.
+	 */
+	struct alignas(CACHE_LINE_SIZE) ThreadPoolWorker {
+		flow::ThreadPool *pool;
+		flow::WorkStealingDeque<ThreadPoolTask *> deque;
+		std::thread thread;
+
+		// State of the xorshift generator that picks victims to steal from
+
+		uint64_t rng;
+
+		size_t next_victim(size_t worker_count)
+		{
+			rng ^= rng << 13;
+			rng ^= rng >> 7;
+			rng ^= rng << 17;
+			return rng % worker_count;
+		}
+	};
+
+	// The worker the current thread runs, NULL outside of ThreadPools
+
+	inline thread_local ThreadPoolWorker *current_worker = NULL;
+};
+
+namespace flow {
+	using namespace flow_thread_pool_tools;
+
+	/**
+	 *  @brief  A work stealing thread pool. Every worker has a Chase-Lev
+	 *  deque: tasks submitted from a worker go on its own deque and are run
+	 *  newest first, idle workers steal the oldest task of a random other
+	 *  worker. Tasks submitted from other threads go on a shared queue.
+	 *  Workers without work sleep on a futex and are woken when a task
+	 *  is submitted.
+	 */
+	class ThreadPool {
+		private:
+			ThreadPoolWorker *workers;
+			size_t worker_count;
+
+			// Tasks submitted from outside the ThreadPool
+
+			std::mutex injector_mutex;
+			Queue<ThreadPoolTask *> injector;
+			std::atomic<size_t> injector_size = 0;
+
+			EventCount work_available;
+			std::atomic<bool> stopping = false;
+
+			friend class TaskGroup;
+
+			bool is_own_worker(ThreadPoolWorker *worker) const
+			{
+				return worker != NULL && worker->pool == this;
+			}
+
+			void enqueue(ThreadPoolTask *task)
+			{
+				if (is_own_worker(current_worker)) {
+					current_worker->deque.push(task);
+				} else {
+					std::lock_guard<std::mutex> lock(injector_mutex);
+					injector.push(task);
+					injector_size.fetch_add(1, std::memory_order_release);
+				}
+
+				work_available.notify(1);
+			}
+
+			bool take_injected(ThreadPoolTask *& task)
+			{
+				if (injector_size.load(std::memory_order_acquire) == 0) return false;
+
+				std::lock_guard<std::mutex> lock(injector_mutex);
+				if (injector.size() == 0) return false;
+
+				task = injector.pop();
+				injector_size.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+
+			/**
+			 *  @brief  Finds a task for the current thread: from its own deque,
+			 *  then from the shared queue, then from a random worker.
+			 */
+			bool find_task(ThreadPoolTask *& task)
+			{
+				ThreadPoolWorker *self = is_own_worker(current_worker)
+					? current_worker : NULL;
+
+				if (self != NULL && self->deque.pop(task)) return true;
+				if (take_injected(task)) return true;
+
+				size_t start = self != NULL
+					? self->next_victim(worker_count)
+					: std::hash<std::thread::id>()(std::this_thread::get_id()) % worker_count;
+
+				for (size_t i = 0; i < worker_count; i++) {
+					ThreadPoolWorker& victim = workers[(start + i) % worker_count];
+					if (&victim != self && victim.deque.steal(task)) return true;
+				}
+
+				return false;
+			}
+
+			bool has_work() const
+			{
+				if (injector_size.load(std::memory_order_acquire) != 0) return true;
+
+				for (size_t i = 0; i < worker_count; i++) {
+					if (workers[i].deque.size_approx() != 0) return true;
+				}
+
+				return false;
+			}
+
+			void run(ThreadPoolTask *task);
+
+			void work(ThreadPoolWorker *self)
+			{
+				current_worker = self;
+				ThreadPoolTask *task;
+
+				while (true) {
+					if (find_task(task)) {
+						run(task);
+						continue;
+					}
+
+					// Sleep until a task is submitted, checking for work again
+					// after registering, so a notify in between is not missed
+
+					uint32_t key = work_available.prepare_wait();
+
+					if (has_work()) {
+						work_available.cancel_wait();
+						continue;
+					}
+
+					if (stopping.load(std::memory_order_acquire)) {
+						work_available.cancel_wait();
+						break;
+					}
+
+					work_available.wait(key);
+				}
+
+				current_worker = NULL;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates a ThreadPool and starts its workers.
+			 *  @param  thread_count  The number of workers, defaults to the
+			 *  number of hardware threads.
+			 */
+			ThreadPool(size_t thread_count = std::thread::hardware_concurrency())
+			{
+				worker_count = std::max(thread_count, (size_t) 1);
+				workers = new ThreadPoolWorker[worker_count];
+
+				for (size_t i = 0; i < worker_count; i++) {
+					workers[i].pool = this;
+					workers[i].rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+				}
+
+				for (size_t i = 0; i < worker_count; i++) {
+					workers[i].thread = std::thread([this, i]() { work(&workers[i]); });
+				}
+			}
+
+			ThreadPool(const ThreadPool& other) = delete;
+			ThreadPool& operator=(const ThreadPool& other) = delete;
+
+			/**
+			 *  @brief  Runs all submitted tasks, then stops the workers.
+			 */
+			~ThreadPool()
+			{
+				stopping.store(true, std::memory_order_release);
+				work_available.notify();
+
+				for (size_t i = 0; i < worker_count; i++) workers[i].thread.join();
+
+				delete[] workers;
+			}
+
+			/**
+			 *  @brief  Returns the number of workers.
+			 */
+			size_t size() const
+			{
+				return worker_count;
+			}
+
+			/**
+			 *  @brief  Returns whether the calling thread is a worker of
+			 *  this ThreadPool.
+			 */
+			bool runs_on_current_thread() const
+			{
+				return is_own_worker(current_worker);
+			}
+
+			/**
+			 *  @brief  Runs a function on a worker.
+			 *  @param  fn  The function to run, its captures must fit in a task_t.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1)
+			 */
+			void submit(task_t&& fn)
+			{
+				enqueue(new ThreadPoolTask { std::move(fn), NULL });
+			}
+
+			/**
+			 *  @brief  Runs a single pending task on the calling thread.
+			 *  @returns  Whether a task was run.
+			 */
+			bool run_one()
+			{
+				ThreadPoolTask *task;
+				if (!find_task(task)) return false;
+
+				run(task);
+				return true;
+			}
+
+			/**
+			 *  @brief  Calls a function for every index of a range, split over
+			 *  the workers, and returns once all calls returned. The calling
+			 *  thread helps running the calls.
+			 *  @param  begin  The first index.
+			 *  @param  end  One past the last index.
+			 *  @param  fn  The function to call with each index.
+			 *  @param  grain_size  The number of indices per task, chosen
+			 *  from the number of workers if 0.
+			 */
+			template <typename Callable>
+			void parallel_for(size_t begin, size_t end, Callable&& fn,
+				size_t grain_size = 0);
+	};
+
+	/**
+	 *  @brief  A set of tasks that can be waited for together.
+	 *  A TaskGroup must not be destroyed before wait() returned.
+	 */
+	class TaskGroup {
+		private:
+			ThreadPool& pool;
+
+			// Unfinished tasks, plus one that is dropped by wait(), so the
+			// last task only finishes the group if wait() was called
+
+			std::atomic<size_t> pending = 1;
+
+			// Set to FINISHING by the last task before it wakes wait(), and
+			// to FINISHED once it is done with the TaskGroup. wait() only
+			// returns on FINISHED, the TaskGroup may be gone right after
+
+			static constexpr uint32_t RUNNING = 0;
+			static constexpr uint32_t FINISHING = 1;
+			static constexpr uint32_t FINISHED = 2;
+
+			std::atomic<uint32_t> finished = RUNNING;
+
+			friend class ThreadPool;
+
+			void finish_one()
+			{
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+				finished.store(FINISHING, std::memory_order_release);
+				futex_wake(finished);
+				finished.store(FINISHED, std::memory_order_release);
+			}
+
+		public:
+			TaskGroup(ThreadPool& pool) : pool(pool) {}
+
+			TaskGroup(const TaskGroup& other) = delete;
+			TaskGroup& operator=(const TaskGroup& other) = delete;
+
+			/**
+			 *  @brief  Runs a function on a worker as part of this TaskGroup.
+			 *  @param  fn  The function to run, its captures must fit in a task_t.
+			 */
+			void run(task_t&& fn)
+			{
+				pending.fetch_add(1, std::memory_order_relaxed);
+				pool.enqueue(new ThreadPoolTask { std::move(fn), this });
+			}
+
+			/**
+			 *  @brief  Returns once all tasks of this TaskGroup finished.
+			 *  The calling thread runs pending tasks while it waits, so a
+			 *  worker can wait for the tasks it spawned.
+			 */
+			void wait()
+			{
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+					while (finished.load(std::memory_order_acquire) == RUNNING) {
+						if (pool.run_one()) continue;
+						futex_wait(finished, RUNNING);
+					}
+
+					// The last task is between its wake and its final store
+
+					while (finished.load(std::memory_order_acquire) != FINISHED) {
+						std::this_thread::yield();
+					}
+				}
+
+				// Ready to be reused
+
+				finished.store(RUNNING, std::memory_order_relaxed);
+				pending.store(1, std::memory_order_relaxed);
+			}
+	};
+
+	inline void ThreadPool::run(ThreadPoolTask *task)
+	{
+		TaskGroup *group = task->group;
+
+		task->fn();
+		delete task;
+
+		if (group != NULL) group->finish_one();
+	}
+
+	template <typename Callable>
+	void ThreadPool::parallel_for(size_t begin, size_t end, Callable&& fn,
+		size_t grain_size)
+	{
+		if (begin >= end) return;
+
+		if (grain_size == 0) {
+			grain_size = std::max((end - begin) / (worker_count * 4), (size_t) 1);
+		}
+
+		TaskGroup group(*this);
+
+		for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain_size) {
+			size_t chunk_end = std::min(chunk_begin + grain_size, end);
+
+			group.run([&fn, chunk_begin, chunk_end]() {
+				for (size_t i = chunk_begin; i < chunk_end; i++) fn(i);
+			});
+		}
+
+		group.wait();
+	}
+};
+
+#endif
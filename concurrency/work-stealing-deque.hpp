@@ -0,0 +1,206 @@
+#ifndef FLOW_WORK_STEALING_DEQUE_HEADER
+#define FLOW_WORK_STEALING_DEQUE_HEADER
+
+#include <bits/stdc++.h>
+
+#include "futex.hpp"
+
+namespace flow_work_stealing_deque_tools {
+	/**
+	 *  @brief  The ring buffer of a WorkStealingDeque. Elements are atomic,
+	 *  because a thief may read a slot while the owner overwrites it after
+	 *  the thief lost the race for it.
+	 */
+	template <typename type>
+	struct WorkStealingArray {
+		int64_t mask;
+		std::atomic<type> *slots;
+
+		// The array this one replaced, freed together with the deque
+
+		WorkStealingArray<type> *previous;
+
+		WorkStealingArray(int64_t size, WorkStealingArray<type> *previous)
+			: mask(size - 1), slots(new std::atomic<type>[size]), previous(previous) {}
+
+		~WorkStealingArray()
+		{
+			delete[] slots;
+		}
+
+		int64_t size() const
+		{
+			return mask + 1;
+		}
+
+		type get(int64_t i) const
+		{
+			return slots[i & mask].load(std::memory_order_relaxed);
+		}
+
+		void put(int64_t i, type value)
+		{
+			slots[i & mask].store(value, std::memory_order_relaxed);
+		}
+	};
+};
+
+namespace flow {
+	using namespace flow_work_stealing_deque_tools;
+
+	/**
+	 *  @brief  A Chase-Lev work stealing deque. The owning thread pushes and
+	 *  pops at the bottom without contention, other threads steal from the
+	 *  top. Owner and thieves only race for the last element.
+	 *  The ring buffer grows when it is full. Replaced buffers may still be
+	 *  read by a thief, so they are kept until the deque is destroyed, which
+	 *  costs less than the final buffer in total.
+	 *  @tparam  type  The type of the elements, must be trivially copyable,
+	 *  usually a pointer to a task.
+	 */
+	template <typename type>
+	class WorkStealingDeque {
+		static_assert(std::is_trivially_copyable_v<type>,
+			"WorkStealingDeque only holds trivially copyable elements");
+
+		private:
+			alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top = 0;
+			alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom = 0;
+			std::atomic<WorkStealingArray<type> *> array;
+
+			WorkStealingArray<type> *grow(WorkStealingArray<type> *old_array,
+				int64_t t, int64_t b)
+			{
+				WorkStealingArray<type> *new_array
+					= new WorkStealingArray<type>(old_array->size() * 2, old_array);
+
+				for (int64_t i = t; i < b; i++) new_array->put(i, old_array->get(i));
+
+				array.store(new_array, std::memory_order_release);
+				return new_array;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates a WorkStealingDeque.
+			 *  @param  capacity  The initial capacity, rounded up to a power of 2.
+			 */
+			WorkStealingDeque(size_t capacity = 256)
+			{
+				array.store(new WorkStealingArray<type>(
+					std::bit_ceil(std::max(capacity, (size_t) 2)), NULL),
+					std::memory_order_relaxed);
+			}
+
+			WorkStealingDeque(const WorkStealingDeque& other) = delete;
+			WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+			/**
+			 *  @brief  Frees all buffers. No thread may use the deque anymore.
+			 */
+			~WorkStealingDeque()
+			{
+				WorkStealingArray<type> *a = array.load(std::memory_order_relaxed);
+
+				while (a != NULL) {
+					WorkStealingArray<type> *previous = a->previous;
+					delete a;
+					a = previous;
+				}
+			}
+
+			/**
+			 *  @brief  Returns the number of elements. Only exact when called
+			 *  by the owner while no thief is active.
+			 */
+			size_t size_approx() const
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_relaxed);
+
+				return b > t ? b - t : 0;
+			}
+
+			/**
+			 *  @brief  Places a value at the bottom. Only the owner may push.
+			 *  @note  Runtime: O(1) amortised, wait-free
+			 *  @note  Memory: O(1) amortised
+			 */
+			void push(type value)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_acquire);
+				WorkStealingArray<type> *a = array.load(std::memory_order_relaxed);
+
+				if (b - t > a->mask) a = grow(a, t, b);
+
+				// Publishes the value to thieves, which load bottom with acquire
+
+				a->put(b, value);
+				bottom.store(b + 1, std::memory_order_release);
+			}
+
+			/**
+			 *  @brief  Removes the value at the bottom, the one pushed last.
+			 *  Only the owner may pop.
+			 *  @param  value  Where the value is stored.
+			 *  @returns  False if the deque is empty, true otherwise.
+			 *  @note  Runtime: O(1), wait-free
+			 *  @note  Memory: O(1)
+			 */
+			bool pop(type& value)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				WorkStealingArray<type> *a = array.load(std::memory_order_relaxed);
+
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+
+				if (t > b) {
+					bottom.store(b + 1, std::memory_order_relaxed);
+					return false;
+				}
+
+				value = a->get(b);
+				if (t != b) return true;
+
+				// The last element, race the thieves for it
+
+				bool won = top.compare_exchange_strong(t, t + 1,
+					std::memory_order_seq_cst, std::memory_order_relaxed);
+
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+
+			/**
+			 *  @brief  Removes the value at the top, the oldest one.
+			 *  Any thread may steal.
+			 *  @param  value  Where the value is stored.
+			 *  @returns  False if the deque is empty or another thread took
+			 *  the value first, true otherwise.
+			 *  @note  Runtime: O(1), lock-free
+			 *  @note  Memory: O(1)
+			 */
+			bool steal(type& value)
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t b = bottom.load(std::memory_order_acquire);
+
+				if (t >= b) return false;
+
+				WorkStealingArray<type> *a = array.load(std::memory_order_acquire);
+				type stolen = a->get(t);
+
+				if (!top.compare_exchange_strong(t, t + 1,
+					std::memory_order_seq_cst, std::memory_order_relaxed)) return false;
+
+				value = stolen;
+				return true;
+			}
+	};
+};
+
+#endif
@@ -11,12 +11,43 @@ namespace flow {
 			INDEX_OUT_OF_RANGE
 		};
 	};
+};
 
+namespace flow_buffer_tools {
+	/**
+	 *  @brief  The element accessors of a Buffer, which copy elements.
+	 *  Buffers of move-only elements do not have them, so using them
+	 *  fails to compile.
+	 */
+	template <typename type, bool copyable>
+	class BufferAccessors {
+		public:
+			/**
+			 *  @brief  Gets the i-th element on the buffer.
+			 *  @param  index  i
+			 */
+			virtual type get_at_index(size_t index) const = 0;
+
+			/**
+			 *  @brief  Sets the i-th element on the buffer.
+			 *  @param  index  i
+			 *  @param  value  The value to assign at the index.
+			 */
+			virtual void set_at_index(size_t index, const type& value) = 0;
+	};
+
+	template <typename type>
+	class BufferAccessors<type, false> {};
+};
+
+namespace flow {
 	/**
 	 *  @brief  An abstract class that represents a contiguous source of data
 	 */
 	template <typename type>
-	class Buffer {
+	class Buffer : public flow_buffer_tools::BufferAccessors<type,
+		std::is_copy_constructible_v<type> && std::is_copy_assignable_v<type>>
+	{
 		public:
 			// Abstract methods
 
@@ -58,19 +89,6 @@ namespace flow {
 			 */
 			virtual size_t size() const = 0;
 
-			/**
-			 *  @brief  Gets the i-th element on the buffer.
-			 *  @param  index  i
-			 */
-			virtual type get_at_index(size_t index) const = 0;
-
-			/**
-			 *  @brief  Sets the i-th element on the buffer.
-			 *  @param  index  i
-			 *  @param  value  The value to assign at the index.
-			 */
-			virtual void set_at_index(size_t index, const type& value) = 0;
-
 			// Iterators
 
 			/**
@@ -178,7 +196,7 @@ namespace flow {
 			void fill(type value)
 			{
 				for (size_t i = 0; i < size(); i++) {
-					set_at_index(i, value);
+					this->set_at_index(i, value);
 				}
 			}
 
@@ -195,7 +213,7 @@ namespace flow {
 				}
 				#endif
 
-				type value_1 = get_at_index(index_1);
+				type value_1 = this->get_at_index(index_1);
 				*(data() + index_1) = *(data() + index_2);
 				*(data() + index_2) = value_1;
 			}
@@ -223,7 +241,7 @@ namespace flow {
 				// Deep equality checking
 
 				for (size_t i = 0; i < size(); i++) {
-					if (get_at_index(i) != other_buffer.get_at_index(i)) return false;
+					if (this->get_at_index(i) != other_buffer.get_at_index(i)) return false;
 				}
 
 				return true;
@@ -254,7 +272,7 @@ namespace flow {
 			bool includes(type value) const
 			{
 				for (size_t i = 0; i < size(); i++) {
-					if (get_at_index(i) == value) return true;
+					if (this->get_at_index(i) == value) return true;
 				}
 
 				return false;
@@ -269,7 +287,7 @@ namespace flow {
 				size_t found_values = 0;
 
 				for (size_t i = 0; i < size(); i++) {
-					if (get_at_index(i) == value) found_values++;
+					if (this->get_at_index(i) == value) found_values++;
 				}
 
 				return found_values;
@@ -285,7 +303,7 @@ namespace flow {
 			ssize_t first_index_of(type value, size_t starting_index = 0) const
 			{
 				for (int i = starting_index; i < size(); i++) {
-					if (get_at_index(i) == value) return i;
+					if (this->get_at_index(i) == value) return i;
 				}
 
 				return -1;
@@ -301,7 +319,7 @@ namespace flow {
 			ssize_t last_index_of(type value, size_t starting_index = size() - 1) const
 			{
 				for (int i = starting_index; i > 0; i--) {
-					if (get_at_index(i) == value) return i;
+					if (this->get_at_index(i) == value) return i;
 				}
 
 				return -1;
@@ -23,6 +23,12 @@ namespace flow {
 			 */
 			ContentProvider(size_t size) : size(size) {}
 
+			/**
+			 *  @brief  Providers are deleted through a ContentProvider pointer
+			 *  once they finished, so their resources are released.
+			 */
+			virtual ~ContentProvider() {}
+
 			/**
 			 *  @brief  Abstract method that must be implemented by the developer.
 			 *  It should return a chunk of the content, at any given offset.
@@ -46,7 +52,9 @@ namespace flow {
 				String chunk = next_chunk(bytes_provided, desired_size);
 				bytes_provided += chunk.size();
 
-				if (bytes_provided >= size) finished = true;
+				// An empty chunk ends the content early, e.g. a truncated file
+
+				if (bytes_provided >= size || chunk.size() == 0) finished = true;
 
 				stream.write(chunk);
 			}
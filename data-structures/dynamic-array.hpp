@@ -4,6 +4,7 @@
 #include <bits/stdc++.h>
 
 #include "buffer.hpp"
+#include "../memory/arena.hpp"
 
 namespace flow {
 	namespace DynamicArrayErrors {
@@ -14,9 +15,17 @@ namespace flow {
 
 	/**
 	 *  @brief  A resizable data structure that holds contigious elements.
+	 *  A DynamicArray created while an ArenaScope is active allocates its
+	 *  buffers from the Arena of the scope, and from its Allocator otherwise.
+	 *  This includes DynamicArrays that are moved into, they only take over
+	 *  the buffer of the other DynamicArray if it is on the same Arena.
+	 *  The elements are constructed on the Arena of the DynamicArray, or on
+	 *  the heap if it has none, whichever ArenaScope is active.
 	 *  @tparam  type  The type of data stored in the DynamicArray.
+	 *  @tparam  Allocator  The allocator of the buffers. A stateless
+	 *  allocator takes up no space.
 	 */
-	template <typename type>
+	template <typename type, typename Allocator = std::allocator<type>>
 	class DynamicArray : public Buffer<type> {
 		public:
 			static constexpr const size_t MIN_CAPACITY = 16;
@@ -27,12 +36,59 @@ namespace flow {
 			size_t current_element_count;
 			size_t current_buffer_size;
 
-		private:
+			// The Arena buffers are allocated from, NULL for the Allocator
+
+			Arena *arena = current_arena();
+
+			[[no_unique_address]] Allocator allocator;
+
+			using AllocatorTraits = std::allocator_traits<Allocator>;
+
+			/**
+			 *  @brief  Allocates a buffer of current_buffer_size elements.
+			 */
 			type *allocate_buffer()
 			{
-				return new type[current_buffer_size];
+				type *new_buffer = arena == NULL
+					? AllocatorTraits::allocate(allocator, current_buffer_size)
+					: static_cast<type *>(arena->allocate(
+						sizeof(type) * current_buffer_size, alignof(type)));
+
+				if constexpr (!std::is_trivially_default_constructible_v<type>) {
+					// Elements allocate from the Arena of the DynamicArray,
+					// not from the one bound by the caller
+
+					ArenaScope element_scope(arena);
+
+					for (size_t i = 0; i < current_buffer_size; i++) {
+						new (new_buffer + i) type;
+					}
+				}
+
+				return new_buffer;
+			}
+
+			/**
+			 *  @brief  Destroys the elements of a buffer and frees it.
+			 *  Buffers on an Arena are only freed when the Arena is reset.
+			 */
+			void free_buffer(type *old_buffer, size_t old_buffer_size)
+			{
+				if (old_buffer == NULL) return;
+
+				if constexpr (!std::is_trivially_destructible_v<type>) {
+					for (size_t i = 0; i < old_buffer_size; i++) {
+						old_buffer[i].~type();
+					}
+				}
+
+				if (arena == NULL) {
+					AllocatorTraits::deallocate(allocator, old_buffer, old_buffer_size);
+				}
 			}
 
+		private:
+
 			void reassign(
 				std::initializer_list<type> values,
 				size_t minimum_starting_size = 0
@@ -52,17 +108,18 @@ namespace flow {
 
 			void resize_buffer(size_t new_buffer_size)
 			{
+				size_t old_buffer_size = current_buffer_size;
 				current_buffer_size = new_buffer_size;
 				type *new_buffer = allocate_buffer();
 
 				if (buffer != NULL) {
-					// Copy the old values back onto the new buffer
+					// Move the old values onto the new buffer
 
 					for (size_t i = 0; i < current_element_count; i++) {
-						new_buffer[i] = buffer[i];
+						new_buffer[i] = std::move(buffer[i]);
 					}
 
-					delete[] buffer;
+					free_buffer(buffer, old_buffer_size);
 				}
 
 				buffer = new_buffer;
@@ -83,8 +140,12 @@ namespace flow {
 			 *  @brief  Creates a dynamic resizable array.
 			 *  @param  starting_capacity  The initial number of elements to
 			 *  allocate space for on the DynamicArray.
+			 *  @param  allocator  The allocator of the buffers.
 			 */
-			DynamicArray(size_t starting_capacity = 16)
+			DynamicArray(
+				size_t starting_capacity = 16,
+				const Allocator& allocator = Allocator()
+			) : allocator(allocator)
 			{
 				current_element_count = 0;
 				current_buffer_size = starting_capacity;
@@ -110,24 +171,45 @@ namespace flow {
 			 *  @brief  Creates a copy of a DynamicArray.
 			 *  @param  source_arr  The DynamicArray to copy.
 			 */
-			DynamicArray(const DynamicArray<type>& source_arr)
+			DynamicArray(const DynamicArray& source_arr)
+				: allocator(AllocatorTraits::select_on_container_copy_construction(
+					source_arr.allocator))
 			{
 				current_element_count = source_arr.current_element_count;
 				current_buffer_size = source_arr.current_buffer_size;
 				buffer = allocate_buffer();
 
-				size_t copy_size = sizeof(type) * current_element_count;
-				memcpy(buffer, source_arr.buffer, copy_size);
+				std::copy(source_arr.buffer, source_arr.buffer + current_element_count,
+					buffer);
 			}
 
 			/**
 			 *  @brief  Creates a DynamicArray by moving from an rvalue Array.
+			 *  Like any new DynamicArray, it allocates from the Arena of the
+			 *  active ArenaScope. The buffer is only taken over if the other
+			 *  DynamicArray allocates from the same Arena, otherwise the
+			 *  elements are moved into a new buffer, so e.g. a String moved
+			 *  out of the ArenaScope of a request does not stay on its Arena.
 			 *  @param  source_arr  The DynamicArray to move.
+			 *  @note  Runtime: O(1) if the buffer is taken over, O(n) otherwise
+			 *  @note  Memory: O(1) if the buffer is taken over, O(n) otherwise
 			 */
-			DynamicArray(DynamicArray<type>&& source_arr)
+			DynamicArray(DynamicArray&& source_arr) noexcept
+				: allocator(std::move(source_arr.allocator))
 			{
 				current_element_count = source_arr.current_element_count;
 				current_buffer_size = source_arr.current_buffer_size;
+
+				if (arena != source_arr.arena && source_arr.buffer != NULL) {
+					buffer = allocate_buffer();
+
+					std::move(source_arr.buffer,
+						source_arr.buffer + current_element_count, buffer);
+
+					source_arr.current_element_count = 0;
+					return;
+				}
+
 				buffer = source_arr.buffer;
 
 				source_arr.buffer = NULL;
@@ -138,18 +220,18 @@ namespace flow {
 			 *  @brief  Copies the values of another DynamicArray into this
 			 *  DynamicArray. All existing elements are removed.
 			 */
-			DynamicArray<type>& operator=(const DynamicArray<type>& other_arr)
+			DynamicArray& operator=(const DynamicArray& other_arr)
 			{
 				if (this == &other_arr) return *this;
 
-				delete[] buffer;
+				free_buffer(buffer, current_buffer_size);
 
 				current_element_count = other_arr.current_element_count;
 				current_buffer_size = other_arr.current_buffer_size;
 				buffer = allocate_buffer();
 
-				size_t copy_size = sizeof(type) * current_element_count;
-				memcpy(buffer, other_arr.buffer, copy_size);
+				std::copy(other_arr.buffer, other_arr.buffer + current_element_count,
+					buffer);
 
 				return *this;
 			}
@@ -157,15 +239,28 @@ namespace flow {
 			/**
 			 *  @brief  Moves the values of an rvalue DynamicArray into this
 			 *  DynamicArray. All existing elements are removed.
+			 *  The buffer is only taken over if both DynamicArrays allocate from
+			 *  the same place, otherwise the elements are moved one by one, so a
+			 *  DynamicArray never ends up with a buffer it cannot free.
 			 */
-			DynamicArray<type>& operator=(DynamicArray<type>&& other_arr)
+			DynamicArray& operator=(DynamicArray&& other_arr)
 			{
 				if (this == &other_arr) return *this;
 
-				delete[] buffer;
+				free_buffer(buffer, current_buffer_size);
 
 				current_element_count = other_arr.current_element_count;
 				current_buffer_size = other_arr.current_buffer_size;
+
+				if (arena != other_arr.arena || allocator != other_arr.allocator) {
+					buffer = allocate_buffer();
+
+					std::move(other_arr.buffer,
+						other_arr.buffer + current_element_count, buffer);
+
+					return *this;
+				}
+
 				buffer = other_arr.buffer;
 
 				other_arr.buffer = NULL;
@@ -178,20 +273,28 @@ namespace flow {
 			 *  @brief  Reassigns the array with new values.
 			 *  @param  new_values  A brace enclosed list containing the new values.
 			 */
-			DynamicArray<type>& operator=(std::initializer_list<type> new_values)
+			DynamicArray& operator=(std::initializer_list<type> new_values)
 			{
 				reassign(new_values);
 				return *this;
 			}
 
+			/**
+			 *  @brief  Returns a copy of the allocator of the buffers.
+			 */
+			Allocator get_allocator() const
+			{
+				return allocator;
+			}
+
 			/**
 			 *  @brief  Returns a copy of itself.
 			 *  @note  Runtime: O(n)
 			 *  @note  Memory: O(n)
 			 */
-			DynamicArray<type> copy_self() const
+			DynamicArray copy_self() const
 			{
-				DynamicArray<type> copy(current_buffer_size);
+				DynamicArray copy(current_buffer_size, allocator);
 				copy.unsafe_increment_element_count(current_element_count);
 				copy.copy_from(this);
 				return copy;
@@ -204,9 +307,10 @@ namespace flow {
 			 */
 			void reset(size_t starting_size = 16)
 			{
+				size_t old_buffer_size = current_buffer_size;
 				current_buffer_size = starting_size;
 				type *new_buffer = allocate_buffer();
-				if (buffer != NULL) delete[] buffer;
+				free_buffer(buffer, old_buffer_size);
 
 				current_element_count = 0;
 				buffer = new_buffer;
@@ -217,7 +321,7 @@ namespace flow {
 			 */
 			~DynamicArray()
 			{
-				if (buffer != NULL) delete[] buffer;
+				free_buffer(buffer, current_buffer_size);
 			}
 
 			// Abstract method implementations
@@ -254,16 +358,16 @@ namespace flow {
 			 */
 			const type& back() const
 			{
-				return *(buffer + current_element_count);
+				return *(buffer + current_element_count - 1);
 			}
 
 			/**
-			 *  @brief  Returns a read-only reference to the last element of
+			 *  @brief  Returns a read/write reference to the last element of
 			 *  the buffer.
 			 */
 			type& back()
 			{
-				return *(buffer + current_element_count);
+				return *(buffer + current_element_count - 1);
 			}
 
 			/**
@@ -284,6 +388,7 @@ namespace flow {
 
 			/**
 			 *  @brief  Gets the i-th element on the buffer.
+			 *  Move-only elements can only be accessed with operator[].
 			 *  @param  index  i
 			 */
 			type get_at_index(size_t index) const
@@ -294,6 +399,7 @@ namespace flow {
 
 			/**
 			 *  @brief  Sets the i-th element on the buffer.
+			 *  Move-only elements can only be assigned with operator[].
 			 *  @param  index  i
 			 *  @param  value  The value to assign at the index.
 			 */
@@ -409,10 +515,10 @@ namespace flow {
 			 *  @note  Runtime: O(n + m), n = size(), m = other_dynamic_array.size()
 			 *  @note  Memory: O(n + m), n = size(), m = other_dynamic_array.size()
 			 */
-			DynamicArray<type> operator+(DynamicArray<type>& other_dynamic_array)
+			DynamicArray operator+(DynamicArray& other_dynamic_array)
 			{
 				size_t total_size = size() + other_dynamic_array.size();
-				DynamicArray<type> concatenated_dynamic_array(total_size);
+				DynamicArray concatenated_dynamic_array(total_size);
 
 				concatenated_dynamic_array.attach(*this);
 				concatenated_dynamic_array.attach(other_dynamic_array);
@@ -516,17 +622,19 @@ namespace flow {
 
 			/**
 			 *  @brief  Returns the last element of the DynamicArray and deletes it.
-			 *  The DynamicArray will automatically shrink by a factor of 2 when possible.
-			 *  @note  Runtime: O(1) if no resize is needed, O(n) otherwise, n = size()
+			 *  The DynamicArray will automatically shrink by a factor of 2 when
+			 *  it is only a quarter full, so alternating appends and extractions
+			 *  around a power of 2 do not resize the buffer every time.
+			 *  @note  Runtime: O(1) amortised
 			 *  @note  Memory: O(1)
 			 */
 			type extract_rear()
 			{
-				type value = buffer[current_element_count--];
+				type value = std::move(buffer[--current_element_count]);
 
 				// Shrink array if possible
 
-				if (current_element_count <= current_buffer_size / 2
+				if (current_element_count <= current_buffer_size / 4
 					&& current_buffer_size > DynamicArray::MIN_CAPACITY) shrink();
 				return value;
 			}
@@ -619,7 +727,7 @@ namespace flow {
 			 *  O(n + m), n = size()
 			 *  @note  Memory: O(1)
 			 */
-			void attach(DynamicArray<type>& other_dynamic_array)
+			void attach(DynamicArray& other_dynamic_array)
 			{
 				if (other_dynamic_array.size() == 0) return;
 
@@ -647,7 +755,7 @@ namespace flow {
 			 *  O(n + m), n = size()
 			 *  @note  Memory: O(1)
 			 */
-			void operator+=(DynamicArray<type>& other_dynamic_array)
+			void operator+=(DynamicArray& other_dynamic_array)
 			{
 				attach(other_dynamic_array);
 			}
@@ -660,13 +768,14 @@ namespace flow {
 			 *  @note  Runtime: O(m + n), m = other_dynamic_array.size(), n = size()
 			 *  @note  Memory: O(m + n)
 			 */
-			void precede(DynamicArray<type>& other_dynamic_array)
+			void precede(DynamicArray& other_dynamic_array)
 			{
 				if (other_dynamic_array.size() == 0) return;
 
 				// Allocate a new buffer
 
 				size_t new_size = size() + other_dynamic_array.size();
+				size_t old_buffer_size = current_buffer_size;
 				current_buffer_size = calc_growth_size(new_size);
 
 				type *new_buffer = allocate_buffer();
@@ -685,7 +794,7 @@ namespace flow {
 
 				// Update the buffer pointer and element count
 
-				delete[] buffer;
+				free_buffer(buffer, old_buffer_size);
 				buffer = new_buffer;
 
 				unsafe_increment_element_count(other_dynamic_array.size());
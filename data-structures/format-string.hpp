@@ -0,0 +1,370 @@
+#ifndef FLOW_FORMAT_STRING_HEADER
+#define FLOW_FORMAT_STRING_HEADER
+
+#include <bits/stdc++.h>
+
+namespace flow {
+	template <typename Allocator>
+	class BasicString;
+};
+
+namespace flow_format_tools {
+	/**
+	 *  @brief  The kinds of arguments String::format() knows how to write.
+	 */
+	enum class FormatArgKinds {
+		UNSUPPORTED,
+		INTEGER,
+		FLOAT,
+		C_STRING,
+		STRING
+	};
+
+	template <typename type>
+	struct is_basic_string : std::false_type {};
+
+	template <typename Allocator>
+	struct is_basic_string<flow::BasicString<Allocator>> : std::true_type {};
+
+	/**
+	 *  @brief  Returns the FormatArgKind of a type passed to String::format().
+	 */
+	template <typename type>
+	constexpr FormatArgKinds format_arg_kind()
+	{
+		using T = std::remove_cv_t<std::remove_reference_t<type>>;
+
+		if constexpr (is_basic_string<T>::value) {
+			return FormatArgKinds::STRING;
+		} else if constexpr (
+			std::is_same_v<std::decay_t<T>, char *>
+			|| std::is_same_v<std::decay_t<T>, const char *>
+		) {
+			return FormatArgKinds::C_STRING;
+		} else if constexpr (std::is_same_v<T, bool>) {
+			return FormatArgKinds::UNSUPPORTED;
+		} else if constexpr (std::is_integral_v<T>) {
+			return FormatArgKinds::INTEGER;
+		} else if constexpr (std::is_floating_point_v<T>) {
+			return FormatArgKinds::FLOAT;
+		} else {
+			return FormatArgKinds::UNSUPPORTED;
+		}
+	}
+
+	/**
+	 *  @brief  A parsed conversion specifier, e.g. "%05d".
+	 */
+	struct FormatSpec {
+		char conversion = '\0';
+		char pad_char = '\0';
+		size_t pad_size = 0;
+		size_t precision = 6;
+		bool precision_set = false;
+	};
+
+	/**
+	 *  @brief  A run of literal characters between two conversion specifiers.
+	 */
+	struct FormatLiteral {
+		// Position of the run in the format string
+
+		size_t offset = 0;
+		size_t len = 0;
+
+		// Number of characters the run expands to, "%%" is written as "%"
+
+		size_t size = 0;
+		bool escaped = false;
+	};
+
+	// Format string errors are reported at compile time. Calling one of
+	// these non-constexpr functions while the format string is parsed makes
+	// the compilation fail, and the compiler names the function in the error.
+
+	inline void format_error_too_many_conversions() {}
+	inline void format_error_too_few_conversions() {}
+	inline void format_error_unterminated_conversion() {}
+	inline void format_error_unknown_conversion() {}
+	inline void format_error_padding_set_twice() {}
+	inline void format_error_precision_set_twice() {}
+	inline void format_error_length_modifier_set_twice() {}
+	inline void format_error_float_precision_too_large() {}
+	inline void format_error_unsupported_argument_type() {}
+	inline void format_error_argument_is_not_an_integer() {}
+	inline void format_error_argument_is_not_a_float() {}
+	inline void format_error_argument_is_not_a_string() {}
+};
+
+namespace flow {
+	using namespace flow_format_tools;
+
+	/**
+	 *  @brief  A format string for String::format() that is parsed and
+	 *  type checked against the argument types at compile time.
+	 *  The format string must therefore be a string literal.
+	 *
+	 *  Conversion specifiers have the form %[pad][.precision][length]conversion
+	 *   - pad: "0N" pads with zeros, "-N" or "N" pads with spaces, to a
+	 *     minimum width of N. Padding is always inserted on the left.
+	 *   - precision: the number of fraction digits for floats (default 6),
+	 *     or the maximum number of characters for strings.
+	 *   - length: "hh", "h", "l", "ll" and "z" are accepted for compatibility
+	 *     and ignored, the width of an argument follows from its type.
+	 *   - conversion: "d", "i" and "u" write an integer in base 10,
+	 *     "o", "x" and "X" write it in base 8 or 16 prefixed with "0o" or "0x",
+	 *     "c" writes an integer as a character, "f" writes a float,
+	 *     "s" and "S" write a String or a C string. "%%" writes "%".
+	 *  @tparam  Args  The types of the arguments.
+	 */
+	template <typename... Args>
+	class FormatString {
+		public:
+			static constexpr size_t ARG_COUNT = sizeof...(Args);
+			static constexpr size_t MAX_FLOAT_PRECISION = 255;
+
+			const char *fmt;
+
+			// The literal at index i precedes the conversion at index i,
+			// the last literal follows the last conversion
+
+			FormatLiteral literals[ARG_COUNT + 1];
+			FormatSpec specs[ARG_COUNT + 1];
+
+			// Total number of literal characters written
+
+			size_t literals_size = 0;
+
+		private:
+			static constexpr size_t parse_uint(const char *str, size_t& i, size_t len)
+			{
+				size_t num = 0;
+
+				while (i < len && str[i] >= '0' && str[i] <= '9') {
+					num = num * 10 + str[i++] - '0';
+				}
+
+				return num;
+			}
+
+			static constexpr void check_arg(char conversion, FormatArgKinds kind)
+			{
+				if (kind == FormatArgKinds::UNSUPPORTED) {
+					format_error_unsupported_argument_type();
+				}
+
+				switch (conversion) {
+					case 'd':
+					case 'i':
+					case 'u':
+					case 'o':
+					case 'x':
+					case 'X':
+					case 'c':
+						if (kind != FormatArgKinds::INTEGER) {
+							format_error_argument_is_not_an_integer();
+						}
+
+						break;
+
+					case 'f':
+						if (kind != FormatArgKinds::FLOAT) {
+							format_error_argument_is_not_a_float();
+						}
+
+						break;
+
+					case 's':
+					case 'S':
+						if (kind != FormatArgKinds::C_STRING
+							&& kind != FormatArgKinds::STRING) {
+							format_error_argument_is_not_a_string();
+						}
+
+						break;
+				}
+			}
+
+			/**
+			 *  @brief  Parses fmt and checks it against the argument types.
+			 *  Errors are only reported at compile time.
+			 *  @param  len  The length of fmt.
+			 */
+			constexpr void parse(size_t len)
+			{
+				constexpr FormatArgKinds kinds[] = {
+					format_arg_kind<Args>()..., FormatArgKinds::UNSUPPORTED
+				};
+
+				size_t arg = 0;
+				size_t i = 0;
+
+				FormatLiteral literal;
+
+				while (i < len) {
+					if (fmt[i] != '%') {
+						literal.size++;
+						i++;
+						continue;
+					}
+
+					if (i + 1 < len && fmt[i + 1] == '%') {
+						literal.escaped = true;
+						literal.size++;
+						i += 2;
+						continue;
+					}
+
+					// Close the current literal
+
+					if (arg == ARG_COUNT) format_error_too_many_conversions();
+
+					literal.len = i - literal.offset;
+					literals[arg] = literal;
+					literals_size += literal.size;
+
+					// Parse the conversion specifier
+
+					FormatSpec spec;
+					bool length_modifier_set = false;
+					i++;
+
+					while (spec.conversion == '\0') {
+						if (i == len) format_error_unterminated_conversion();
+
+						char c = fmt[i];
+
+						switch (c) {
+							case '0':
+							case '-':
+								if (spec.pad_char) format_error_padding_set_twice();
+
+								spec.pad_char = c == '0' ? '0' : ' ';
+								i++;
+								spec.pad_size = parse_uint(fmt, i, len);
+								break;
+
+							case '1': case '2': case '3':
+							case '4': case '5': case '6':
+							case '7': case '8': case '9':
+								if (spec.pad_char) format_error_padding_set_twice();
+
+								spec.pad_char = ' ';
+								spec.pad_size = parse_uint(fmt, i, len);
+								break;
+
+							case '.':
+								if (spec.precision_set) format_error_precision_set_twice();
+
+								spec.precision_set = true;
+								i++;
+								spec.precision = parse_uint(fmt, i, len);
+								break;
+
+							case 'h':
+							case 'l':
+								if (length_modifier_set) format_error_length_modifier_set_twice();
+
+								length_modifier_set = true;
+								i++;
+								if (i < len && fmt[i] == c) i++;
+								break;
+
+							case 'z':
+								if (length_modifier_set) format_error_length_modifier_set_twice();
+
+								length_modifier_set = true;
+								i++;
+								break;
+
+							case 'd': case 'i': case 'u':
+							case 'o': case 'x': case 'X':
+							case 'c': case 'f': case 's': case 'S':
+								spec.conversion = c;
+								i++;
+								break;
+
+							default:
+								format_error_unknown_conversion();
+						}
+					}
+
+					if (spec.conversion == 'f' && spec.precision > MAX_FLOAT_PRECISION) {
+						format_error_float_precision_too_large();
+					}
+
+					check_arg(spec.conversion, kinds[arg]);
+					specs[arg++] = spec;
+
+					// Open the next literal
+
+					literal = FormatLiteral();
+					literal.offset = i;
+				}
+
+				if (arg != ARG_COUNT) format_error_too_few_conversions();
+
+				literal.len = i - literal.offset;
+				literals[arg] = literal;
+				literals_size += literal.size;
+			}
+
+			constexpr FormatString(const char *fmt, size_t len) : fmt(fmt)
+			{
+				parse(len);
+			}
+
+		public:
+			/**
+			 *  @brief  Parses a format string literal and checks it against
+			 *  the argument types. Runs at compile time only.
+			 *  @param  fmt  The format string literal.
+			 */
+			template <size_t fmt_size>
+			consteval FormatString(const char (&fmt)[fmt_size]) : fmt(fmt)
+			{
+				parse(fmt_size - 1);
+			}
+
+			/**
+			 *  @brief  Parses a format string again at runtime, e.g. to format
+			 *  arguments that were stored away by a Logger. The format string
+			 *  must have been checked against the same argument types at
+			 *  compile time, errors are not reported at runtime.
+			 *  @param  fmt  The fmt member of that FormatString.
+			 *  @note  Runtime: O(n), n = strlen(fmt)
+			 *  @note  Memory: O(1)
+			 */
+			static FormatString reparse(const char *fmt)
+			{
+				return FormatString(fmt, strlen(fmt));
+			}
+
+			/**
+			 *  @brief  Writes the i-th literal to a buffer.
+			 *  Does not check if there is enough space left on the buffer.
+			 *  @returns  The number of bytes written.
+			 */
+			size_t write_literal(size_t i, char *buf) const
+			{
+				const FormatLiteral& literal = literals[i];
+				const char *src = fmt + literal.offset;
+
+				if (!literal.escaped) {
+					memcpy(buf, src, literal.len);
+					return literal.len;
+				}
+
+				size_t j = 0;
+
+				for (size_t k = 0; k < literal.len; k++) {
+					buf[j++] = src[k];
+					if (src[k] == '%') k++;
+				}
+
+				return j;
+			}
+	};
+};
+
+#endif
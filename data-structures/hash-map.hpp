@@ -29,49 +29,84 @@ namespace flow_hash_map_tools {
 		KEY_NOT_FOUND
 	};
 
-	template <typename Key, typename Value>
+	/**
+	 *  @brief  The buckets of a HashMap. The Allocator is rebound for the
+	 *  table and for the nodes of the buckets. All buckets allocate their
+	 *  nodes from one shared NodePool, so a bucket with a few entries does
+	 *  not hold slabs of its own.
+	 */
+	template <typename Key, typename Value, typename Allocator>
 	class HashMapTable {
 		public:
 			typedef KeyValuePair<Key, Value> Entry;
 
+			using AllocatorTraits = std::allocator_traits<Allocator>;
+			using EntryAllocator = typename AllocatorTraits::template rebind_alloc<Entry>;
+			using List = LinkedList<Entry, EntryAllocator, true>;
+			using ListAllocator = typename AllocatorTraits::template rebind_alloc<List>;
+
+			// Lives on the heap, so the buckets keep pointing to it when the
+			// table is moved. Declared before the table, which is destroyed
+			// first, because the buckets free their nodes to it
+
+			std::unique_ptr<typename List::Pool> pool;
+
 			size_t cur_size = 0;
-			DynamicArray<LinkedList<Entry>> table;
+			DynamicArray<List, ListAllocator> table;
 
-			HashMapTable(size_t table_size) : table(table_size)
+			HashMapTable(size_t table_size, const Allocator& allocator = Allocator())
+				: pool(new typename List::Pool(EntryAllocator(allocator))),
+				table(table_size, ListAllocator(allocator))
 			{
 				table.unsafe_set_element_count(table.current_capacity());
+
+				for (size_t i = 0; i < table.size(); i++) table[i].bind_pool(*pool);
 			}
 
-			HashMapTable(const HashMapTable<Key, Value>& other)
+			HashMapTable(const HashMapTable& other)
+				: HashMapTable(other.table.size(), Allocator(
+					AllocatorTraits::select_on_container_copy_construction(
+						Allocator(other.table.get_allocator()))))
 			{
 				cur_size = other.cur_size;
-				table = other.table;
+
+				for (size_t i = 0; i < table.size(); i++) table[i] = other.table[i];
 			}
 
-			HashMapTable(HashMapTable<Key, Value>&& other)
+			HashMapTable(HashMapTable&& other)
+				: pool(std::move(other.pool)), cur_size(other.cur_size),
+				table(std::move(other.table))
 			{
-				cur_size = other.cur_size;
-				table = std::move(other.table);
-
 				other.cur_size = 0;
 			}
 
-			HashMapTable<Key, Value>& operator=(const HashMapTable<Key, Value>& other)
+			/**
+			 *  @brief  Returns the Arena the entries are allocated from,
+			 *  NULL for the heap.
+			 */
+			Arena *get_arena() const
 			{
-				if (this == &other) return *this;
+				return pool->get_arena();
+			}
 
-				cur_size = other.cur_size;
-				table = other.table;
+			HashMapTable& operator=(const HashMapTable& other)
+			{
+				if (this == &other) return *this;
 
-				return *this;
+				HashMapTable copy(other);
+				return *this = std::move(copy);
 			}
 
-			HashMapTable<Key, Value>& operator=(HashMapTable<Key, Value>&& other)
+			HashMapTable& operator=(HashMapTable&& other)
 			{
 				if (this == &other) return *this;
 
+				// The old buckets free their nodes to the old NodePool,
+				// so it is only replaced after the table
+
 				cur_size = other.cur_size;
 				table = std::move(other.table);
+				pool = std::move(other.pool);
 
 				other.cur_size = 0;
 
@@ -81,9 +116,9 @@ namespace flow_hash_map_tools {
 			template <bool Const = false>
 			class IteratorBase {
 				private:
-					DynamicArray<LinkedList<Entry>>& table;
+					DynamicArray<List, ListAllocator>& table;
 					size_t list_index;
-					typename LinkedList<Entry>::Iterator list_it;
+					typename List::Iterator list_it;
 
 					void hook_to_next_node()
 					{
@@ -104,7 +139,7 @@ namespace flow_hash_map_tools {
 
 				public:
 					IteratorBase(
-						DynamicArray<LinkedList<Entry>>& table,
+						DynamicArray<List, ListAllocator>& table,
 						size_t list_index
 					) : table(table), list_index(list_index), list_it(NULL)
 					{
@@ -132,7 +167,7 @@ namespace flow_hash_map_tools {
 						return list_index;
 					}
 
-					typename LinkedList<Entry>::Iterator& get_list_it()
+					typename List::Iterator& get_list_it()
 					{
 						return list_it;
 					}
@@ -208,7 +243,7 @@ namespace flow_hash_map_tools {
 				return ConstIterator(table, table.size());
 			}
 
-			LinkedList<Entry>& get_list_of_key(const Key& key)
+			List& get_list_of_key(const Key& key)
 			{
 				struct std::hash<Key> hash_func;
 				size_t index = hash_func(key) & table.size() - 1;
@@ -217,9 +252,9 @@ namespace flow_hash_map_tools {
 
 			Value& get_by_key(const Key& key)
 			{
-				LinkedList<Entry>& list = get_list_of_key();
+				List& list = get_list_of_key(key);
 
-				for (const Entry& entry : list) {
+				for (Entry& entry : list) {
 					if (entry.key == key) return entry.value;
 				}
 
@@ -233,7 +268,7 @@ namespace flow_hash_map_tools {
 
 			bool insert(const Key& key, const Value& value)
 			{
-				LinkedList<Entry>& list = get_list_of_key(key);
+				List& list = get_list_of_key(key);
 
 				for (Entry& entry : list) {
 					if (entry.key == key) {
@@ -249,7 +284,7 @@ namespace flow_hash_map_tools {
 
 			bool insert(Key&& key, Value&& value)
 			{
-				LinkedList<Entry>& list = get_list_of_key(key);
+				List& list = get_list_of_key(key);
 
 				for (Entry& entry : list) {
 					if (entry.key == key) {
@@ -265,10 +300,10 @@ namespace flow_hash_map_tools {
 
 			bool remove(const Key& key)
 			{
-				LinkedList<Entry>& list = get_list_of_key(key);
+				List& list = get_list_of_key(key);
 
-				typename LinkedList<Entry>::Iterator it = list.begin();
-				typename LinkedList<Entry>::Iterator end = list.end();
+				typename List::Iterator it = list.begin();
+				typename List::Iterator end = list.end();
 
 				while (it != end) {
 					if (it->key == key) {
@@ -276,6 +311,8 @@ namespace flow_hash_map_tools {
 						cur_size--;
 						return true;
 					}
+
+					++it;
 				}
 
 				return false;
@@ -284,7 +321,7 @@ namespace flow_hash_map_tools {
 			void print()
 			{
 				for (size_t i = 0; i < table.size(); i++) {
-					LinkedList<Entry>& list = table[i];
+					List& list = table[i];
 
 					String::format("=== Bucket %llu (%llu) ===",
 						i, list.size()).print();
@@ -304,7 +341,11 @@ namespace flow {
 	 *  @brief  HashMap implementation. Lookups, insertion and updating
 	 *  takes O(1) on average.
 	 */
-	template <typename Key, typename Value>
+	template <
+		typename Key,
+		typename Value,
+		typename Allocator = std::allocator<KeyValuePair<Key, Value>>
+	>
 	class HashMap {
 		public:
 			typedef KeyValuePair<Key, Value> Entry;
@@ -313,12 +354,14 @@ namespace flow {
 			constexpr static const double MAX_ALPHA = 1.0;
 
 		protected:
-			HashMapTable<Key, Value> table;
+			using Table = HashMapTable<Key, Value, Allocator>;
+
+			Table table;
 
 		private:
-			LinkedList<Entry *>& get_list_of_key(const Key& key)
+			typename Table::List& get_list_of_key(const Key& key)
 			{
-				return table.get_by_key(key);
+				return table.get_list_of_key(key);
 			}
 
 			double avg_list_size()
@@ -328,7 +371,10 @@ namespace flow {
 
 			void grow()
 			{
-				HashMapTable<Key, Value> new_table(table.table.size() << 1);
+				// The new table stays on the Arena of the HashMap
+
+				ArenaScope table_scope(table.get_arena());
+				Table new_table(table.table.size() << 1, get_allocator());
 
 				for (const Entry& entry : table) {
 					new_table.insert(std::move(entry.key), std::move(entry.value));
@@ -339,7 +385,10 @@ namespace flow {
 
 			void shrink()
 			{
-				HashMapTable<Key, Value> new_table(table.table.size() >> 1);
+				// The new table stays on the Arena of the HashMap
+
+				ArenaScope table_scope(table.get_arena());
+				Table new_table(table.table.size() >> 1, get_allocator());
 
 				for (const Entry& entry : table) {
 					new_table.insert(std::move(entry.key), std::move(entry.value));
@@ -355,23 +404,31 @@ namespace flow {
 			 */
 			HashMap(size_t init_table_size = 16) : table(init_table_size) {}
 
+			/**
+			 *  @brief  Creates a HashMap of a given initial table size.
+			 *  @param  init_table_size  The initial table size.
+			 *  @param  allocator  The allocator of the table and the entries.
+			 */
+			HashMap(size_t init_table_size, const Allocator& allocator)
+				: table(init_table_size, allocator) {}
+
 			/**
 			 *  @brief  Creates a copy of another HashMap.
 			 *  @param  other  The HashMap to copy.
 			 */
-			HashMap(const HashMap<Key, Value>& other) : table(other.table) {}
+			HashMap(const HashMap& other) : table(other.table) {}
 
 			/**
 			 *  @brief  Creates a HashMap by moving from an rvalue HashMap.
 			 *  @param  other  The HashMap to move.
 			 */
-			HashMap(HashMap<Key, Value>&& other) : table(std::move(other.table)) {}
+			HashMap(HashMap&& other) : table(std::move(other.table)) {}
 
 			/**
 			 *  @brief  Copies the entries of another HashMap into this HashMap.
 			 *  All existing entries are removed.
 			 */
-			HashMap<Key, Value>& operator=(const HashMap<Key, Value>& other)
+			HashMap& operator=(const HashMap& other)
 			{
 				if (this == &other) return *this;
 
@@ -383,7 +440,7 @@ namespace flow {
 			 *  @brief  Moves the entries of another HashMap into this HashMap.
 			 *  All existing entries are removed.
 			 */
-			HashMap<Key, Value>& operator=(HashMap<Key, Value>&& other)
+			HashMap& operator=(HashMap&& other)
 			{
 				if (this == &other) return *this;
 
@@ -391,6 +448,14 @@ namespace flow {
 				return *this;
 			}
 
+			/**
+			 *  @brief  Returns a copy of the allocator of the table.
+			 */
+			Allocator get_allocator() const
+			{
+				return Allocator(table.table.get_allocator());
+			}
+
 			/**
 			 *  @brief  Returns the current number of entries on the HashMap.
 			 */
@@ -403,13 +468,13 @@ namespace flow {
 			 *  @brief  Read/write iterator for the entries in the HashMap.
 			 *  Iteration order is undefined.
 			 */
-			using Iterator = typename HashMapTable<Key, Value>::Iterator;
+			using Iterator = typename Table::Iterator;
 
 			/**
 			 *  @brief  Read-only iterator for the entries in the HashMap.
 			 *  Iteration order is undefined.
 			 */
-			using ConstIterator = typename HashMapTable<Key, Value>::ConstIterator;
+			using ConstIterator = typename Table::ConstIterator;
 
 			/**
 			 *  @brief  Returns a read/write iterator that points to the first
@@ -474,7 +539,7 @@ namespace flow {
 			 */
 			bool has_key(const Key& key) const
 			{
-				LinkedList<Entry>& list = get_list_of_key(key);
+				typename Table::List& list = get_list_of_key(key);
 
 				for (const Entry& entry : list) {
 					if (entry.key == key) return true;
@@ -5,6 +5,7 @@
 
 #include "dynamic-array.hpp"
 #include "../iterators/node-list-iterator.hpp"
+#include "../memory/node-pool.hpp"
 
 namespace flow_linked_list_tools {
 	template <typename type>
@@ -28,13 +29,150 @@ namespace flow_linked_list_tools {
 namespace flow {
 	using namespace flow_linked_list_tools;
 
-	template <typename type>
+	/**
+	 *  @brief  A doubly linked list. Nodes are allocated from a NodePool
+	 *  owned by the LinkedList, so they are packed together in a few slabs.
+	 *  Many short LinkedLists, like the buckets of a HashMap, can share a
+	 *  single NodePool instead, so each of them does not hold its own slabs.
+	 *  @tparam  type  The type of data stored in the LinkedList.
+	 *  @tparam  Allocator  The allocator of the slabs of the NodePool.
+	 *  @tparam  shared_pool  Whether the NodePool is shared. A LinkedList
+	 *  with a shared NodePool only holds a pointer to it, and must be given
+	 *  one with bind_pool() or its constructor before nodes are added.
+	 *  The NodePool must outlive the LinkedList.
+	 */
+	template <
+		typename type,
+		typename Allocator = std::allocator<type>,
+		bool shared_pool = false
+	>
 	class LinkedList {
+		public:
+			using Pool = NodePool<Node<type>, Allocator>;
+
 		protected:
 			size_t cur_size;
 			Node<type> head;
 			Node<type> tail;
 
+			// The NodePool itself, or a pointer to the shared one,
+			// use pool() to get to it
+
+			std::conditional_t<shared_pool, Pool *, Pool> node_pool;
+
+			Pool& pool()
+			{
+				if constexpr (shared_pool) return *node_pool;
+				else return node_pool;
+			}
+
+			const Pool& pool() const
+			{
+				if constexpr (shared_pool) return *node_pool;
+				else return node_pool;
+			}
+
+			void link_empty()
+			{
+				head.next = &tail;
+				head.prev = NULL;
+				tail.next = NULL;
+				tail.prev = &head;
+			}
+
+			/**
+			 *  @brief  Takes over the nodes of another LinkedList,
+			 *  this LinkedList must be empty. The other LinkedList is reset.
+			 */
+			void take(LinkedList& other)
+			{
+				if constexpr (shared_pool) node_pool = other.node_pool;
+				else node_pool = std::move(other.node_pool);
+
+				cur_size = other.cur_size;
+
+				if (cur_size != 0) {
+					head.next = other.head.next;
+					head.next->prev = &head;
+					tail.prev = other.tail.prev;
+					tail.prev->next = &tail;
+				}
+
+				other.cur_size = 0;
+				other.link_empty();
+			}
+
+			/**
+			 *  @brief  Returns whether the nodes of another LinkedList can be
+			 *  freed by the NodePool of this LinkedList. Nodes on an Arena
+			 *  are never adopted by a NodePool that is not on the same Arena,
+			 *  so they cannot end up in a list that outlives the Arena.
+			 *  A shared NodePool only frees its own nodes.
+			 */
+			bool can_adopt(const LinkedList& other) const
+			{
+				if constexpr (shared_pool) {
+					return node_pool == other.node_pool;
+				} else {
+					return node_pool.get_arena() == other.node_pool.get_arena()
+						&& node_pool.get_allocator() == other.node_pool.get_allocator();
+				}
+			}
+
+			/**
+			 *  @brief  Moves the nodes of another LinkedList, which can be
+			 *  adopted, before the given node. The other LinkedList is reset.
+			 */
+			void splice_before(LinkedList& other, Node<type> *next_node)
+			{
+				if (other.cur_size == 0) return;
+
+				other.head.next->prev = next_node->prev;
+				next_node->prev->next = other.head.next;
+				other.tail.prev->next = next_node;
+				next_node->prev = other.tail.prev;
+
+				cur_size += other.cur_size;
+				if constexpr (!shared_pool) node_pool.adopt(other.node_pool);
+
+				other.cur_size = 0;
+				other.link_empty();
+			}
+
+			/**
+			 *  @brief  Moves the values of another LinkedList into new nodes
+			 *  before the given node. The other LinkedList is reset.
+			 */
+			void move_values_before(LinkedList& other, Node<type> *next_node)
+			{
+				for (Node<type> *node = other.head.next;
+					node != &other.tail; node = node->next) {
+					Node<type> *new_node = pool().create(std::move(node->value));
+
+					new_node->prev = next_node->prev;
+					new_node->next = next_node;
+					next_node->prev->next = new_node;
+					next_node->prev = new_node;
+					cur_size++;
+				}
+
+				other.destroy_nodes();
+			}
+
+			void destroy_nodes()
+			{
+				Node<type> *node = head.next;
+
+				for (size_t i = 0; i < cur_size; i++) {
+					Node<type> *next_node = node->next;
+					pool().destroy(node);
+					node = next_node;
+				}
+
+				cur_size = 0;
+				link_empty();
+			}
+
 			Node<type>& get_node(size_t i)
 			{
 				if (i >= cur_size) throw LinkedListErrors::INDEX_OUT_OF_BOUNDS;
@@ -61,13 +199,146 @@ namespace flow {
 		public:
 			/**
 			 *  @brief  Creates a LinkedList with no elements.
+			 *  A LinkedList with a shared NodePool is not bound to one yet.
 			 */
-			LinkedList() : cur_size(0)
+			LinkedList() : cur_size(0), node_pool()
 			{
-				head.next = &tail;
-				head.prev = NULL;
-				tail.next = NULL;
-				tail.prev = &head;
+				link_empty();
+			}
+
+			/**
+			 *  @brief  Creates a LinkedList with no elements.
+			 *  @param  allocator  The allocator of the slabs of the NodePool.
+			 */
+			LinkedList(const Allocator& allocator) requires (!shared_pool)
+				: cur_size(0), node_pool(allocator)
+			{
+				link_empty();
+			}
+
+			/**
+			 *  @brief  Creates a LinkedList with no elements, whose nodes are
+			 *  allocated from a shared NodePool.
+			 *  @param  pool  The NodePool, it must outlive the LinkedList.
+			 */
+			LinkedList(Pool& pool) requires shared_pool
+				: cur_size(0), node_pool(&pool)
+			{
+				link_empty();
+			}
+
+			/**
+			 *  @brief  Creates a LinkedList with copies of the values of
+			 *  another LinkedList.
+			 *  @note  Runtime: O(n), n = other.size()
+			 *  @note  Memory: O(n), n = other.size()
+			 */
+			LinkedList(const LinkedList& other) requires (!shared_pool)
+				: LinkedList(std::allocator_traits<Allocator>
+					::select_on_container_copy_construction(
+						other.node_pool.get_allocator()))
+			{
+				for (const Node<type> *node = other.head.next;
+					node != &other.tail; node = node->next) append(node->value);
+			}
+
+			/**
+			 *  @brief  Creates a LinkedList with copies of the values of
+			 *  another LinkedList, allocated from the same shared NodePool.
+			 *  @note  Runtime: O(n), n = other.size()
+			 *  @note  Memory: O(n), n = other.size()
+			 */
+			LinkedList(const LinkedList& other) requires shared_pool
+				: cur_size(0), node_pool(other.node_pool)
+			{
+				link_empty();
+
+				for (const Node<type> *node = other.head.next;
+					node != &other.tail; node = node->next) append(node->value);
+			}
+
+			/**
+			 *  @brief  Moves the nodes of another LinkedList to a new LinkedList.
+			 *  Like any new LinkedList, it allocates from the Arena of the
+			 *  active ArenaScope; if the other LinkedList allocates from a
+			 *  different one, its values are moved into new nodes.
+			 *  @note  Runtime: O(1), or O(n) if the Arenas differ, n = other.size()
+			 *  @note  Memory: O(1), or O(n) if the Arenas differ, n = other.size()
+			 */
+			LinkedList(LinkedList&& other) requires (!shared_pool)
+				: LinkedList(other.node_pool.get_allocator())
+			{
+				if (!can_adopt(other)) {
+					move_values_before(other, &tail);
+					return;
+				}
+
+				take(other);
+			}
+
+			/**
+			 *  @brief  Moves the nodes of another LinkedList to a new LinkedList
+			 *  on the same shared NodePool.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			LinkedList(LinkedList&& other) requires shared_pool
+				: cur_size(0), node_pool(other.node_pool)
+			{
+				link_empty();
+				take(other);
+			}
+
+			/**
+			 *  @brief  Replaces the values of this LinkedList with copies of
+			 *  the values of another LinkedList.
+			 *  @note  Runtime: O(n + m), n = size(), m = other.size()
+			 *  @note  Memory: O(m), m = other.size()
+			 */
+			LinkedList& operator=(const LinkedList& other)
+			{
+				if (this == &other) return *this;
+
+				destroy_nodes();
+
+				if constexpr (shared_pool) {
+					if (node_pool == NULL) node_pool = other.node_pool;
+				}
+
+				for (const Node<type> *node = other.head.next;
+					node != &other.tail; node = node->next) append(node->value);
+
+				return *this;
+			}
+
+			/**
+			 *  @brief  Replaces the values of this LinkedList with the nodes
+			 *  of another LinkedList. If the LinkedLists allocate their nodes
+			 *  from different places, the values are moved into new nodes.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			LinkedList& operator=(LinkedList&& other)
+			{
+				if (this == &other) return *this;
+
+				destroy_nodes();
+
+				// An unbound LinkedList, e.g. a new bucket of a
+				// DynamicArray, takes the NodePool of the other one
+
+				if constexpr (shared_pool) {
+					if (node_pool == NULL) node_pool = other.node_pool;
+				}
+
+				if (!can_adopt(other)) {
+					move_values_before(other, &tail);
+					return *this;
+				}
+
+				take(other);
+
+				return *this;
 			}
 
 			/**
@@ -77,13 +348,7 @@ namespace flow {
 			 */
 			~LinkedList()
 			{
-				Node<type> *node = head.next;
-
-				for (size_t i = 0; i < cur_size; i++) {
-					Node<type> *next_node = node->next;
-					delete node;
-					node = next_node;
-				}
+				destroy_nodes();
 			}
 
 			/**
@@ -126,6 +391,39 @@ namespace flow {
 				return cur_size;
 			}
 
+			/**
+			 *  @brief  Returns the NodePool the nodes are allocated from,
+			 *  NULL if a shared NodePool was not bound yet.
+			 */
+			const Pool *get_pool() const
+			{
+				if constexpr (shared_pool) return node_pool;
+				else return &node_pool;
+			}
+
+			/**
+			 *  @brief  Binds a LinkedList to a shared NodePool. The LinkedList
+			 *  must be empty.
+			 *  @param  pool  The NodePool, it must outlive the LinkedList.
+			 */
+			void bind_pool(Pool& pool) requires shared_pool
+			{
+				node_pool = &pool;
+			}
+
+			/**
+			 *  @brief  Releases the slabs of the node pool that no longer
+			 *  hold any nodes. The NodePool also does this by itself once
+			 *  most of its slots are free.
+			 *  @note  Runtime: O(s log s + f), s = number of slabs,
+			 *  f = number of free nodes
+			 *  @note  Memory: O(s), s = number of slabs
+			 */
+			void shrink_to_fit()
+			{
+				pool().trim();
+			}
+
 			/**
 			 *  @brief  Read/write iterator for the data in the LinkedList nodes.
 			 *  Iteration is done in-order.
@@ -412,7 +710,7 @@ namespace flow {
 			 */
 			void append(const type& value)
 			{
-				Node<type> *new_node = new Node<type>(value);
+				Node<type> *new_node = pool().create(value);
 
 				new_node->next = &tail;
 				new_node->prev = tail.prev;
@@ -430,7 +728,7 @@ namespace flow {
 			 */
 			void append(type&& value)
 			{
-				Node<type> *new_node = new Node<type>(std::move(value));
+				Node<type> *new_node = pool().create(std::move(value));
 
 				new_node->next = &tail;
 				new_node->prev = tail.prev;
@@ -467,14 +765,16 @@ namespace flow {
 			{
 				if (cur_size == 0) throw LinkedListErrors::EXTRACT_FROM_EMPTY_LIST;
 
-				type value = tail.prev->value;
+				type value = std::move(tail.prev->value);
 				Node<type> *new_rear = tail.prev->prev;
 
-				delete tail.prev;
+				pool().destroy(tail.prev);
 				cur_size--;
 
 				tail.prev = new_rear;
 				new_rear->next = &tail;
+
+				return value;
 			}
 
 			/**
@@ -485,7 +785,7 @@ namespace flow {
 			 */
 			void prepend(const type& value)
 			{
-				Node<type> *new_node = new Node<type>(value);
+				Node<type> *new_node = pool().create(value);
 
 				new_node->prev = &head;
 				new_node->next = head.next;
@@ -503,7 +803,7 @@ namespace flow {
 			 */
 			void prepend(type&& value)
 			{
-				Node<type> *new_node = new Node<type>(std::move(value));
+				Node<type> *new_node = pool().create(std::move(value));
 
 				new_node->prev = &head;
 				new_node->next = head.next;
@@ -524,14 +824,16 @@ namespace flow {
 			{
 				if (cur_size == 0) throw LinkedListErrors::EXTRACT_FROM_EMPTY_LIST;
 
-				type value = head.next->value;
+				type value = std::move(head.next->value);
 				Node<type> *new_front = head.next->next;
 
-				delete head.next;
+				pool().destroy(head.next);
 				cur_size--;
 
 				head.next = new_front;
 				new_front->prev = &head;
+
+				return value;
 			}
 
 			/**
@@ -544,10 +846,9 @@ namespace flow {
 			 */
 			void insert(size_t i, const type& value)
 			{
-				Node<type> *new_node = new Node<type>(value);
-
-				Node<type> next_node = get_node(i);
+				Node<type>& next_node = get_node(i);
 				Node<type> *prev_node = next_node.prev;
+				Node<type> *new_node = pool().create(value);
 
 				prev_node->next = new_node;
 				new_node->prev = prev_node;
@@ -567,10 +868,9 @@ namespace flow {
 			 */
 			void insert(size_t i, type&& value)
 			{
-				Node<type> *new_node = new Node<type>(std::move(value));
-
-				Node<type> next_node = get_node(i);
+				Node<type>& next_node = get_node(i);
 				Node<type> *prev_node = next_node.prev;
+				Node<type> *new_node = pool().create(std::move(value));
 
 				prev_node->next = new_node;
 				new_node->prev = prev_node;
@@ -589,7 +889,7 @@ namespace flow {
 			 */
 			void insert(Iterator& it, const type& value)
 			{
-				Node<type> *new_node = new Node<type>(value);
+				Node<type> *new_node = pool().create(value);
 
 				Node<type>& prev_node = it.get_node();
 				Node<type> *next_node = prev_node.next;
@@ -611,7 +911,7 @@ namespace flow {
 			 */
 			void insert(Iterator& it, type&& value)
 			{
-				Node<type> *new_node = new Node<type>(std::move(value));
+				Node<type> *new_node = pool().create(std::move(value));
 
 				Node<type>& prev_node = it.get_node();
 				Node<type> *next_node = prev_node.next;
@@ -638,15 +938,16 @@ namespace flow {
 				if (cur_size == 0)
 					throw LinkedListErrors::EXTRACT_FROM_EMPTY_LIST;
 
-				Node<type>& next_node = get_node(i);
-				Node<type> *prev_node = next_node.prev->prev;
-				type value = next_node.prev->value;
+				Node<type>& node_to_remove = get_node(i);
+				Node<type> *prev_node = node_to_remove.prev;
+				Node<type> *next_node = node_to_remove.next;
+				type value = std::move(node_to_remove.value);
 
-				delete next_node.prev;
+				pool().destroy(&node_to_remove);
 				cur_size--;
 
-				next_node.prev = prev_node;
-				prev_node->next = &next_node;
+				next_node->prev = prev_node;
+				prev_node->next = next_node;
 
 				return value;
 			}
@@ -668,9 +969,9 @@ namespace flow {
 				Node<type>& node_to_remove = it.get_node();
 				Node<type> *prev_node = node_to_remove.prev;
 				Node<type> *next_node = node_to_remove.next;
-				type value = node_to_remove.value;
+				type value = std::move(node_to_remove.value);
 
-				delete &node_to_remove;
+				pool().destroy(&node_to_remove);
 				cur_size--;
 
 				next_node->prev = prev_node;
@@ -683,26 +984,24 @@ namespace flow {
 			 *  @brief  Places another LinkedList at the end of
 			 *  this LinkedList.
 			 *  The values will be transfered to this LinkedList,
+			 *  together with the slabs of its node pool,
 			 *  and the other LinkedList will be reset.
+			 *  If the LinkedLists allocate their nodes from different Arenas
+			 *  or allocators, the values are moved into new nodes instead.
 			 *  @param  other  The other LinkedList.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(s), s = number of slabs of the other LinkedList,
+			 *  O(m), m = other.size(), if the values are moved
+			 *  @note  Memory: O(1), O(m) if the values are moved
 			 */
-			void attach(LinkedList<type>& other)
+			void attach(LinkedList& other)
 			{
 				if (this == &other)
 					throw LinkedListErrors::ATTACH_LIST_TO_ITSELF;
 
-				if (other.cur_size) {
-					tail.prev->next = other.head.next;
-					other.head.next->prev = tail.prev;
-					tail.prev = other.tail.prev;
-
-					cur_size += other.cur_size;
-
-					other.cur_size = 0;
-					other.head.next = NULL;
-					other.tail.prev = NULL;
+				if (!can_adopt(other)) {
+					move_values_before(other, &tail);
+				} else {
+					splice_before(other, &tail);
 				}
 			}
 
@@ -715,32 +1014,30 @@ namespace flow {
 			 *  @note  Runtime: O(1)
 			 *  @note  Memory: O(1)
 			 */
-			void operator+=(LinkedList<type>& other) { attach(other); }
+			void operator+=(LinkedList& other) { attach(other); }
 
 			/**
 			 *  @brief  Places another LinkedList at the beginning of
 			 *  this LinkedList.
 			 *  The values will be transfered to this LinkedList,
+			 *  together with the slabs of its node pool,
 			 *  and the other LinkedList will be reset.
+			 *  If the LinkedLists allocate their nodes from different Arenas
+			 *  or allocators, the values are moved into new nodes instead.
 			 *  @param  other  The other LinkedList.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(s), s = number of slabs of the other LinkedList,
+			 *  O(m), m = other.size(), if the values are moved
+			 *  @note  Memory: O(1), O(m) if the values are moved
 			 */
-			void precede(LinkedList<type>& other)
+			void precede(LinkedList& other)
 			{
 				if (this == &other)
 					throw LinkedListErrors::ATTACH_LIST_TO_ITSELF;
 
-				if (other.cur_size) {
-					head.next->prev = other.tail.prev;
-					other.tail.prev->next = head.next;
-					head.next = other.head.next;
-
-					cur_size += other.cur_size;
-
-					other.cur_size = 0;
-					other.head.next = NULL;
-					other.tail.prev = NULL;
+				if (!can_adopt(other)) {
+					move_values_before(other, head.next);
+				} else {
+					splice_before(other, head.next);
 				}
 			}
 	};
@@ -0,0 +1,564 @@
+#ifndef FLOW_PRIORITY_QUEUE_HEADER
+#define FLOW_PRIORITY_QUEUE_HEADER
+
+#include <bits/stdc++.h>
+
+#include "dynamic-array.hpp"
+
+namespace flow_priority_queue_tools {
+	/**
+	 *  @brief  Returns the index of the parent of the i-th node of a d-ary heap.
+	 */
+	template <size_t arity>
+	constexpr size_t heap_parent(size_t i)
+	{
+		return (i - 1) / arity;
+	}
+
+	/**
+	 *  @brief  Returns the index of the first child of the i-th node of a
+	 *  d-ary heap. The other children directly follow the first one.
+	 */
+	template <size_t arity>
+	constexpr size_t heap_first_child(size_t i)
+	{
+		return i * arity + 1;
+	}
+
+	/**
+	 *  @brief  A handle to an element of an IndexedPriorityQueue.
+	 *  A handle stays valid until its element is popped or erased,
+	 *  after which it may be reused for a newly pushed element.
+	 */
+	using PriorityQueueHandle = size_t;
+
+	/**
+	 *  @brief  An element of an IndexedPriorityQueue, stored on the heap
+	 *  together with its handle, so moving it around does not need to look
+	 *  anything up elsewhere.
+	 */
+	template <typename type>
+	struct IndexedHeapEntry {
+		type value;
+		PriorityQueueHandle handle;
+	};
+};
+
+namespace flow {
+	using namespace flow_priority_queue_tools;
+
+	enum class PriorityQueueErrors {
+		POP_EMPTY_PRIORITY_QUEUE,
+		INVALID_HANDLE
+	};
+
+	/**
+	 *  @brief  A priority queue, stored as a d-ary heap in a DynamicArray.
+	 *  The element that compares before all other elements is on top,
+	 *  so with the default std::less the smallest element is popped first.
+	 *  A node's children are stored next to each other, with the default
+	 *  arity of 4 they usually share a cache line, and the heap is half as
+	 *  deep as a binary heap.
+	 *  @tparam  type  The type of the elements.
+	 *  @tparam  Compare  Returns true if its first argument goes before its
+	 *  second argument.
+	 *  @tparam  arity  The number of children of every node.
+	 */
+	template <typename type, typename Compare = std::less<type>, size_t arity = 4>
+	class PriorityQueue {
+		static_assert(arity >= 2, "A heap needs at least 2 children per node");
+
+		private:
+			DynamicArray<type> heap;
+			Compare compare;
+
+			/**
+			 *  @brief  Moves a value up from a hole at the i-th node until
+			 *  its parent goes before it, and places it there.
+			 *  Parents are moved down into the hole instead of swapped.
+			 */
+			void sift_up(size_t i, type value)
+			{
+				while (i > 0) {
+					size_t parent = heap_parent<arity>(i);
+					if (!compare(value, heap[parent])) break;
+
+					heap[i] = std::move(heap[parent]);
+					i = parent;
+				}
+
+				heap[i] = std::move(value);
+			}
+
+			/**
+			 *  @brief  Moves a value down from a hole at the i-th node until
+			 *  it goes before all of its children, and places it there.
+			 *  Children are moved up into the hole instead of swapped.
+			 */
+			void sift_down(size_t i, type value)
+			{
+				size_t count = heap.size();
+
+				while (true) {
+					size_t first = heap_first_child<arity>(i);
+					if (first >= count) break;
+
+					size_t last = std::min(first + arity, count);
+					size_t best = first;
+
+					for (size_t child = first + 1; child < last; child++) {
+						if (compare(heap[child], heap[best])) best = child;
+					}
+
+					if (!compare(heap[best], value)) break;
+
+					heap[i] = std::move(heap[best]);
+					i = best;
+				}
+
+				heap[i] = std::move(value);
+			}
+
+			/**
+			 *  @brief  Restores the heap property bottom-up over all elements.
+			 *  @note  Runtime: O(n), n = size()
+			 */
+			void heapify()
+			{
+				size_t count = heap.size();
+				if (count < 2) return;
+
+				for (size_t i = heap_parent<arity>(count - 1) + 1; i-- > 0;) {
+					sift_down(i, std::move(heap[i]));
+				}
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an empty PriorityQueue.
+			 *  @param  compare  The comparison function object.
+			 */
+			PriorityQueue(const Compare& compare = Compare()) : compare(compare) {}
+
+			/**
+			 *  @brief  Creates a PriorityQueue from a range of values.
+			 *  @param  values  A pointer to the first value.
+			 *  @param  count  The number of values.
+			 *  @param  compare  The comparison function object.
+			 *  @note  Runtime: O(n), n = count
+			 *  @note  Memory: O(n), n = count
+			 */
+			PriorityQueue(
+				const type *values, size_t count, const Compare& compare = Compare()
+			) : compare(compare)
+			{
+				assign(values, count);
+			}
+
+			/**
+			 *  @brief  Creates a PriorityQueue from an iterator range.
+			 *  @param  first  The iterator to the first value.
+			 *  @param  last  The iterator past the last value.
+			 *  @param  compare  The comparison function object.
+			 *  @note  Runtime: O(n), n = number of values
+			 *  @note  Memory: O(n), n = number of values
+			 */
+			template <typename Iterator>
+			PriorityQueue(
+				Iterator first, Iterator last, const Compare& compare = Compare()
+			) : compare(compare)
+			{
+				assign(first, last);
+			}
+
+			/**
+			 *  @brief  Creates a PriorityQueue from the values of a DynamicArray.
+			 *  The DynamicArray is taken over, no values are copied.
+			 *  @param  values  The DynamicArray to take over.
+			 *  @param  compare  The comparison function object.
+			 *  @note  Runtime: O(n), n = values.size()
+			 *  @note  Memory: O(1)
+			 */
+			PriorityQueue(
+				DynamicArray<type>&& values, const Compare& compare = Compare()
+			) : heap(std::move(values)), compare(compare)
+			{
+				heapify();
+			}
+
+			/**
+			 *  @brief  Replaces the values of the PriorityQueue with a range
+			 *  of values.
+			 *  @param  values  A pointer to the first value.
+			 *  @param  count  The number of values.
+			 *  @note  Runtime: O(n), n = count
+			 *  @note  Memory: O(n), n = count
+			 */
+			void assign(const type *values, size_t count)
+			{
+				assign(values, values + count);
+			}
+
+			/**
+			 *  @brief  Replaces the values of the PriorityQueue with the values
+			 *  of an iterator range.
+			 *  @param  first  The iterator to the first value.
+			 *  @param  last  The iterator past the last value.
+			 *  @note  Runtime: O(n), n = number of values
+			 *  @note  Memory: O(n), n = number of values
+			 */
+			template <typename Iterator>
+			void assign(Iterator first, Iterator last)
+			{
+				heap = DynamicArray<type>();
+
+				for (Iterator it = first; it != last; ++it) {
+					heap.append(*it);
+				}
+
+				heapify();
+			}
+
+			/**
+			 *  @brief  Returns the number of elements in the PriorityQueue.
+			 */
+			size_t size() const
+			{
+				return heap.size();
+			}
+
+			/**
+			 *  @brief  Returns a read-only reference to the element on top.
+			 *  The PriorityQueue must not be empty.
+			 */
+			const type& top() const
+			{
+				return heap[0];
+			}
+
+			/**
+			 *  @brief  Pushes a value onto the PriorityQueue.
+			 *  @param  value  The value to push.
+			 *  @note  Runtime: O(log_d(n)), n = size()
+			 *  @note  Memory: O(1) amortised
+			 */
+			void push(const type& value)
+			{
+				push(type(value));
+			}
+
+			/**
+			 *  @brief  Pushes a value onto the PriorityQueue.
+			 *  @param  value  The value to push.
+			 *  @note  Runtime: O(log_d(n)), n = size()
+			 *  @note  Memory: O(1) amortised
+			 */
+			void push(type&& value)
+			{
+				heap.append(type());
+				sift_up(heap.size() - 1, std::move(value));
+			}
+
+			/**
+			 *  @brief  Removes the element on top and returns it.
+			 *  @note  Runtime: O(d * log_d(n)), n = size()
+			 *  @note  Memory: O(1) amortised
+			 */
+			type pop()
+			{
+				if (heap.size() == 0) {
+					throw PriorityQueueErrors::POP_EMPTY_PRIORITY_QUEUE;
+				}
+
+				type last = heap.extract_rear();
+				if (heap.size() == 0) return last;
+
+				type top_value = std::move(heap[0]);
+				sift_down(0, std::move(last));
+				return top_value;
+			}
+
+			/**
+			 *  @brief  Removes the element on top and pushes a value in one go.
+			 *  Cheaper than a pop() followed by a push(), since the heap is only
+			 *  walked down once.
+			 *  @param  value  The value to push.
+			 *  @returns  The element that was on top.
+			 *  @note  Runtime: O(d * log_d(n)), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			type replace_top(type value)
+			{
+				if (heap.size() == 0) {
+					throw PriorityQueueErrors::POP_EMPTY_PRIORITY_QUEUE;
+				}
+
+				type top_value = std::move(heap[0]);
+				sift_down(0, std::move(value));
+				return top_value;
+			}
+
+			/**
+			 *  @brief  Removes all elements from the PriorityQueue.
+			 */
+			void clear()
+			{
+				heap = DynamicArray<type>();
+			}
+	};
+
+	/**
+	 *  @brief  A priority queue, stored as a d-ary heap, whose elements can
+	 *  be updated and erased in place through the handle push() returns.
+	 *  Every element stores its handle next to it on the heap, and every
+	 *  handle stores the position of its element, so moving an element is
+	 *  a single extra write.
+	 *  @tparam  type  The type of the elements.
+	 *  @tparam  Compare  Returns true if its first argument goes before its
+	 *  second argument.
+	 *  @tparam  arity  The number of children of every node.
+	 */
+	template <typename type, typename Compare = std::less<type>, size_t arity = 4>
+	class IndexedPriorityQueue {
+		static_assert(arity >= 2, "A heap needs at least 2 children per node");
+
+		private:
+			static constexpr size_t NO_POSITION = SIZE_MAX;
+
+			DynamicArray<IndexedHeapEntry<type>> heap;
+
+			// The heap position of the element of every handle,
+			// NO_POSITION for handles that are not in use
+
+			DynamicArray<size_t> positions;
+
+			// Handles that are not in use, reused before new ones are made
+
+			DynamicArray<PriorityQueueHandle> free_handles;
+
+			Compare compare;
+
+			void place(size_t i, IndexedHeapEntry<type>&& entry)
+			{
+				positions[entry.handle] = i;
+				heap[i] = std::move(entry);
+			}
+
+			/**
+			 *  @brief  Moves an entry up from a hole at the i-th node until
+			 *  its parent goes before it, and places it there.
+			 *  @returns  The final position of the entry.
+			 */
+			size_t sift_up(size_t i, IndexedHeapEntry<type> entry)
+			{
+				while (i > 0) {
+					size_t parent = heap_parent<arity>(i);
+					if (!compare(entry.value, heap[parent].value)) break;
+
+					place(i, std::move(heap[parent]));
+					i = parent;
+				}
+
+				place(i, std::move(entry));
+				return i;
+			}
+
+			/**
+			 *  @brief  Moves an entry down from a hole at the i-th node until
+			 *  it goes before all of its children, and places it there.
+			 */
+			void sift_down(size_t i, IndexedHeapEntry<type> entry)
+			{
+				size_t count = heap.size();
+
+				while (true) {
+					size_t first = heap_first_child<arity>(i);
+					if (first >= count) break;
+
+					size_t last = std::min(first + arity, count);
+					size_t best = first;
+
+					for (size_t child = first + 1; child < last; child++) {
+						if (compare(heap[child].value, heap[best].value)) best = child;
+					}
+
+					if (!compare(heap[best].value, entry.value)) break;
+
+					place(i, std::move(heap[best]));
+					i = best;
+				}
+
+				place(i, std::move(entry));
+			}
+
+			/**
+			 *  @brief  Moves an entry from a hole at the i-th node to where
+			 *  it belongs, in whichever direction that is.
+			 */
+			void sift(size_t i, IndexedHeapEntry<type> entry)
+			{
+				if (sift_up(i, std::move(entry)) == i) {
+					sift_down(i, std::move(heap[i]));
+				}
+			}
+
+			size_t position_of(PriorityQueueHandle handle) const
+			{
+				if (!contains(handle)) throw PriorityQueueErrors::INVALID_HANDLE;
+				return positions[handle];
+			}
+
+			/**
+			 *  @brief  Removes the i-th entry from the heap and releases its handle.
+			 */
+			type remove_at(size_t i)
+			{
+				IndexedHeapEntry<type> last = heap.extract_rear();
+				PriorityQueueHandle handle = heap.size() == i
+					? last.handle : heap[i].handle;
+
+				positions[handle] = NO_POSITION;
+				free_handles.append(handle);
+
+				if (heap.size() == i) return std::move(last.value);
+
+				type value = std::move(heap[i].value);
+				sift(i, std::move(last));
+				return value;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an empty IndexedPriorityQueue.
+			 *  @param  compare  The comparison function object.
+			 */
+			IndexedPriorityQueue(const Compare& compare = Compare())
+				: compare(compare) {}
+
+			/**
+			 *  @brief  Returns the number of elements in the IndexedPriorityQueue.
+			 */
+			size_t size() const
+			{
+				return heap.size();
+			}
+
+			/**
+			 *  @brief  Checks if a handle refers to an element that is
+			 *  currently in the IndexedPriorityQueue.
+			 */
+			bool contains(PriorityQueueHandle handle) const
+			{
+				return handle < positions.size() && positions[handle] != NO_POSITION;
+			}
+
+			/**
+			 *  @brief  Returns a read-only reference to the element on top.
+			 *  The IndexedPriorityQueue must not be empty.
+			 */
+			const type& top() const
+			{
+				return heap[0].value;
+			}
+
+			/**
+			 *  @brief  Returns the handle of the element on top.
+			 *  The IndexedPriorityQueue must not be empty.
+			 */
+			PriorityQueueHandle top_handle() const
+			{
+				return heap[0].handle;
+			}
+
+			/**
+			 *  @brief  Returns a read-only reference to the element of a handle.
+			 *  @param  handle  The handle of the element.
+			 */
+			const type& get(PriorityQueueHandle handle) const
+			{
+				return heap[position_of(handle)].value;
+			}
+
+			/**
+			 *  @brief  Pushes a value onto the IndexedPriorityQueue.
+			 *  @param  value  The value to push.
+			 *  @returns  The handle of the new element.
+			 *  @note  Runtime: O(log_d(n)), n = size()
+			 *  @note  Memory: O(1) amortised
+			 */
+			PriorityQueueHandle push(type value)
+			{
+				PriorityQueueHandle handle;
+
+				if (free_handles.size() != 0) {
+					handle = free_handles.extract_rear();
+				} else {
+					handle = positions.size();
+					positions.append(NO_POSITION);
+				}
+
+				heap.append(IndexedHeapEntry<type>());
+				sift_up(heap.size() - 1, { std::move(value), handle });
+				return handle;
+			}
+
+			/**
+			 *  @brief  Removes the element on top and returns it.
+			 *  Its handle is released.
+			 *  @note  Runtime: O(d * log_d(n)), n = size()
+			 *  @note  Memory: O(1) amortised
+			 */
+			type pop()
+			{
+				if (heap.size() == 0) {
+					throw PriorityQueueErrors::POP_EMPTY_PRIORITY_QUEUE;
+				}
+
+				return remove_at(0);
+			}
+
+			/**
+			 *  @brief  Replaces the value of an element and moves it to its new
+			 *  place in the heap. The value may go either before or after the
+			 *  old value.
+			 *  @param  handle  The handle of the element.
+			 *  @param  value  The new value.
+			 *  @note  Runtime: O(d * log_d(n)), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			void update(PriorityQueueHandle handle, type value)
+			{
+				size_t i = position_of(handle);
+				sift(i, { std::move(value), handle });
+			}
+
+			/**
+			 *  @brief  Replaces the value of an element with a value that does
+			 *  not go after the old value, and moves it up the heap.
+			 *  Cheaper than update(), since the element only moves up.
+			 *  @param  handle  The handle of the element.
+			 *  @param  value  The new value.
+			 *  @note  Runtime: O(log_d(n)), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			void decrease_key(PriorityQueueHandle handle, type value)
+			{
+				size_t i = position_of(handle);
+				sift_up(i, { std::move(value), handle });
+			}
+
+			/**
+			 *  @brief  Removes the element of a handle and returns it.
+			 *  The handle is released.
+			 *  @param  handle  The handle of the element.
+			 *  @note  Runtime: O(d * log_d(n)), n = size()
+			 *  @note  Memory: O(1) amortised
+			 */
+			type erase(PriorityQueueHandle handle)
+			{
+				return remove_at(position_of(handle));
+			}
+	};
+};
+
+#endif
@@ -4,44 +4,16 @@
 #include <bits/stdc++.h>
 
 #include "dynamic-array.hpp"
-#include "../iterators/node-list-iterator.hpp"
+#include "../iterators/ring-buffer-iterator.hpp"
 
 namespace flow_queue_tools {
+	/**
+	 *  @brief  A contiguous range of elements of a Queue.
+	 */
 	template <typename type>
-	class QueueNode {
-		public:
-			QueueNode *next;
-			type value;
-
-			QueueNode() {}
-
-			QueueNode(const type& value, QueueNode<type> *next = NULL)
-				: value(value), next(next) {}
-
-			QueueNode(type&& value, QueueNode<type> *next = NULL)
-				: value(std::move(value)), next(next) {}
-
-			QueueNode<type>& operator=(const QueueNode<type>& other)
-			{
-				if (this == &other) return *this;
-
-				value = other.value;
-				next = other.next;
-
-				return *this;
-			}
-
-			QueueNode<type>& operator=(QueueNode<type>&& other)
-			{
-				if (this == &other) return *this;
-
-				value = std::move(other.value);
-				next = other.next;
-
-				other.value = NULL;
-
-				return *this;
-			}
+	struct QueueSegment {
+		type *data;
+		size_t size;
 	};
 };
 
@@ -54,18 +26,142 @@ namespace flow {
 		ATTACH_QUEUE_TO_ITSELF
 	};
 
-	template <typename type>
+	/**
+	 *  @brief  A double ended queue, stored in a growable ring buffer.
+	 *  The capacity is always a power of 2, so positions wrap around with a
+	 *  mask. The ring buffer only grows, so a Queue that is pushed and popped
+	 *  at a steady rate does not allocate.
+	 *  The ring buffer is always on the heap, and so are the elements,
+	 *  whichever ArenaScope is active when they are added.
+	 *  @tparam  type  The type of data stored in the Queue.
+	 *  @tparam  Allocator  The allocator of the ring buffer. A stateless
+	 *  allocator takes up no space.
+	 */
+	template <typename type, typename Allocator = std::allocator<type>>
 	class Queue {
 		private:
+			static constexpr size_t MIN_CAPACITY = 8;
+
+			type *buffer = NULL;
+			size_t capacity = 0;
+
+			// Position of the first element in the buffer
+
+			size_t head = 0;
 			size_t current_element_count = 0;
-			QueueNode<type> *first = NULL;
-			QueueNode<type> *last = NULL;
+
+			[[no_unique_address]] Allocator allocator;
+
+			using AllocatorTraits = std::allocator_traits<Allocator>;
+
+			type *slot(size_t offset) const
+			{
+				return buffer + ((head + offset) & (capacity - 1));
+			}
+
+			/**
+			 *  @brief  Moves all elements to a new buffer of a given capacity,
+			 *  the first element is placed at the start of the new buffer.
+			 */
+			void resize_buffer(size_t new_capacity)
+			{
+				type *new_buffer = AllocatorTraits::allocate(allocator, new_capacity);
+				ArenaScope heap_scope(NULL);
+
+				for (size_t i = 0; i < current_element_count; i++) {
+					type *old_slot = slot(i);
+					new (new_buffer + i) type(std::move(*old_slot));
+					old_slot->~type();
+				}
+
+				if (buffer != NULL) AllocatorTraits::deallocate(allocator, buffer, capacity);
+
+				buffer = new_buffer;
+				capacity = new_capacity;
+				head = 0;
+			}
+
+			void grow_if_full()
+			{
+				if (current_element_count == capacity) {
+					resize_buffer(capacity == 0 ? MIN_CAPACITY : capacity * 2);
+				}
+			}
 
 		public:
 			/**
 			 *  @brief  Creates a Queue
+			 *  @param  allocator  The allocator of the ring buffer.
 			 */
-			Queue() {}
+			Queue(const Allocator& allocator = Allocator()) : allocator(allocator) {}
+
+			/**
+			 *  @brief  Copy constructor.
+			 *  @note  Runtime: O(n), n = other.size()
+			 *  @note  Memory: O(n), n = other.size()
+			 */
+			Queue(const Queue& other)
+				: allocator(AllocatorTraits::select_on_container_copy_construction(
+					other.allocator))
+			{
+				reserve(other.size());
+				ArenaScope heap_scope(NULL);
+
+				for (size_t i = 0; i < other.size(); i++) {
+					new (buffer + i) type(*other.slot(i));
+				}
+
+				current_element_count = other.size();
+			}
+
+			/**
+			 *  @brief  Move constructor.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			Queue(Queue&& other)
+				: buffer(other.buffer), capacity(other.capacity),
+				head(other.head), current_element_count(other.current_element_count),
+				allocator(std::move(other.allocator))
+			{
+				other.buffer = NULL;
+				other.capacity = 0;
+				other.head = 0;
+				other.current_element_count = 0;
+			}
+
+			/**
+			 *  @brief  Copy assignment operator.
+			 *  @note  Runtime: O(n + m), n = size(), m = other.size()
+			 *  @note  Memory: O(m), m = other.size()
+			 */
+			Queue& operator=(const Queue& other)
+			{
+				if (this == &other) return *this;
+
+				Queue copy(other);
+				*this = std::move(copy);
+
+				return *this;
+			}
+
+			/**
+			 *  @brief  Move assignment operator.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			Queue& operator=(Queue&& other)
+			{
+				if (this == &other) return *this;
+
+				std::swap(buffer, other.buffer);
+				std::swap(capacity, other.capacity);
+				std::swap(head, other.head);
+				std::swap(current_element_count, other.current_element_count);
+				std::swap(allocator, other.allocator);
+
+				return *this;
+			}
 
 			/**
 			 *  @brief  Deletes all elements on this Queue.
@@ -74,13 +170,11 @@ namespace flow {
 			 */
 			~Queue()
 			{
-				QueueNode<type> *node = first;
-
 				for (size_t i = 0; i < current_element_count; i++) {
-					QueueNode<type> *next_node = node->next;
-					delete node;
-					node = next_node;
+					slot(i)->~type();
 				}
+
+				if (buffer != NULL) AllocatorTraits::deallocate(allocator, buffer, capacity);
 			}
 
 			/**
@@ -91,6 +185,59 @@ namespace flow {
 				return current_element_count;
 			}
 
+			/**
+			 *  @brief  Returns a copy of the allocator of the ring buffer.
+			 */
+			Allocator get_allocator() const
+			{
+				return allocator;
+			}
+
+			/**
+			 *  @brief  Returns the number of elements the Queue can hold
+			 *  before it has to grow.
+			 */
+			size_t current_capacity() const
+			{
+				return capacity;
+			}
+
+			/**
+			 *  @brief  Makes sure the Queue can hold a number of elements
+			 *  without growing. The capacity is rounded up to a power of 2.
+			 *  @param  size  The total number of elements to reserve space for.
+			 *  @note  Runtime: O(n) if a resize is needed, O(1) otherwise, n = size()
+			 *  @note  Memory: O(1)
+			 */
+			void reserve(size_t size)
+			{
+				if (size <= capacity) return;
+				resize_buffer(std::bit_ceil(std::max(size, MIN_CAPACITY)));
+			}
+
+			/**
+			 *  @brief  Shrinks the buffer to the smallest power of 2 that
+			 *  fits all elements. Releases the buffer if the Queue is empty.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			void shrink_to_fit()
+			{
+				if (current_element_count == 0) {
+					if (buffer != NULL) AllocatorTraits::deallocate(allocator, buffer, capacity);
+
+					buffer = NULL;
+					capacity = 0;
+					head = 0;
+					return;
+				}
+
+				size_t new_capacity = std::bit_ceil(
+					std::max(current_element_count, MIN_CAPACITY));
+
+				if (new_capacity < capacity) resize_buffer(new_capacity);
+			}
+
 			/**
 			 *  @brief  Returns a read-only reference to the value of the first
 			 *  element on the Queue.
@@ -99,7 +246,7 @@ namespace flow {
 			 */
 			const type& front() const
 			{
-				return first->value;
+				return *slot(0);
 			}
 
 			/**
@@ -110,7 +257,7 @@ namespace flow {
 			 */
 			type& front()
 			{
-				return first->value;
+				return *slot(0);
 			}
 
 			/**
@@ -121,7 +268,7 @@ namespace flow {
 			 */
 			const type& back() const
 			{
-				return last->value;
+				return *slot(current_element_count - 1);
 			}
 
 			/**
@@ -132,20 +279,50 @@ namespace flow {
 			 */
 			type& back()
 			{
-				return last->value;
+				return *slot(current_element_count - 1);
+			}
+
+			/**
+			 *  @brief  Returns the first contiguous range of elements, which
+			 *  runs from the front of the Queue to the end of the buffer or the
+			 *  back of the Queue. Together with second_segment() it covers all
+			 *  elements in order, so they can be processed with memcpy or writev.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			QueueSegment<type> first_segment() const
+			{
+				if (current_element_count == 0) return { buffer, 0 };
+
+				return {
+					buffer + head,
+					std::min(current_element_count, capacity - head)
+				};
+			}
+
+			/**
+			 *  @brief  Returns the elements that wrapped around to the start
+			 *  of the buffer, see first_segment(). The size is 0 if there are
+			 *  none.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			QueueSegment<type> second_segment() const
+			{
+				return { buffer, current_element_count - first_segment().size };
 			}
 
 			/**
-			 *  @brief  Read/write iterator for the data in the LinkedList nodes.
+			 *  @brief  Read/write iterator for the data in the Queue.
 			 *  Iteration is done in-order.
 			 */
-			using Iterator = NodeListIterator<type, QueueNode<type>, false, false>;
+			using Iterator = RingBufferIterator<type, false>;
 
 			/**
-			 *  @brief  Read-only iterator for the data in the LinkedList nodes.
+			 *  @brief  Read-only iterator for the data in the Queue.
 			 *  Iteration is done in-order.
 			 */
-			using ConstIterator = NodeListIterator<type, QueueNode<type>, true, false>;
+			using ConstIterator = RingBufferIterator<type, true>;
 
 			/**
 			 *  @brief  Returns a read/write iterator that points to the first
@@ -153,7 +330,7 @@ namespace flow {
 			 */
 			Iterator begin()
 			{
-				return Iterator(first);
+				return Iterator(buffer, capacity - 1, head);
 			}
 
 			/**
@@ -162,7 +339,7 @@ namespace flow {
 			 */
 			Iterator end()
 			{
-				return Iterator(NULL);
+				return Iterator(buffer, capacity - 1, head + current_element_count);
 			}
 
 			/**
@@ -171,7 +348,7 @@ namespace flow {
 			 */
 			ConstIterator cbegin() const
 			{
-				return ConstIterator(first);
+				return ConstIterator(buffer, capacity - 1, head);
 			}
 
 			/**
@@ -180,41 +357,35 @@ namespace flow {
 			 */
 			ConstIterator cend() const
 			{
-				return ConstIterator(NULL);
+				return ConstIterator(buffer, capacity - 1, head + current_element_count);
 			}
 
 			/**
 			 *  @brief  Returns a read-only reference to the value at the i-th
 			 *  element in the Queue.
 			 *  @param  offset  i
-			 *  @note  Runtime: O(n)
+			 *  @note  Runtime: O(1)
 			 *  @note  Memory: O(1)
 			 */
 			const type& operator[](size_t offset) const
 			{
 				if (offset >= current_element_count) throw QueueErrors::INDEX_OUT_OF_BOUNDS;
 
-				QueueNode<type> *node = first;
-				for (size_t i = 0; i < offset; i++) node = node->next;
-
-				return node->value;
+				return *slot(offset);
 			}
 
 			/**
 			 *  @brief  Returns a read/write reference to the value at the i-th
 			 *  element in the Queue.
 			 *  @param  offset  i
-			 *  @note  Runtime: O(n)
+			 *  @note  Runtime: O(1)
 			 *  @note  Memory: O(1)
 			 */
 			type& operator[](size_t offset)
 			{
 				if (offset >= current_element_count) throw QueueErrors::INDEX_OUT_OF_BOUNDS;
 
-				QueueNode<type> *node = first;
-				for (size_t i = 0; i < offset; i++) node = node->next;
-
-				return node->value;
+				return *slot(offset);
 			}
 
 			/**
@@ -226,11 +397,8 @@ namespace flow {
 			 */
 			ssize_t first_index_of(const type& value) const
 			{
-				QueueNode<type> *node = first;
-
 				for (size_t i = 0; i < current_element_count; i++) {
-					if (node->value == value) return i;
-					node = node->next;
+					if (*slot(i) == value) return i;
 				}
 
 				return -1;
@@ -245,11 +413,9 @@ namespace flow {
 			DynamicArray<size_t> indices_of(const type& value) const
 			{
 				DynamicArray<size_t> indices;
-				QueueNode<type> *node = first;
 
 				for (size_t i = 0; i < current_element_count; i++) {
-					if (node->value == value) indices.append(i);
-					node = node->next;
+					if (*slot(i) == value) indices.append(i);
 				}
 
 				return indices;
@@ -259,57 +425,37 @@ namespace flow {
 			 *  @brief  Swaps the values at two indices of the Queue.
 			 *  @param  index_1  The first index.
 			 *  @param  index_2  The second index.
-			 *  @note  Runtime: O(n)
+			 *  @note  Runtime: O(1)
 			 *  @note  Memory: O(1)
 			 */
 			void swap_indices(size_t index_1, size_t index_2)
 			{
 				if (index_1 == index_2) return;
-				if (index_1 > current_element_count) throw QueueErrors::INDEX_OUT_OF_BOUNDS;
-				if (index_2 > current_element_count) throw QueueErrors::INDEX_OUT_OF_BOUNDS;
+				if (index_1 >= current_element_count) throw QueueErrors::INDEX_OUT_OF_BOUNDS;
+				if (index_2 >= current_element_count) throw QueueErrors::INDEX_OUT_OF_BOUNDS;
 
-				// Get the smallest and biggest index
-
-				size_t small_index = std::min(index_1, index_2);
-				size_t big_index = std::max(index_1, index_2);
-
-				// Get the node at index_1 and index_2
-
-				QueueNode<type> *node_1 = first;
-
-				for (size_t i = 0; i < small_index; i++) {
-					node_1 = node_1->next;
-				}
-
-				QueueNode<type> *node_2 = node_1;
-
-				for (size_t i = 0; i < big_index - small_index; i++) {
-					node_2 = node_2->next;
-				}
-
-				// Swap their values
-
-				type node_1_value = node_1->value;
-				node_1->value = node_2->value;
-				node_2->value = node_1_value;
+				std::swap(*slot(index_1), *slot(index_2));
 			}
 
 			/**
 			 *  @brief  Places a value at the end of the Queue.
 			 *  @param  value  A reference to the value to push.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			void push(const type& value)
 			{
-				QueueNode<type> *new_node = new QueueNode<type>(value);
+				ArenaScope heap_scope(NULL);
 
-				if (current_element_count == 0) {
-					first = new_node;
-					last = new_node;
+				// The value may be an element of the Queue, which growing
+				// moves, so it is copied before the buffer is replaced
+
+				if (current_element_count == capacity) {
+					type copy(value);
+					grow_if_full();
+					new (slot(current_element_count)) type(std::move(copy));
 				} else {
-					last->next = new_node;
-					last = new_node;
+					new (slot(current_element_count)) type(value);
 				}
 
 				current_element_count++;
@@ -318,19 +464,19 @@ namespace flow {
 			/**
 			 *  @brief  Places a value at the end of the Queue.
 			 *  @param  value  A reference to the value to push.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			void push(type&& value)
 			{
-				QueueNode<type> *new_node = new QueueNode<type>(std::move(value));
+				ArenaScope heap_scope(NULL);
 
-				if (current_element_count == 0) {
-					first = new_node;
-					last = new_node;
+				if (current_element_count == capacity) {
+					type moved(std::move(value));
+					grow_if_full();
+					new (slot(current_element_count)) type(std::move(moved));
 				} else {
-					last->next = new_node;
-					last = new_node;
+					new (slot(current_element_count)) type(std::move(value));
 				}
 
 				current_element_count++;
@@ -339,35 +485,40 @@ namespace flow {
 			/**
 			 *  @brief  Places a value to the end of the Queue.
 			 *  @param  value  A reference to the value to push.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			void operator+=(const type& value) { push(value); }
 
 			/**
 			 *  @brief  Places a value to the end of the Queue.
 			 *  @param  value  A reference to the value to push.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			void operator+=(type&& value) { push(std::move(value)); }
 
 			/**
 			 *  @brief  Places a value before at the start of the Queue.
 			 *  @param  value  A reference to the value to add to the Queue.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			void prepend(const type& value)
 			{
-				QueueNode<type> *new_node = new QueueNode<type>(value);
+				ArenaScope heap_scope(NULL);
 
-				if (current_element_count == 0) {
-					first = new_node;
-					last = new_node;
+				// The value may be an element of the Queue, which growing
+				// moves, so it is copied before the buffer is replaced
+
+				if (current_element_count == capacity) {
+					type copy(value);
+					grow_if_full();
+					head = (head - 1) & (capacity - 1);
+					new (buffer + head) type(std::move(copy));
 				} else {
-					new_node->next = first;
-					first = new_node;
+					head = (head - 1) & (capacity - 1);
+					new (buffer + head) type(value);
 				}
 
 				current_element_count++;
@@ -376,19 +527,21 @@ namespace flow {
 			/**
 			 *  @brief  Places a value before at the start of the Queue.
 			 *  @param  value  A reference to the value to add to the Queue.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			void prepend(type&& value)
 			{
-				QueueNode<type> *new_node = new QueueNode<type>(std::move(value));
+				ArenaScope heap_scope(NULL);
 
-				if (current_element_count == 0) {
-					first = new_node;
-					last = new_node;
+				if (current_element_count == capacity) {
+					type moved(std::move(value));
+					grow_if_full();
+					head = (head - 1) & (capacity - 1);
+					new (buffer + head) type(std::move(moved));
 				} else {
-					new_node->next = first;
-					first = new_node;
+					head = (head - 1) & (capacity - 1);
+					new (buffer + head) type(std::move(value));
 				}
 
 				current_element_count++;
@@ -396,59 +549,62 @@ namespace flow {
 
 			/**
 			 *  @brief  Places another Queue at the end of this Queue.
-			 *  The values will be transfered to this Queue, and the other
-			 *  Queue will be reset.
+			 *  The values will be moved to this Queue, and the other
+			 *  Queue will be emptied.
 			 *  @param  other_queue  The other Queue.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(m), m = other_queue.size()
+			 *  @note  Memory: O(m), m = other_queue.size()
 			 */
-			void attach(Queue<type>& other_queue) {
+			void attach(Queue& other_queue) {
 				if (this == &other_queue) throw QueueErrors::ATTACH_QUEUE_TO_ITSELF;
 
-				if (other_queue.size()) {
-					last->next = other_queue.first;
-					last = other_queue.last;
+				if (current_element_count == 0) {
+					std::swap(*this, other_queue);
+					return;
+				}
 
-					current_element_count += other_queue.current_element_count;
+				reserve(current_element_count + other_queue.size());
+				ArenaScope heap_scope(NULL);
 
-					other_queue.current_element_count = 0;
-					other_queue.first = NULL;
-					other_queue.last = NULL;
+				while (other_queue.size() != 0) {
+					new (slot(current_element_count)) type(
+						std::move(*other_queue.slot(0)));
+					current_element_count++;
+					other_queue.pop_front_unchecked();
 				}
 			}
 
 			/**
 			 *  @brief  Places another Queue at the end of this Queue.
-			 *  The values will be transfered to this Queue, and the other
-			 *  Queue will be reset.
+			 *  The values will be moved to this Queue, and the other
+			 *  Queue will be emptied.
 			 *  @param  other_queue  The other Queue.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(m), m = other_queue.size()
+			 *  @note  Memory: O(m), m = other_queue.size()
 			 */
-			void operator+=(Queue<type>& other_queue) { attach(other_queue); }
+			void operator+=(Queue& other_queue) { attach(other_queue); }
 
 			/**
 			 *  @brief  Places another Queue at the beginning of this Queue.
-			 *  The values will be transfered to this Queue, and the other
-			 *  Queue will be reset.
+			 *  The values will be moved to this Queue, and the other
+			 *  Queue will be emptied.
 			 *  @param  other_queue  The other queue.
-			 *  @note  Runtime: O(1)
-			 *  @note  Memory: O(1)
+			 *  @note  Runtime: O(m), m = other_queue.size()
+			 *  @note  Memory: O(m), m = other_queue.size()
 			 */
-			void precede(Queue<type>& other_queue) {
+			void precede(Queue& other_queue) {
 				if (this == &other_queue) return;
 
-				if (other_queue.size()) {
-					QueueNode<type> *old_first = first;
-
-					first = other_queue.first;
-					other_queue.last->next = old_first;
+				if (current_element_count == 0) {
+					std::swap(*this, other_queue);
+					return;
+				}
 
-					current_element_count += other_queue.current_element_count;
+				reserve(current_element_count + other_queue.size());
 
-					other_queue.current_element_count = 0;
-					other_queue.first = NULL;
-					other_queue.last = NULL;
+				while (other_queue.size() != 0) {
+					prepend(std::move(other_queue.back()));
+					other_queue.pop_back_unchecked();
 				}
 			}
 
@@ -461,16 +617,41 @@ namespace flow {
 			{
 				if (current_element_count == 0) throw QueueErrors::POP_EMPTY_QUEUE;
 
-				QueueNode<type> *new_first = first->next;
-				type value = first->value;
+				type value = std::move(front());
+				pop_front_unchecked();
 
-				delete first;
-				current_element_count--;
-				first = new_first;
+				return value;
+			}
+
+			/**
+			 *  @brief  Deletes the last element of the Queue and returns it.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			type extract_rear()
+			{
+				if (current_element_count == 0) throw QueueErrors::POP_EMPTY_QUEUE;
+
+				type value = std::move(back());
+				pop_back_unchecked();
 
 				return value;
 			}
+
+		private:
+			void pop_front_unchecked()
+			{
+				buffer[head].~type();
+				head = (head + 1) & (capacity - 1);
+				current_element_count--;
+			}
+
+			void pop_back_unchecked()
+			{
+				back().~type();
+				current_element_count--;
+			}
 	};
 };
 
-#endif
\ No newline at end of file
+#endif
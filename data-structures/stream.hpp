@@ -93,10 +93,12 @@ namespace flow {
 			 *  @brief  Alias for Stream::write_event::add_listener().
 			 *  @param  callback  This function will be executed when the Stream
 			 *  receives new data.
+			 *  @returns  The id of the listener, to pass to
+			 *  Stream::write_event::remove_listener().
 			 */
-			void on_data(std::function<void(type)>&& callback)
+			event_id_t on_data(typename EventEmitter<type>::callback_t&& callback)
 			{
-				write_event.add_listener(std::move(callback));
+				return write_event.add_listener(std::move(callback));
 			}
 	};
 };
@@ -3,6 +3,10 @@
 
 #include <bits/stdc++.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace flow_tools {
 	template <char starting_alphabetical_digit = 'A'>
 	char get_base_digit(uint8_t num) {
@@ -13,6 +17,77 @@ namespace flow_tools {
 		return starting_alphabetical_digit - 10 + num;
 	}
 
+	// "00", "01", ..., "99", used to write two decimal digits at once
+
+	inline constexpr char DIGIT_PAIRS[201] =
+		"0001020304050607080910111213141516171819"
+		"2021222324252627282930313233343536373839"
+		"4041424344454647484950515253545556575859"
+		"6061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+	// 10^0, 10^1, ..., 10^19, every power of ten that fits in 64 bits
+
+	inline constexpr uint64_t POW10_U64[20] = {
+		1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+		10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+		100000000000ull, 1000000000000ull, 10000000000000ull,
+		100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+		100000000000000000ull, 1000000000000000000ull,
+		10000000000000000000ull
+	};
+
+	/**
+	 *  @brief  Counts the number of base 10 digits of an unsigned integer.
+	 *  The count is estimated from the bit width with log10(2) ~ 1233 / 4096,
+	 *  and corrected with a single comparison.
+	 *  @param  num  The number to count the digits of, at most 64 bits wide.
+	 *  @returns  The number of digits, which is 1 for 0.
+	 */
+	template <typename uintx_t>
+	size_t count_digits(uintx_t num)
+	{
+		// Powers of ten are even, so setting the lowest bit keeps the count
+		// the same for every number except 0, which now counts as 1 digit
+
+		uint64_t n = (uint64_t) num | 1;
+		size_t estimate = (std::bit_width(n) * 1233) >> 12;
+
+		return estimate + (n >= POW10_U64[estimate]);
+	}
+
+	/**
+	 *  @brief  Writes the digits of an unsigned integer to a string, when
+	 *  the number of digits is already known. Does not check if there is
+	 *  enough space left on the buffer. Base 10 numbers are written two
+	 *  digits at a time.
+	 *  @tparam  base  In what number system to display the number, defaults to 10.
+	 *  @tparam  starting_alphabetical_digit  'a' or 'A', defaults to 'A'.
+	 *  @param  num  The number to write.
+	 *  @param  buf  The character buffer to write the number to.
+	 *  @param  len  The number of digits to write, higher digits are cut off
+	 *  and missing digits are written as leading zeros.
+	 */
+	template <uint8_t base = 10, char starting_alphabetical_digit = 'A',
+		typename uintx_t>
+	void write_uint_digits(uintx_t num, char *buf, size_t len)
+	{
+		if constexpr (base == 10) {
+			while (len >= 2) {
+				memcpy(buf + len - 2, DIGIT_PAIRS + num % 100 * 2, 2);
+				num /= 100;
+				len -= 2;
+			}
+
+			if (len != 0) buf[0] = '0' + num % 10;
+		} else {
+			for (size_t i = len; i != 0; i--) {
+				buf[i - 1] = get_base_digit<starting_alphabetical_digit>(num % base);
+				num /= base;
+			}
+		}
+	}
+
 	/**
 	 *  @brief  Writes an unsigned integer to a string. Does not check if
 	 *  there is enough space left on the buffer.
@@ -35,17 +110,12 @@ namespace flow_tools {
 	size_t write_uint_to_str(uintx_t num, char *buf,
 		char pad_char = '\0', size_t pad_size = 0)
 	{
-		if (num == 0) {
-			*buf = '0';
-			return 1;
-		}
-
-		uintx_t n = num;
-		size_t length = 0;
+		size_t length = 1;
 
-		while (n != 0) {
-			length++;
-			n /= base;
+		if constexpr (base == 10) {
+			length = count_digits(num);
+		} else {
+			for (uintx_t n = num / base; n != 0; n /= base) length++;
 		}
 
 		size_t remaining_pad_size;
@@ -53,15 +123,9 @@ namespace flow_tools {
 		if (pad_size > length) remaining_pad_size = pad_size - length;
 		else remaining_pad_size = 0;
 
-		for (size_t i = 0; i < remaining_pad_size; i++) {
-			*buf++ = pad_char;
-		}
-
-		for (size_t i = length; i != 0; i--) {
-			char digit = get_base_digit<starting_alphabetical_digit>(num % base);
-			buf[i - 1] = digit;
-			num /= base;
-		}
+		memset(buf, pad_char, remaining_pad_size);
+		write_uint_digits<base, starting_alphabetical_digit>(
+			num, buf + remaining_pad_size, length);
 
 		return length + remaining_pad_size;
 	}
@@ -88,57 +152,117 @@ namespace flow_tools {
 	size_t write_int_to_str(intx_t num, char *buf,
 		char pad_char = '\0', size_t pad_size = 0)
 	{
-		if (num == 0) {
-			*buf = '0';
-			return 1;
+		using uintx_t = std::make_unsigned_t<intx_t>;
+
+		if (num >= 0) {
+			return write_uint_to_str<base, uintx_t, starting_alphabetical_digit>(
+				num, buf, pad_char, pad_size);
 		}
 
-		constexpr intx_t sign_bit = (intx_t) 1 << (sizeof(intx_t) * 8 - 1);
-		bool is_signed = num & sign_bit;
-		int8_t multiplier = 1;
+		*buf = '-';
 
-		if (is_signed) {
-			*buf++ = '-';
-			num = ~num + 1;
-		}
+		return 1 + write_uint_to_str<base, uintx_t, starting_alphabetical_digit>(
+			(uintx_t) 0 - (uintx_t) num, buf + 1, pad_char,
+			pad_size != 0 ? pad_size - 1 : 0);
+	}
 
-		if (is_signed && (num ^ sign_bit) == 0) {
-			multiplier = -1;
-		}
+	struct UintFromStr {
+		uint64_t val;
+		size_t len;
 
-		size_t length = 0;
-		intx_t n = num;
+		// Set if the number does not fit in 64 bits, val is then undefined
 
-		while (n != 0) {
-			length++;
-			n /= base;
-		}
+		bool overflow = false;
+	};
 
-		size_t remaining_pad_size;
+	/**
+	 *  @brief  Checks if 8 characters, loaded as a little endian 64-bit
+	 *  integer, are all base 10 digits.
+	 */
+	inline bool is_8_digits(uint64_t chunk)
+	{
+		return (chunk & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030
+			&& ((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0)
+				== 0x3030303030303030;
+	}
 
-		if (pad_size > length) remaining_pad_size = pad_size - length;
-		else remaining_pad_size = 0;
-		if (remaining_pad_size != 0 && is_signed) remaining_pad_size--;
+	/**
+	 *  @brief  Parses 8 base 10 digits, loaded as a little endian 64-bit
+	 *  integer, by combining adjacent digits into pairs, quads and octets.
+	 */
+	inline uint32_t parse_8_digits(uint64_t chunk)
+	{
+		chunk -= 0x3030303030303030;
+		chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FF;
+		chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFF;
+		chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFF;
+
+		return chunk;
+	}
+
+	/**
+	 *  @brief  Reads an unsigned integer in base 10 format from a string.
+	 *  Reads digits until the first non-digit character or the end of the
+	 *  buffer. Runs of 16 and 8 digits are parsed at once.
+	 *  If the number does not fit in 64 bits, the overflow flag is set and
+	 *  the remaining digits are still consumed.
+	 *  @param  buf  The character buffer to read the unsigned integer from.
+	 *  @param  buf_len  The size of the character buffer.
+	 *  @returns  A UintFromStr structure, containing the value of the number
+	 *  in and the length of the read number in number of bytes.
+	 */
+	inline UintFromStr read_uint_from_str(const char *buf, size_t buf_len)
+	{
+		UintFromStr num_and_len = { 0, 0 };
+
+		if constexpr (std::endian::native == std::endian::little) {
+			while (buf_len - num_and_len.len >= 16) {
+				uint64_t hi, lo;
+				memcpy(&hi, buf + num_and_len.len, 8);
+				memcpy(&lo, buf + num_and_len.len + 8, 8);
+
+				if (!is_8_digits(hi) || !is_8_digits(lo)) break;
+
+				uint64_t chunk = (uint64_t) parse_8_digits(hi) * 100000000
+					+ parse_8_digits(lo);
+
+				if (__builtin_mul_overflow(num_and_len.val, POW10_U64[16],
+					&num_and_len.val) || __builtin_add_overflow(
+					num_and_len.val, chunk, &num_and_len.val)
+				) num_and_len.overflow = true;
+
+				num_and_len.len += 16;
+			}
 
-		for (size_t i = 0; i < remaining_pad_size; i++) {
-			*buf++ = pad_char;
+			if (buf_len - num_and_len.len >= 8) {
+				uint64_t chunk;
+				memcpy(&chunk, buf + num_and_len.len, 8);
+
+				if (is_8_digits(chunk)) {
+					if (__builtin_mul_overflow(num_and_len.val, POW10_U64[8],
+						&num_and_len.val) || __builtin_add_overflow(
+						num_and_len.val, parse_8_digits(chunk), &num_and_len.val)
+					) num_and_len.overflow = true;
+
+					num_and_len.len += 8;
+				}
+			}
 		}
 
-		for (size_t i = length; i != 0; i--) {
-			char digit = get_base_digit<starting_alphabetical_digit>(
-				multiplier * (num % base));
-			buf[i - 1] = digit;
-			num /= base;
+		while (num_and_len.len < buf_len) {
+			char c = buf[num_and_len.len];
+			if (c < '0' || c > '9') break;
+
+			if (__builtin_mul_overflow(num_and_len.val, 10, &num_and_len.val)
+				|| __builtin_add_overflow(num_and_len.val, c - '0',
+				&num_and_len.val)) num_and_len.overflow = true;
+
+			num_and_len.len++;
 		}
 
-		return length + remaining_pad_size + (is_signed ? 1 : 0);
+		return num_and_len;
 	}
 
-	struct UintFromStr {
-		uint64_t val;
-		size_t len;
-	};
-
 	/**
 	 *  @brief  Reads an unsigned integer in base 10 format from a string.
 	 *  Expects the character at the start of the buffer to be a base 10 digit.
@@ -146,7 +270,7 @@ namespace flow_tools {
 	 *  @returns  A UintFromStr structure, containing the value of the number
 	 *  in and the length of the read number in number of bytes.
 	 */
-	UintFromStr read_uint_from_str(const char *buf)
+	inline UintFromStr read_uint_from_str(const char *buf)
 	{
 		UintFromStr num_and_len = { 0, 0 };
 
@@ -178,16 +302,508 @@ namespace flow_tools {
 	}
 
 	/**
-	 *  @brief  Writes a floating point number to a string. Does not check if
-	 *  there is enough space left on the buffer. If the number is not a number
-	 *  according to the IEEE 754 standard, "NaN" is written to the buffer.
-	 *  Infinities will be written as "Inf".
-	 *  @tparam  float_t  The type of the floating point number to write.
+	 *  @brief  Describes the IEEE 754 binary layout of a floating point type.
+	 */
+	template <typename float_t>
+	struct FloatTraits;
+
+	template <>
+	struct FloatTraits<float> {
+		using carrier_t = uint32_t;
+
+		static constexpr int SIGNIFICAND_BITS = 23;
+		static constexpr int EXPONENT_BITS = 8;
+		static constexpr int EXPONENT_BIAS = 127;
+	};
+
+	template <>
+	struct FloatTraits<double> {
+		using carrier_t = uint64_t;
+
+		static constexpr int SIGNIFICAND_BITS = 52;
+		static constexpr int EXPONENT_BITS = 11;
+		static constexpr int EXPONENT_BIAS = 1023;
+	};
+
+	/**
+	 *  @brief  A floating point number split into its binary fields.
+	 *  The value is (-1)^sign * significand * 2^exponent.
+	 */
+	template <typename float_t>
+	struct BinaryFloat {
+		using carrier_t = typename FloatTraits<float_t>::carrier_t;
+
+		carrier_t significand;
+		int32_t exponent;
+		bool sign;
+
+		// The raw fields
+
+		carrier_t ieee_significand;
+		uint32_t ieee_exponent;
+
+		static constexpr uint32_t MAX_IEEE_EXPONENT =
+			(1 << FloatTraits<float_t>::EXPONENT_BITS) - 1;
+
+		BinaryFloat(float_t num)
+		{
+			using Traits = FloatTraits<float_t>;
+
+			carrier_t bits = std::bit_cast<carrier_t>(num);
+
+			sign = bits >> (Traits::SIGNIFICAND_BITS + Traits::EXPONENT_BITS);
+			ieee_significand = bits
+				& (((carrier_t) 1 << Traits::SIGNIFICAND_BITS) - 1);
+			ieee_exponent = (bits >> Traits::SIGNIFICAND_BITS) & MAX_IEEE_EXPONENT;
+
+			if (ieee_exponent != 0) {
+				significand = ieee_significand
+					| ((carrier_t) 1 << Traits::SIGNIFICAND_BITS);
+				exponent = (int32_t) ieee_exponent
+					- Traits::EXPONENT_BIAS - Traits::SIGNIFICAND_BITS;
+			} else {
+				significand = ieee_significand;
+				exponent = 1 - Traits::EXPONENT_BIAS - Traits::SIGNIFICAND_BITS;
+			}
+		}
+
+		bool is_nan() const
+		{
+			return ieee_exponent == MAX_IEEE_EXPONENT && ieee_significand != 0;
+		}
+
+		bool is_inf() const
+		{
+			return ieee_exponent == MAX_IEEE_EXPONENT && ieee_significand == 0;
+		}
+	};
+
+	/**
+	 *  @brief  An unsigned decimal floating point number.
+	 *  The value is significand * 10^exponent.
+	 */
+	template <typename carrier_t>
+	struct DecimalFloat {
+		carrier_t significand;
+		int32_t exponent;
+	};
+
+	/**
+	 *  @brief  A fixed size big integer, only used to compute the table of
+	 *  powers of ten at compile time.
+	 */
+	struct ConstexprBigInt {
+		static constexpr size_t LIMB_COUNT = 36;
+
+		// Little endian 32-bit limbs
+
+		uint32_t limbs[LIMB_COUNT] = {};
+
+		constexpr void multiply(uint32_t factor)
+		{
+			uint64_t carry = 0;
+
+			for (size_t i = 0; i < LIMB_COUNT; i++) {
+				uint64_t product = (uint64_t) limbs[i] * factor + carry;
+				limbs[i] = product;
+				carry = product >> 32;
+			}
+		}
+
+		constexpr void divide(uint32_t divisor)
+		{
+			uint64_t remainder = 0;
+
+			for (size_t i = LIMB_COUNT; i != 0; i--) {
+				uint64_t dividend = (remainder << 32) | limbs[i - 1];
+				limbs[i - 1] = dividend / divisor;
+				remainder = dividend % divisor;
+			}
+		}
+
+		constexpr bool bit(ssize_t i) const
+		{
+			if (i < 0) return false;
+			return (limbs[i / 32] >> (i % 32)) & 1;
+		}
+
+		/**
+		 *  @brief  Returns the 128 most significant bits, starting at the
+		 *  highest set bit. Lower bits are cut off.
+		 */
+		constexpr __uint128_t top_128_bits() const
+		{
+			ssize_t bit_length = LIMB_COUNT * 32;
+			while (!bit(bit_length - 1)) bit_length--;
+
+			__uint128_t top = 0;
+
+			for (ssize_t i = bit_length - 1; i >= bit_length - 128; i--) {
+				top = (top << 1) | bit(i);
+			}
+
+			return top;
+		}
+	};
+
+	/**
+	 *  @brief  128-bit significands of the powers of ten that are needed to
+	 *  convert floats and doubles to decimal, computed at compile time.
+	 *  For a power 10^k, the entry is floor(10^k * 2^(127 - floor(log2(10^k)))) + 1.
+	 */
+	struct Pow10Significands {
+		static constexpr int MIN_EXPONENT = -292;
+		static constexpr int MAX_EXPONENT = 326;
+
+		__uint128_t values[MAX_EXPONENT - MIN_EXPONENT + 1] = {};
+
+		constexpr Pow10Significands()
+		{
+			// 10^k for k >= 0
+
+			ConstexprBigInt big;
+			big.limbs[0] = 1;
+
+			for (int k = 0; k <= MAX_EXPONENT; k++) {
+				if (k != 0) big.multiply(10);
+				values[k - MIN_EXPONENT] = big.top_128_bits() + 1;
+			}
+
+			// floor(2^1151 / 10^k) for k > 0, repeated floor division by 10
+			// gives the same result as a single division by 10^k
+
+			big = ConstexprBigInt();
+			big.limbs[ConstexprBigInt::LIMB_COUNT - 1] = (uint32_t) 1 << 31;
+
+			for (int k = 1; k <= -MIN_EXPONENT; k++) {
+				big.divide(10);
+				values[-k - MIN_EXPONENT] = big.top_128_bits() + 1;
+			}
+		}
+
+		__uint128_t get(int k) const
+		{
+			return values[k - MIN_EXPONENT];
+		}
+	};
+
+	inline constexpr Pow10Significands pow10_significands;
+
+	// floor(log10(2^e)) and floor(log10(3/4 * 2^e)), exact for |e| <= 2620
+
+	constexpr int32_t floor_log10_pow2(int32_t e, bool three_quarters = false)
+	{
+		return (e * 1262611 - (three_quarters ? 524031 : 0)) >> 22;
+	}
+
+	// floor(log2(10^e)), exact for |e| <= 1233
+
+	constexpr int32_t floor_log2_pow10(int32_t e)
+	{
+		return (e * 1741647) >> 19;
+	}
+
+	/**
+	 *  @brief  Computes floor(g * cp / 2^128) with round to odd, where g is
+	 *  a significand from Pow10Significands. Used by to_shortest_decimal().
+	 */
+	inline uint64_t round_to_odd(__uint128_t g, uint64_t cp)
+	{
+		__uint128_t lo = (__uint128_t) (uint64_t) g * cp;
+		__uint128_t hi = (__uint128_t) (uint64_t) (g >> 64) * cp + (lo >> 64);
+
+		return (uint64_t) (hi >> 64) | ((uint64_t) hi > 1);
+	}
+
+	/**
+	 *  @brief  Computes floor(g * cp / 2^64) with round to odd, where g is
+	 *  the 64 most significant bits of a significand from Pow10Significands.
+	 *  Used by to_shortest_decimal().
+	 */
+	inline uint32_t round_to_odd(uint64_t g, uint32_t cp)
+	{
+		uint64_t lo = (uint64_t) (uint32_t) g * cp;
+		uint64_t hi = (g >> 32) * cp + (lo >> 32);
+
+		return (uint32_t) (hi >> 32) | ((uint32_t) hi > 1);
+	}
+
+	/**
+	 *  @brief  Converts a finite, non-zero floating point number to the
+	 *  shortest decimal number that rounds back to it, using the Schubfach
+	 *  algorithm by Raffaello Giulietti. Of the shortest candidates, the one
+	 *  closest to the exact value is chosen. The significand of the result
+	 *  can have trailing zeros.
+	 *  @param  num  The binary fields of the number, the sign is ignored.
+	 *  @returns  The decimal significand and exponent.
+	 */
+	template <typename float_t>
+	DecimalFloat<typename FloatTraits<float_t>::carrier_t>
+	to_shortest_decimal(const BinaryFloat<float_t>& num)
+	{
+		using carrier_t = typename FloatTraits<float_t>::carrier_t;
+
+		carrier_t c = num.significand;
+		int32_t q = num.exponent;
+
+		// Small integers are exact
+
+		if (q <= 0 && -q <= FloatTraits<float_t>::SIGNIFICAND_BITS
+			&& (c & (((carrier_t) 1 << -q) - 1)) == 0) {
+			return { (carrier_t) (c >> -q), 0 };
+		}
+
+		bool is_even = c % 2 == 0;
+		bool lower_boundary_is_closer = num.ieee_significand == 0
+			&& num.ieee_exponent > 1;
+
+		// The number and the halfway points to its neighbours, times 4
+
+		carrier_t cbl = 4 * c - 2 + lower_boundary_is_closer;
+		carrier_t cb = 4 * c;
+		carrier_t cbr = 4 * c + 2;
+
+		int32_t k = floor_log10_pow2(q, lower_boundary_is_closer);
+		int32_t h = q + floor_log2_pow10(-k) + 1;
+
+		__uint128_t g128 = pow10_significands.get(-k);
+		carrier_t vbl, vb, vbr;
+
+		if constexpr (std::is_same_v<carrier_t, uint64_t>) {
+			vbl = round_to_odd(g128, cbl << h);
+			vb = round_to_odd(g128, cb << h);
+			vbr = round_to_odd(g128, cbr << h);
+		} else {
+			uint64_t g64 = (uint64_t) ((g128 - 1) >> 64) + 1;
+
+			vbl = round_to_odd(g64, cbl << h);
+			vb = round_to_odd(g64, cb << h);
+			vbr = round_to_odd(g64, cbr << h);
+		}
+
+		carrier_t lower = vbl + !is_even;
+		carrier_t upper = vbr - !is_even;
+		carrier_t s = vb / 4;
+
+		// Try one digit less first
+
+		if (s >= 10) {
+			carrier_t sp = s / 10;
+			bool up_inside = lower <= 40 * sp;
+			bool wp_inside = 40 * sp + 40 <= upper;
+
+			if (up_inside != wp_inside) {
+				return { wp_inside ? sp + 1 : sp, k + 1 };
+			}
+		}
+
+		bool u_inside = lower <= 4 * s;
+		bool w_inside = 4 * s + 4 <= upper;
+
+		if (u_inside != w_inside) {
+			return { w_inside ? s + 1 : s, k };
+		}
+
+		// Both neighbours are inside the rounding interval, pick the closest
+
+		carrier_t mid = 4 * s + 2;
+		bool round_up = vb > mid || (vb == mid && (s & 1) != 0);
+
+		return { round_up ? s + 1 : s, k };
+	}
+
+	// Maximum number of bytes written by write_shortest_float_to_str()
+
+	inline constexpr size_t SHORTEST_FLOAT_MAX_SIZE = 26;
+
+	/**
+	 *  @brief  Writes a floating point number to a string with the least
+	 *  number of digits that uniquely identify it, so that reading the
+	 *  string back yields the exact same number. Does not check if there is
+	 *  enough space left on the buffer, at most SHORTEST_FLOAT_MAX_SIZE bytes
+	 *  are written.
+	 *  The notation matches JavaScript's Number.prototype.toString():
+	 *  numbers in [1e-7, 1e21) are written in fixed notation ("123.45",
+	 *  "0.001"), other numbers in exponential notation ("1.5e+21", "1e-7").
+	 *  If the number is not a number according to the IEEE 754 standard,
+	 *  "NaN" is written to the buffer. Infinities will be written as "Inf"
+	 *  or "-Inf".
+	 *  @tparam  float_t  The type of the floating point number to write,
+	 *  float or double. The digits are the shortest for this type.
+	 *  @param  num  The number to write.
+	 *  @param  buf  The character buffer to write the number to.
+	 *  @returns  The total number of bytes written to the buffer.
+	 */
+	template <typename float_t>
+	size_t write_shortest_float_to_str(float_t num, char *buf)
+	{
+		BinaryFloat<float_t> bin(num);
+
+		if (bin.is_nan()) return copy_str("NaN", buf);
+
+		char *start = buf;
+		if (bin.sign) *buf++ = '-';
+
+		if (bin.is_inf()) return buf - start + copy_str("Inf", buf);
+
+		if (bin.significand == 0) {
+			*buf = '0';
+			return buf - start + 1;
+		}
+
+		auto dec = to_shortest_decimal(bin);
+
+		while (dec.significand % 10 == 0) {
+			dec.significand /= 10;
+			dec.exponent++;
+		}
+
+		char digits[20];
+		int32_t n = count_digits(dec.significand);
+		write_uint_digits(dec.significand, digits, n);
+
+		// The position of the decimal point relative to the first digit
+
+		int32_t p = n + dec.exponent;
+
+		if (dec.exponent >= 0 && p <= 21) {
+			memcpy(buf, digits, n);
+			memset(buf + n, '0', dec.exponent);
+			buf += p;
+		} else if (p > 0 && p <= 21) {
+			memcpy(buf, digits, p);
+			buf[p] = '.';
+			memcpy(buf + p + 1, digits + p, n - p);
+			buf += n + 1;
+		} else if (p > -6 && p <= 0) {
+			buf[0] = '0';
+			buf[1] = '.';
+			memset(buf + 2, '0', -p);
+			memcpy(buf + 2 - p, digits, n);
+			buf += 2 - p + n;
+		} else {
+			*buf++ = digits[0];
+
+			if (n > 1) {
+				*buf++ = '.';
+				memcpy(buf, digits + 1, n - 1);
+				buf += n - 1;
+			}
+
+			int32_t e = p - 1;
+			*buf++ = 'e';
+			*buf++ = e < 0 ? '-' : '+';
+
+			uint32_t abs_e = e < 0 ? -e : e;
+			size_t e_len = count_digits(abs_e);
+			write_uint_digits(abs_e, buf, e_len);
+			buf += e_len;
+		}
+
+		return buf - start;
+	}
+
+	/**
+	 *  @brief  Writes the integer part of significand * 2^exponent, for a
+	 *  non-negative exponent, in base 10. Does not check if there is enough
+	 *  space left on the buffer.
+	 *  @returns  The number of bytes written.
+	 */
+	inline size_t write_shifted_uint_to_str(uint64_t significand,
+		int32_t exponent, char *buf)
+	{
+		if (exponent < 64 && (significand >> (63 - exponent) >> 1) == 0) {
+			uint64_t num = significand << exponent;
+			size_t len = count_digits(num);
+			write_uint_digits(num, buf, len);
+			return len;
+		}
+
+		// Big integer with 32-bit little endian limbs, enough for any double
+
+		uint32_t limbs[36] = {};
+		size_t limb_count = exponent / 32 + 3;
+		__uint128_t shifted = (__uint128_t) significand << (exponent % 32);
+
+		limbs[exponent / 32] = shifted;
+		limbs[exponent / 32 + 1] = shifted >> 32;
+		limbs[exponent / 32 + 2] = shifted >> 64;
+
+		// Split off 9 digits at a time, least significant first
+
+		uint32_t chunks[40];
+		size_t chunk_count = 0;
+
+		while (limb_count != 0) {
+			uint64_t remainder = 0;
+
+			for (size_t i = limb_count; i != 0; i--) {
+				uint64_t dividend = (remainder << 32) | limbs[i - 1];
+				limbs[i - 1] = dividend / 1000000000;
+				remainder = dividend % 1000000000;
+			}
+
+			chunks[chunk_count++] = remainder;
+			while (limb_count != 0 && limbs[limb_count - 1] == 0) limb_count--;
+		}
+
+		size_t len = count_digits(chunks[chunk_count - 1]);
+		write_uint_digits(chunks[chunk_count - 1], buf, len);
+
+		for (size_t i = chunk_count - 1; i != 0; i--) {
+			write_uint_digits(chunks[i - 1], buf + len, 9);
+			len += 9;
+		}
+
+		return len;
+	}
+
+	/**
+	 *  @brief  Returns an upper bound of the number of bytes
+	 *  write_float_to_str() writes for a number without padding. It is
+	 *  taken from the binary exponent, without converting the number, and
+	 *  exceeds the exact size by at most 3 bytes.
+	 *  @tparam  float_t  The type of the floating point number, float or double.
+	 *  @param  num  The number.
+	 *  @param  fraction_digits  The number of digits after the decimal separator.
+	 *  @note  Runtime: O(1)
+	 *  @note  Memory: O(1)
+	 */
+	template <typename float_t>
+	size_t float_to_str_max_size(float_t num, uint8_t fraction_digits)
+	{
+		BinaryFloat<float_t> bin(num);
+
+		if (bin.is_nan() || bin.is_inf()) return 4;
+
+		// The integer part has at most int_bits bits. 1233 / 4096 is just
+		// below log10(2), one digit covers that and one a rounding carry
+
+		int32_t int_bits = bin.significand == 0 ? 0
+			: (int32_t) std::bit_width(bin.significand) + bin.exponent;
+
+		size_t int_digits = int_bits <= 0 ? 1 : (((size_t) int_bits * 1233) >> 12) + 3;
+		size_t fraction_len = fraction_digits != 0 ? fraction_digits + 1 : 0;
+
+		return bin.sign + int_digits + fraction_len;
+	}
+
+	/**
+	 *  @brief  Writes a floating point number to a string in fixed notation,
+	 *  with a fixed number of digits after the decimal separator. The number
+	 *  is rounded exactly, halfway cases are rounded to even, so the output
+	 *  matches printf("%.*f"). Does not check if there is enough space left
+	 *  on the buffer. If the number is not a number according to the
+	 *  IEEE 754 standard, "NaN" is written to the buffer.
+	 *  Infinities will be written as "Inf" or "-Inf".
+	 *  @tparam  float_t  The type of the floating point number to write,
+	 *  float or double.
 	 *  @param  num  The number to write.
 	 *  @param  buf  The character buffer to write the number to.
 	 *  @param  fraction_digits  The number of digits after the decimal
 	 *  separator to display. The number is rounded accordingly.
-	 *  @param  pad_char  The character used for left padding.
+	 *  @param  pad_char  The character used for left padding. Zeros are
+	 *  padded after the sign, other characters before the sign.
 	 *  @param  pad_size  The minimum length of the displayed number. If the
 	 *  length of the number turns out to be smaller than this, the pad_char is
 	 *  padded at the left of the string to make the number fit the desired
@@ -198,55 +814,177 @@ namespace flow_tools {
 	size_t write_float_to_str(float_t num, char *buf, uint8_t fraction_digits,
 		char pad_char = '\0', size_t pad_size = 0)
 	{
-		if (std::isnan(num)) return copy_str("NaN", buf);
-		if (std::isinf(num)) return copy_str("Inf", buf);
+		BinaryFloat<float_t> bin(num);
+		char *start = buf;
+
+		if (bin.is_nan()) {
+			buf += copy_str("NaN", buf);
+		} else if (bin.is_inf()) {
+			if (bin.sign) *buf++ = '-';
+			buf += copy_str("Inf", buf);
+		} else {
+			if (bin.sign) *buf++ = '-';
+
+			uint64_t significand = bin.significand;
+			int32_t exponent = bin.exponent;
+
+			if (exponent >= 0) {
+				buf += write_shifted_uint_to_str(significand, exponent, buf);
+
+				if (fraction_digits != 0) {
+					*buf++ = '.';
+					memset(buf, '0', fraction_digits);
+					buf += fraction_digits;
+				}
+			} else {
+				// Split into an integer part and a binary fraction.
+				// The fraction is stored as a fixed point number of 64-bit
+				// limbs, most of the time it fits in a single limb.
+
+				uint32_t shift = -exponent;
+				uint64_t int_part = shift < 64 ? significand >> shift : 0;
+				uint64_t frac_bits = shift < 64
+					? significand & (((uint64_t) 1 << shift) - 1)
+					: significand;
+
+				uint64_t frac[18] = {};
+				size_t limb_count = (shift + 63) / 64;
+				uint32_t frac_shift = limb_count * 64 - shift;
+
+				frac[0] = frac_bits << frac_shift;
+				if (frac_shift != 0 && limb_count > 1) {
+					frac[1] = frac_bits >> (64 - frac_shift);
+				}
+
+				// Multiplying the fraction by 10 shifts the next digit
+				// out of the most significant limb
+
+				char frac_digits[256];
+				size_t low_limb = 0;
+
+				for (size_t i = 0; i < fraction_digits; i++) {
+					uint64_t carry = 0;
+
+					for (size_t j = low_limb; j < limb_count; j++) {
+						__uint128_t product = (__uint128_t) frac[j] * 10 + carry;
+						frac[j] = product;
+						carry = product >> 64;
+					}
+
+					frac_digits[i] = '0' + carry;
+					if (frac[low_limb] == 0 && low_limb + 1 < limb_count) low_limb++;
+				}
+
+				// Round half to even on the remaining fraction
+
+				uint64_t top = frac[limb_count - 1];
+				bool above_half = top > ((uint64_t) 1 << 63);
+				bool is_half = top == ((uint64_t) 1 << 63);
+
+				for (size_t j = low_limb; is_half && j + 1 < limb_count; j++) {
+					if (frac[j] != 0) {
+						is_half = false;
+						above_half = true;
+					}
+				}
+
+				bool last_is_odd = fraction_digits != 0
+					? (frac_digits[fraction_digits - 1] - '0') & 1
+					: int_part & 1;
+
+				if (above_half || (is_half && last_is_odd)) {
+					size_t i = fraction_digits;
+
+					while (i != 0 && frac_digits[i - 1] == '9') {
+						frac_digits[--i] = '0';
+					}
+
+					if (i != 0) frac_digits[i - 1]++;
+					else int_part++;
+				}
+
+				size_t int_len = count_digits(int_part);
+				write_uint_digits(int_part, buf, int_len);
+				buf += int_len;
+
+				if (fraction_digits != 0) {
+					*buf++ = '.';
+					memcpy(buf, frac_digits, fraction_digits);
+					buf += fraction_digits;
+				}
+			}
+		}
 
-		size_t length = 0;
+		size_t len = buf - start;
+		if (pad_size <= len) return len;
 
-		if (num < 0) {
-			*buf++ = '-';
-			length += 1;
-			num = -num;
-		}
+		buf = start;
+		size_t padding = pad_size - len;
+		size_t sign = pad_char == '0' && buf[0] == '-';
 
-		float_t n = num;
-		int exp = std::max(floor(log10(num)), (float_t) 0);
-		int e = exp;
-		uint8_t rounding_digit;
-		double digit_place;
+		memmove(buf + sign + padding, buf + sign, len - sign);
+		memset(buf + sign, pad_char, padding);
+		return pad_size;
+	}
 
-		while (e >= -fraction_digits - 1) {
-			digit_place = exp10(e);
-			rounding_digit = floor(n / digit_place);
+	/**
+	 *  @brief  Finds the first occurrence of a character sequence in a buffer.
+	 *  Single characters are searched with memchr(). Longer sequences are
+	 *  searched 16 positions at a time by comparing both their first and last
+	 *  character with SSE2, only the candidates that pass are compared fully.
+	 *  @param  haystack  The buffer to search in.
+	 *  @param  haystack_len  The size of the buffer to search in.
+	 *  @param  needle  The character sequence to search for.
+	 *  @param  needle_len  The size of the character sequence, must not be 0.
+	 *  @returns  A pointer to the first match, or NULL if there is none.
+	 */
+	inline const char *find_chars(const char *haystack, size_t haystack_len,
+		const char *needle, size_t needle_len)
+	{
+		if (needle_len > haystack_len) return NULL;
 
-			n -= rounding_digit * digit_place;
-			e--;
+		if (needle_len == 1) {
+			return (const char *) memchr(haystack, *needle, haystack_len);
 		}
 
-		if (rounding_digit >= 5) {
-			num += 5 * digit_place;
-		}
+		// Number of positions a match can start at
 
-		n = num;
-		e = exp;
+		size_t positions = haystack_len - needle_len + 1;
+		size_t i = 0;
 
-		while (e >= -fraction_digits) {
-			digit_place = exp10(e);
-			uint8_t digit = floor(n / digit_place);
+		#ifdef __SSE2__
+		const __m128i first_char = _mm_set1_epi8(needle[0]);
+		const __m128i last_char = _mm_set1_epi8(needle[needle_len - 1]);
 
-			n -= digit * digit_place;
-			*buf++ = '0' + digit;
+		for (; i + 16 <= positions; i += 16) {
+			__m128i block_first = _mm_loadu_si128(
+				(const __m128i *) (haystack + i));
+			__m128i block_last = _mm_loadu_si128(
+				(const __m128i *) (haystack + i + needle_len - 1));
 
-			if (e == 0 && fraction_digits != 0) {
-				*buf++ = '.';
-				length++;
+			uint32_t mask = _mm_movemask_epi8(_mm_and_si128(
+				_mm_cmpeq_epi8(first_char, block_first),
+				_mm_cmpeq_epi8(last_char, block_last)));
+
+			while (mask != 0) {
+				size_t offset = i + __builtin_ctz(mask);
+
+				if (memcmp(haystack + offset + 1, needle + 1, needle_len - 2) == 0) {
+					return haystack + offset;
+				}
+
+				mask &= mask - 1;
 			}
+		}
+		#endif
 
-			length++;
-			e--;
+		for (; i < positions; i++) {
+			if (haystack[i] == needle[0]
+				&& memcmp(haystack + i + 1, needle + 1, needle_len - 1) == 0
+			) return haystack + i;
 		}
 
-		return length;
+		return NULL;
 	}
 };
 
@@ -0,0 +1,184 @@
+#ifndef FLOW_STRING_VIEW_HEADER
+#define FLOW_STRING_VIEW_HEADER
+
+#include <bits/stdc++.h>
+
+#include "buffer.hpp"
+#include "string.hpp"
+
+namespace flow {
+	enum class StringViewErrors {
+		READ_ONLY,
+		INDEX_OUT_OF_BOUNDS
+	};
+
+	/**
+	 *  @brief  A read-only view of a range of characters owned by something
+	 *  else, e.g. a String or a MappedFile. Creating, copying and slicing a
+	 *  StringView never copies the characters, and never allocates.
+	 *  The owner must outlive the StringView.
+	 *  set_at_index() throws StringViewErrors::READ_ONLY, writing through
+	 *  data(), front() or back() is undefined.
+	 */
+	class StringView : public Buffer<char> {
+		private:
+			const char *chars = NULL;
+			size_t length = 0;
+
+		public:
+			/**
+			 *  @brief  Creates an empty StringView.
+			 */
+			StringView() {}
+
+			/**
+			 *  @brief  Creates a StringView of a range of characters.
+			 *  @param  chars  A pointer to the first character.
+			 *  @param  length  The number of characters.
+			 */
+			StringView(const char *chars, size_t length) : chars(chars), length(length) {}
+
+			/**
+			 *  @brief  Creates a StringView of a string literal,
+			 *  without its terminating NULL byte.
+			 */
+			template <size_t char_count>
+			StringView(const char (&chars)[char_count])
+				: chars(chars), length(char_count - 1) {}
+
+			/**
+			 *  @brief  Creates a StringView of all characters of a String.
+			 *  The view is invalidated when the String grows.
+			 */
+			template <typename Allocator>
+			StringView(const BasicString<Allocator>& str)
+				: chars(str.data()), length(str.size()) {}
+
+			char *data() const
+			{
+				return const_cast<char *>(chars);
+			}
+
+			size_t size() const
+			{
+				return length;
+			}
+
+			const char& front() const
+			{
+				return chars[0];
+			}
+
+			char& front()
+			{
+				return data()[0];
+			}
+
+			const char& back() const
+			{
+				return chars[length - 1];
+			}
+
+			char& back()
+			{
+				return data()[length - 1];
+			}
+
+			char get_at_index(size_t index) const
+			{
+				return chars[index];
+			}
+
+			void set_at_index(size_t, const char&)
+			{
+				throw StringViewErrors::READ_ONLY;
+			}
+
+			const char& operator[](size_t index) const
+			{
+				return chars[index];
+			}
+
+			/**
+			 *  @brief  Returns a view of a part of this StringView.
+			 *  @param  offset  The index of the first character.
+			 *  @param  count  The maximum number of characters, the view ends
+			 *  at the end of this StringView if there are fewer.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			StringView slice(size_t offset, size_t count = SIZE_MAX) const
+			{
+				if (offset > length) throw StringViewErrors::INDEX_OUT_OF_BOUNDS;
+				return StringView(chars + offset, std::min(count, length - offset));
+			}
+
+			/**
+			 *  @brief  Returns the index of the first occurrence of a character,
+			 *  or -1 if it does not occur.
+			 *  @param  value  The character to find.
+			 *  @param  starting_index  The index to start searching at.
+			 *  @note  Runtime: O(n), n = size(), uses memchr
+			 *  @note  Memory: O(1)
+			 */
+			ssize_t first_index_of(char value, size_t starting_index = 0) const
+			{
+				if (starting_index >= length) return -1;
+
+				const char *found = (const char *) memchr(chars + starting_index,
+					value, length - starting_index);
+
+				return found == NULL ? -1 : found - chars;
+			}
+
+			/**
+			 *  @brief  Returns whether this StringView starts with another one.
+			 */
+			bool starts_with(const StringView& prefix) const
+			{
+				if (prefix.length > length) return false;
+				return prefix.length == 0 || memcmp(chars, prefix.chars, prefix.length) == 0;
+			}
+
+			bool operator==(const StringView& other) const
+			{
+				if (length != other.length) return false;
+				return length == 0 || memcmp(chars, other.chars, length) == 0;
+			}
+
+			bool operator!=(const StringView& other) const
+			{
+				return !(*this == other);
+			}
+
+			/**
+			 *  @brief  Copies the characters into a new String.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(n), n = size()
+			 */
+			String to_string() const
+			{
+				if (length == 0) return String();
+
+				String str(length);
+				str.unsafe_increment_element_count(length);
+				memcpy(str.data(), chars, length);
+
+				return str;
+			}
+
+			/**
+			 *  @brief  Prints the characters to a stream with a single
+			 *  fwrite(), followed by a newline.
+			 *  @param  stream  The stream to print to. Defaults to stdout.
+			 *  @param  newline  Whether to print the newline.
+			 */
+			void print(FILE *stream = stdout, bool newline = true) const
+			{
+				if (length != 0) fwrite(chars, 1, length, stream);
+				if (newline) putc('\n', stream);
+			}
+	};
+};
+
+#endif
@@ -5,25 +5,57 @@
 
 #include "dynamic-array.hpp"
 #include "string-tools.hpp"
+#include "format-string.hpp"
 
 namespace flow {
+	enum class StringErrors {
+		INVALID_NUMBER,
+		NUMBER_OUT_OF_RANGE
+	};
+
 	/**
 	 *  @brief  A flexible string of characters.
+	 *  @tparam  Allocator  The allocator of the characters.
 	 */
-	class String : public DynamicArray<char> {
+	template <typename Allocator = std::allocator<char>>
+	class BasicString : public DynamicArray<char, Allocator> {
+		private:
+			using Base = DynamicArray<char, Allocator>;
+
+		protected:
+			using Base::buffer;
+			using Base::current_buffer_size;
+			using Base::allocate_buffer;
+			using Base::free_buffer;
+
 		public:
+			using Base::size;
+			using Base::data;
+			using Base::copy_from;
+			using Base::get_at_index;
+			using Base::set_at_index;
+			using Base::append;
+			using Base::reserve;
+			using Base::reset;
+			using Base::shift_right;
+			using Base::calc_growth_size;
+			using Base::unsafe_append;
+			using Base::unsafe_increment_element_count;
+			using Base::unsafe_decrement_element_count;
+			using Base::unsafe_set_element_count;
+
 			/**
 			 *  @brief  Creates a String with a given initial capacity.
 			 *  @param  capacity  The initial capacity of the String.
 			 */
-			String(size_t capacity = 16) : DynamicArray<char>(capacity) {}
+			BasicString(size_t capacity = 16) : DynamicArray<char, Allocator>(capacity) {}
 
 			/**
 			 *  @brief  Creates a String from a sequence of characters.
 			 *  @param  chars  A reference to the sequence of characters.
 			 */
 			template <size_t char_count>
-			String(const char (&chars)[char_count]) : DynamicArray<char>(char_count - 1)
+			BasicString(const char (&chars)[char_count]) : DynamicArray<char, Allocator>(char_count - 1)
 			{
 				unsafe_set_element_count(char_count - 1);
 				memcpy(buffer, chars, char_count - 1);
@@ -33,7 +65,7 @@ namespace flow {
 			 *  @brief  Creates a String from a NULL terminated char pointer.
 			 *  @param  chars  A pointer to the NULL terminated char pointer.
 			 */
-			String(const char *chars) : DynamicArray<char>(strlen(chars))
+			BasicString(const char *chars) : DynamicArray<char, Allocator>(strlen(chars))
 			{
 				size_t len = strlen(chars);
 				unsafe_set_element_count(len);
@@ -44,7 +76,7 @@ namespace flow {
 			 *  @brief  Creates a copy of another String.
 			 *  @param  other  The String to copy.
 			 */
-			String(const String& other) : DynamicArray<char>(other.current_capacity())
+			BasicString(const BasicString& other) : DynamicArray<char, Allocator>(other.current_capacity())
 			{
 				unsafe_set_element_count(other.size());
 				memcpy(buffer, other.buffer, other.size());
@@ -54,14 +86,7 @@ namespace flow {
 			 *  @brief  Creates a String by moving from an rvalue String.
 			 *  @param  other  The String to move.
 			 */
-			String(String&& other) : DynamicArray<char>(other.current_capacity())
-			{
-				unsafe_set_element_count(other.size());
-				buffer = other.buffer;
-
-				other.buffer = NULL;
-				other.current_element_count = 0;
-			}
+			BasicString(BasicString&& other) noexcept : DynamicArray<char, Allocator>(std::move(other)) {}
 
 			/**
 			 *  @brief  Deletes the current value of this String and copies a new
@@ -69,7 +94,7 @@ namespace flow {
 			 *  @param  new_value  New character array to copy to this String.
 			 */
 			template <size_t char_count>
-			String& operator=(const char (&chars)[char_count])
+			BasicString& operator=(const char (&chars)[char_count])
 			{
 				size_t new_size = char_count - 1;
 
@@ -88,7 +113,7 @@ namespace flow {
 			 *  String to this String.
 			 *  @param  other  New String to copy to this String.
 			 */
-			String& operator=(const String& other)
+			BasicString& operator=(const BasicString& other)
 			{
 				if (this == &other) return *this;
 
@@ -105,25 +130,16 @@ namespace flow {
 			 *  @brief  Creates a String by moving from an rvalue String.
 			 *  @param  other  The String to move.
 			 */
-			String& operator=(String&& other)
+			BasicString& operator=(BasicString&& other)
 			{
-				if (this == &other) return *this;
-
-				delete[] buffer;
-				current_buffer_size = other.current_buffer_size;
-				current_element_count = other.current_element_count;
-				buffer = other.buffer;
-
-				other.buffer = NULL;
-				other.current_element_count = 0;
-
+				DynamicArray<char, Allocator>::operator=(std::move(other));
 				return *this;
 			}
 
 			/**
 			 *  @brief  Checks if two Strings are equal.
 			 */
-			bool operator==(const String& other_str) const
+			bool operator==(const BasicString& other_str) const
 			{
 				if (size() != other_str.size()) return false;
 
@@ -137,7 +153,7 @@ namespace flow {
 			/**
 			 *  @brief  Checks if two Strings are not equal.
 			 */
-			bool operator!=(const String& other_str) const
+			bool operator!=(const BasicString& other_str) const
 			{
 				return !operator==(other_str);
 			}
@@ -215,7 +231,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = size() + str.size()
 			 *  @note  Memory: O(1)
 			 */
-			void attach(const String& str)
+			void attach(const BasicString& str)
 			{
 				// Allocate space for all new characters
 
@@ -250,11 +266,11 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = size() + str.size()
 			 *  @note  Memory: O(1)
 			 */
-			void operator+=(const String& str) { attach(str); }
+			void operator+=(const BasicString& str) { attach(str); }
 
 			// Prevent C++ inherited class Name Hiding
 
-			using DynamicArray::operator+=;
+			using Base::operator+=;
 
 			/**
 			 *  @brief  Alter this String by repeats it a certain amount of times.
@@ -298,10 +314,10 @@ namespace flow {
 			 *  @note  Runtime: O(n + m), n = size(), m = other_string.size()
 			 *  @note  Memory: O(n + m)
 			 */
-			String concatenate(String& other_string) const
+			BasicString concatenate(BasicString& other_string) const
 			{
 				size_t new_string_size = size() + other_string.size();
-				String new_string(new_string_size);
+				BasicString new_string(new_string_size);
 
 				// Push the first String
 
@@ -324,7 +340,7 @@ namespace flow {
 			 *  @note  Runtime: O(n + m), n = size(), m = other_string.size()
 			 *  @note  Memory: O(n + m)
 			 */
-			String operator+(String& other_string) const
+			BasicString operator+(BasicString& other_string) const
 			{
 				return concatenate(other_string);
 			}
@@ -337,10 +353,10 @@ namespace flow {
 			 *  @note  Memory: O(n + m)
 			 */
 			template <size_t char_count>
-			String concatenate(const char (&chars)[char_count]) const
+			BasicString concatenate(const char (&chars)[char_count]) const
 			{
 				size_t new_string_size = size() + char_count - 1;
-				String new_string(new_string_size);
+				BasicString new_string(new_string_size);
 
 				// Push the first String
 
@@ -365,7 +381,7 @@ namespace flow {
 			 *  @note  Memory: O(n + m)
 			 */
 			template <size_t char_count>
-			String operator+(const char (&chars)[char_count]) const
+			BasicString operator+(const char (&chars)[char_count]) const
 			{
 				return concatenate(chars);
 			}
@@ -377,10 +393,10 @@ namespace flow {
 			 *  @note  Runtime: O(n * m), n = size(), m = repeat_count
 			 *  @note  Memory: O(n * m)
 			 */
-			String duplicate(size_t repeat_count) const
+			BasicString duplicate(size_t repeat_count) const
 			{
 				size_t new_string_size = size() * repeat_count;
-				String new_string(new_string_size);
+				BasicString new_string(new_string_size);
 
 				// Push the String repeat_count times
 
@@ -400,7 +416,7 @@ namespace flow {
 			 *  @note  Runtime: O(n * m), n = size(), m = repeat_count
 			 *  @note  Memory: O(n * m)
 			 */
-			String operator*(size_t repeat_count) const
+			BasicString operator*(size_t repeat_count) const
 			{
 				return duplicate(repeat_count);
 			}
@@ -430,7 +446,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = other_string.size()
 			 *  @note  Memory: O(1)
 			 */
-			bool ends_with(String& other_string) const
+			bool ends_with(BasicString& other_string) const
 			{
 				if (other_string.size() > size()) return false;
 
@@ -469,7 +485,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = other_string.size()
 			 *  @note  Memory: O(1)
 			 */
-			bool starts_with(String& other_string) const
+			bool starts_with(BasicString& other_string) const
 			{
 				if (other_string.size() > size()) return false;
 
@@ -509,7 +525,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = substring.size() (early returns false)
 			 *  @note  Memory: O(1)
 			 */
-			bool substring_occurs_at(const String& substring, size_t index = 0) const
+			bool substring_occurs_at(const BasicString& substring, size_t index = 0) const
 			{
 				if (index + substring.size() > size()) return false;
 
@@ -523,7 +539,7 @@ namespace flow {
 
 			// Prevent C++ inherited class Name Hiding
 
-			using DynamicArray::indices_of;
+			using Base::indices_of;
 
 			/**
 			 *  @brief  Returns the indices all occurrences of a given character sequence.
@@ -570,7 +586,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = size()
 			 *  @note  Memory: O(n), n = found indices
 			 */
-			DynamicArray<size_t> indices_of(String& other_string) const
+			DynamicArray<size_t> indices_of(BasicString& other_string) const
 			{
 				DynamicArray<size_t> indices;
 
@@ -643,7 +659,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = size()
 			 *  @note  Memory: O(1)
 			 */
-			bool includes(String& other_string) const
+			bool includes(BasicString& other_string) const
 			{
 				if (other_string.size() > size()) return false;
 
@@ -774,158 +790,361 @@ namespace flow {
 			}
 
 			/**
-			 *  @brief  Replaces all matches of a given search_character with another
-			 *  character sequence
-			 *  @param  search_character  The character to search.
-			 *  @param  chars  The character sequence to replace each match with.
-			 *  @note  Runtime: O(n + m * o), n = size(), m = char_count, o = found matches
-			 *  @note  Memory: O(o)
+			 *  @brief  A single search and replacement pair, used by
+			 *  String::replace_all(). The pair does not own the characters
+			 *  it refers to, they must outlive the call to String::replace_all().
 			 */
-			template <size_t char_count>
-			void replace(char search_character, const char (&chars)[char_count])
-			{
-				// Get the indices of the found matches
+			struct Replacement {
+				const char *search_chars;
+				size_t search_len;
+				const char *replacement_chars;
+				size_t replacement_len;
+
+				Replacement() {}
+
+				Replacement(
+					const char *search_chars, size_t search_len,
+					const char *replacement_chars, size_t replacement_len
+				) : search_chars(search_chars), search_len(search_len),
+					replacement_chars(replacement_chars),
+					replacement_len(replacement_len) {}
+
+				template <size_t search_chars_count, size_t replacement_chars_count>
+				Replacement(
+					const char (&search_chars)[search_chars_count],
+					const char (&replacement_chars)[replacement_chars_count]
+				) : Replacement(search_chars, search_chars_count - 1,
+					replacement_chars, replacement_chars_count - 1) {}
+
+				template <size_t replacement_chars_count>
+				Replacement(
+					const BasicString& search_string,
+					const char (&replacement_chars)[replacement_chars_count]
+				) : Replacement(search_string.data(), search_string.size(),
+					replacement_chars, replacement_chars_count - 1) {}
+
+				template <size_t search_chars_count>
+				Replacement(
+					const char (&search_chars)[search_chars_count],
+					const BasicString& replacement_string
+				) : Replacement(search_chars, search_chars_count - 1,
+					replacement_string.data(), replacement_string.size()) {}
+
+				Replacement(
+					const BasicString& search_string,
+					const BasicString& replacement_string
+				) : Replacement(search_string.data(), search_string.size(),
+					replacement_string.data(), replacement_string.size()) {}
+			};
+
+		private:
+			/**
+			 *  @brief  A match found by String::replace_all(), the offset of
+			 *  the match and the index of the Replacement that matched.
+			 */
+			struct ReplacementMatch {
+				size_t offset;
+				size_t index;
+			};
 
-				DynamicArray<size_t> found_positions = indices_of(search_character);
+			/**
+			 *  @brief  Walks over all non-overlapping matches of a set of
+			 *  Replacements from left to right and calls a callback for each.
+			 *  When multiple search sequences match at the same position, the
+			 *  one that comes first in the list wins.
+			 *  The next match of every search sequence is cached, so each
+			 *  sequence is only searched again once a match consumes the
+			 *  position it was cached at.
+			 *  @param  replacements  The Replacements to search for.
+			 *  @param  replacement_count  The number of Replacements.
+			 *  @param  callback  Is called with the index of each match and the
+			 *  index of the Replacement that matched.
+			 *  @note  Runtime: O(n * m), n = size(), m = replacement_count
+			 *  @note  Memory: O(m)
+			 */
+			template <typename Callback>
+			void for_each_replacement_match(
+				const Replacement *replacements,
+				size_t replacement_count,
+				Callback callback
+			) const
+			{
+				const char *str = data();
+				size_t len = size();
 
-				// Reserve enough space and increment the size manually
+				// Offset of the next match per Replacement, SIZE_MAX if none
 
-				size_t extra_chars = found_positions.size() * (char_count - 2);
-				reserve(extra_chars);
-				unsafe_increment_element_count(extra_chars);
+				size_t stack_next_matches[16];
+				size_t *next_matches = replacement_count <= 16
+					? stack_next_matches
+					: new size_t[replacement_count];
 
-				// Replace each match
+				auto find_from = [&](size_t offset, const Replacement& r) {
+					if (r.search_len == 0) return SIZE_MAX;
 
-				size_t prev_pos = size();
+					const char *match = flow_tools::find_chars(str + offset,
+						len - offset, r.search_chars, r.search_len);
 
-				for (size_t i = found_positions.size(); i > 0; i--) {
-					size_t pos = found_positions[i - 1];
-					size_t offset = i * (char_count - 2);
+					return match == NULL ? SIZE_MAX : (size_t) (match - str);
+				};
 
-					// Shift the part of the String
+				for (size_t i = 0; i < replacement_count; i++) {
+					next_matches[i] = find_from(0, replacements[i]);
+				}
 
-					shift_right(offset, pos + 1, prev_pos - pos - 1);
+				while (true) {
+					// Take the leftmost match
 
-					// Put the new character sequence in the created gap
+					size_t match = SIZE_MAX;
+					size_t match_index = 0;
 
-					for (size_t j = 0; j < char_count - 1; j++) {
-						set_at_index(pos + (i - 1) * (char_count - 2) + j, chars[j]);
+					for (size_t i = 0; i < replacement_count; i++) {
+						if (next_matches[i] < match) {
+							match = next_matches[i];
+							match_index = i;
+						}
 					}
 
-					prev_pos = pos;
+					if (match == SIZE_MAX) break;
+
+					callback(match, match_index);
+
+					// Search again for the matches that were consumed
+
+					size_t offset = match + replacements[match_index].search_len;
+
+					for (size_t i = 0; i < replacement_count; i++) {
+						if (next_matches[i] < offset) {
+							next_matches[i] = find_from(offset, replacements[i]);
+						}
+					}
 				}
+
+				if (next_matches != stack_next_matches) delete[] next_matches;
 			}
 
+		public:
 			/**
-			 *  @brief  Replaces all matches of a given character sequence with
-			 *  another character sequence
-			 *  @param  search_chars  The character sequence to search and replace.
-			 *  @param  replacement_chars  The character sequence to replace it with.
-			 *  @note  Runtime: O(n + m * o), n = size(), m = search_chars length,
-			 *  o = found matches
-			 *  @note  Memory: O(o)
+			 *  @brief  Replaces all non-overlapping matches of a set of character
+			 *  sequences in a single left to right pass. When multiple search
+			 *  sequences match at the same position, the one that comes first
+			 *  in the list wins. Replaced characters are never searched again.
+			 *  If no Replacement makes the String grow, it is rewritten in place
+			 *  from the front. Otherwise the matches are collected first, and
+			 *  the String is rewritten in place from the back if the result
+			 *  fits in its capacity, or into a new buffer if it does not.
+			 *  @param  replacements  Pointer to the first Replacement.
+			 *  @param  replacement_count  The number of Replacements.
+			 *  @note  Runtime: O(n * m), n = size(), m = replacement_count
+			 *  @note  Memory: O(1) if the String does not grow, O(k) for k
+			 *  matches if it grows within its capacity, O(n + k) otherwise
 			 */
-			template <size_t search_chars_count, size_t replacement_chars_count>
-			void replace(
-				const char (&search_chars)[search_chars_count],
-				const char (&replacement_chars)[replacement_chars_count]
-			)
+			void replace_all(const Replacement *replacements, size_t replacement_count)
 			{
-				// Get the indices of the found matches
+				bool grows = false;
 
-				DynamicArray<size_t> found_positions = indices_of(search_chars);
-
-				if (replacement_chars_count == search_chars_count) {
-					// The character counts match, no shifting is necessary
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-
-						for (size_t j = 0; j < replacement_chars_count - 1; j++) {
-							set_at_index(pos + j, replacement_chars[j]);
-						}
+				for (size_t i = 0; i < replacement_count; i++) {
+					if (replacements[i].replacement_len > replacements[i].search_len) {
+						grows = true;
 					}
-				} else if (replacement_chars_count > search_chars_count) {
-					// The String will grow
-					// Reserve enough space and increment the size manually
+				}
 
-					size_t size_diff = replacement_chars_count - search_chars_count;
-					size_t extra_chars = found_positions.size() * size_diff;
+				if (!grows) {
+					// The write cursor never overtakes the read cursor,
+					// so the String can be rewritten in place
 
-					size_t prev_pos = size();
+					char *write_ptr = buffer;
+					size_t read_offset = 0;
 
-					reserve(extra_chars);
-					unsafe_increment_element_count(extra_chars);
+					for_each_replacement_match(replacements, replacement_count,
+						[&](size_t match, size_t match_index)
+					{
+						const Replacement& r = replacements[match_index];
+						size_t segment_len = match - read_offset;
 
-					// Replace each match, right to left
+						if (write_ptr != buffer + read_offset) {
+							memmove(write_ptr, buffer + read_offset, segment_len);
+						}
 
-					for (size_t i = found_positions.size(); i > 0; i--) {
-						size_t pos = found_positions[i - 1];
-						size_t offset = i * size_diff;
+						write_ptr += segment_len;
+						memcpy(write_ptr, r.replacement_chars, r.replacement_len);
+						write_ptr += r.replacement_len;
+						read_offset = match + r.search_len;
+					});
 
-						// Index to shift from
+					size_t rest_len = size() - read_offset;
 
-						size_t starting_index = pos + extra_chars - 1;
+					if (write_ptr != buffer + read_offset) {
+						memmove(write_ptr, buffer + read_offset, rest_len);
+					}
 
-						// Length of the right shift
+					unsafe_set_element_count(write_ptr + rest_len - buffer);
+					return;
+				}
 
-						size_t shift_length = prev_pos - starting_index;
+				// Collect the matches and the size of the result in one search.
+				// The String can be rewritten in place from the back if it
+				// fits and no write overtakes unread characters, which holds
+				// as long as no run of matches from the front shrinks it
+
+				ReplacementMatch stack_matches[32];
+				ReplacementMatch *matches = stack_matches;
+				size_t match_capacity = 32;
+				size_t match_count = 0;
+
+				size_t new_size = size();
+				bool shrinks_front = false;
+
+				for_each_replacement_match(replacements, replacement_count,
+					[&](size_t match, size_t match_index)
+				{
+					if (match_count == match_capacity) {
+						ReplacementMatch *grown = new ReplacementMatch[match_capacity * 2];
+						memcpy(grown, matches, sizeof(ReplacementMatch) * match_count);
+						if (matches != stack_matches) delete[] matches;
+
+						matches = grown;
+						match_capacity *= 2;
+					}
 
-						// Shift the inter part of the String to the right
+					matches[match_count++] = ReplacementMatch { match, match_index };
 
-						shift_right(offset, starting_index, shift_length);
+					const Replacement& r = replacements[match_index];
+					new_size = new_size - r.search_len + r.replacement_len;
+					if (new_size < size()) shrinks_front = true;
+				});
 
-						// Put the new character sequence in the created gap
+				if (match_count == 0) return;
 
-						for (size_t j = 0; j < replacement_chars_count - 1; j++) {
-							size_t index = pos + (i - 1) * size_diff + j;
-							set_at_index(index, replacement_chars[j]);
-						}
+				if (new_size <= current_buffer_size && !shrinks_front) {
+					char *write_ptr = buffer + new_size;
+					size_t read_end = size();
+
+					for (size_t i = match_count; i-- > 0;) {
+						const Replacement& r = replacements[matches[i].index];
+						size_t segment_start = matches[i].offset + r.search_len;
+						size_t segment_len = read_end - segment_start;
 
-						prev_pos = pos;
+						write_ptr -= segment_len;
+						memmove(write_ptr, buffer + segment_start, segment_len);
+						write_ptr -= r.replacement_len;
+						memcpy(write_ptr, r.replacement_chars, r.replacement_len);
+						read_end = matches[i].offset;
 					}
+
+					unsafe_set_element_count(new_size);
 				} else {
-					// The String will shrink
+					// Write the result into a new buffer
 
-					size_t size_diff = search_chars_count - replacement_chars_count;
-					size_t redundant_chars = found_positions.size() * size_diff;
+					size_t new_buffer_size = new_size > current_buffer_size
+						? calc_growth_size(new_size)
+						: current_buffer_size;
 
-					// Replace each match, left to right
+					size_t old_buffer_size = current_buffer_size;
+					current_buffer_size = new_buffer_size;
 
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-						size_t next_pos = (i == found_positions.size() - 1)
-							? size() - 1
-							: found_positions[i + 1];
+					char *new_buffer = allocate_buffer();
+					char *write_ptr = new_buffer;
+					size_t read_offset = 0;
 
-						// Put the new character sequence straight in place
+					for (size_t i = 0; i < match_count; i++) {
+						const Replacement& r = replacements[matches[i].index];
+						size_t segment_len = matches[i].offset - read_offset;
 
-						for (size_t j = 0; j < replacement_chars_count - 1; j++) {
-							size_t index = pos - i * size_diff + j;
-							set_at_index(index, replacement_chars[j]);
-						}
+						memcpy(write_ptr, buffer + read_offset, segment_len);
+						write_ptr += segment_len;
+						memcpy(write_ptr, r.replacement_chars, r.replacement_len);
+						write_ptr += r.replacement_len;
+						read_offset = matches[i].offset + r.search_len;
+					}
 
-						size_t offset = (i + 1) * size_diff;
+					memcpy(write_ptr, buffer + read_offset, size() - read_offset);
 
-						// Index to shift from
+					free_buffer(buffer, old_buffer_size);
+					buffer = new_buffer;
+					unsafe_set_element_count(new_size);
+				}
 
-						size_t starting_index = pos + search_chars_count - 1;
+				if (matches != stack_matches) delete[] matches;
+			}
 
-						// Length of the left shift
+			/**
+			 *  @brief  Replaces all non-overlapping matches of a set of character
+			 *  sequences in a single left to right pass.
+			 *  Example: str.replace_all({ { "\r\n", "\n" }, { "\t", "  " } });
+			 *  @param  replacements  The Replacements to apply.
+			 *  @note  Runtime: O(n * m), n = size(), m = replacements.size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
+			 */
+			void replace_all(std::initializer_list<Replacement> replacements)
+			{
+				replace_all(replacements.begin(), replacements.size());
+			}
 
-						size_t shift_length = next_pos - starting_index;
+			/**
+			 *  @brief  Replaces all non-overlapping matches of a set of character
+			 *  sequences in a single left to right pass.
+			 *  @param  replacements  The Replacements to apply.
+			 *  @note  Runtime: O(n * m), n = size(), m = replacements.size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
+			 */
+			void replace_all(const DynamicArray<Replacement>& replacements)
+			{
+				replace_all(replacements.data(), replacements.size());
+			}
 
-						// Shift the inter part of the String to the left
+			/**
+			 *  @brief  Replaces all matches of a given character sequence with
+			 *  another character sequence.
+			 *  @param  search_chars  Pointer to the characters to search.
+			 *  @param  search_len  The number of characters to search.
+			 *  @param  replacement_chars  Pointer to the characters to replace
+			 *  each match with.
+			 *  @param  replacement_len  The number of replacement characters.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
+			 */
+			void replace(
+				const char *search_chars, size_t search_len,
+				const char *replacement_chars, size_t replacement_len
+			)
+			{
+				Replacement r(search_chars, search_len,
+					replacement_chars, replacement_len);
 
-						shift_left(offset, starting_index, shift_length);
-					}
+				replace_all(&r, 1);
+			}
 
-					// Shorten the String
+			/**
+			 *  @brief  Replaces all matches of a given search_character with another
+			 *  character sequence
+			 *  @param  search_character  The character to search.
+			 *  @param  chars  The character sequence to replace each match with.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
+			 */
+			template <size_t char_count>
+			void replace(char search_character, const char (&chars)[char_count])
+			{
+				replace(&search_character, 1, chars, char_count - 1);
+			}
 
-					unreserve(redundant_chars);
-					unsafe_decrement_element_count(redundant_chars);
-				}
+			/**
+			 *  @brief  Replaces all matches of a given character sequence with
+			 *  another character sequence
+			 *  @param  search_chars  The character sequence to search and replace.
+			 *  @param  replacement_chars  The character sequence to replace it with.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
+			 */
+			template <size_t search_chars_count, size_t replacement_chars_count>
+			void replace(
+				const char (&search_chars)[search_chars_count],
+				const char (&replacement_chars)[replacement_chars_count]
+			)
+			{
+				replace(search_chars, search_chars_count - 1,
+					replacement_chars, replacement_chars_count - 1);
 			}
 
 			/**
@@ -933,111 +1152,17 @@ namespace flow {
 			 *  character sequence
 			 *  @param  search_string  The String to search and replace.
 			 *  @param  replacement_chars  The character sequence to replace it with.
-			 *  @note  Runtime: O(n + m * o), n = size(), m = search_string.size(),
-			 *  o = found matches
-			 *  @note  Memory: O(o)
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
 			 */
 			template <size_t replacement_chars_count>
 			void replace(
-				String& search_string,
+				const BasicString& search_string,
 				const char (&replacement_chars)[replacement_chars_count]
 			)
 			{
-				// Get the indices of the found matches
-
-				DynamicArray<size_t> found_positions = indices_of(search_string);
-
-				if (replacement_chars_count - 1 == search_string.size()) {
-					// The string sizes match, no shifting is necessary
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-
-						for (size_t j = 0; j < replacement_chars_count - 1; j++) {
-							set_at_index(pos + j, replacement_chars[j]);
-						}
-					}
-				} else if (replacement_chars_count - 1 > search_string.size()) {
-					// The String will grow
-					// Reserve enough space and increment the size manually
-
-					size_t size_diff = replacement_chars_count - 1 - search_string.size();
-					size_t extra_chars = found_positions.size() * size_diff;
-
-					size_t prev_pos = size();
-
-					reserve(extra_chars);
-					unsafe_increment_element_count(extra_chars);
-
-					// Replace each match, right to left
-
-					for (size_t i = found_positions.size(); i > 0; i--) {
-						size_t pos = found_positions[i - 1];
-						size_t offset = i * size_diff;
-
-						// Index to shift from
-
-						size_t starting_index = pos + extra_chars - 1;
-
-						// Length of the right shift
-
-						size_t shift_length = prev_pos - starting_index;
-
-						// Shift the inter part of the String to the right
-
-						shift_right(offset, starting_index, shift_length);
-
-						// Put the new character sequence in the created gap
-
-						for (size_t j = 0; j < replacement_chars_count - 1; j++) {
-							size_t index = pos + (i - 1) * size_diff + j;
-							set_at_index(index, replacement_chars[j]);
-						}
-
-						prev_pos = pos;
-					}
-				} else {
-					// The String will shrink
-
-					size_t size_diff = search_string.size() - (replacement_chars_count - 1);
-					size_t redundant_chars = found_positions.size() * size_diff;
-
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-						size_t next_pos = (i == found_positions.size() - 1)
-							? size() - 1
-							: found_positions[i + 1];
-
-						// Put the new character sequence straight in place
-
-						for (size_t j = 0; j < replacement_chars_count - 1; j++) {
-							size_t index = pos - i * size_diff + j;
-							set_at_index(index, replacement_chars[j]);
-						}
-
-						size_t offset = (i + 1) * size_diff;
-
-						// Index to shift from
-
-						size_t starting_index = pos + search_string.size();
-
-						// Length of the left shift
-
-						size_t shift_length = next_pos - starting_index;
-
-						// Shift the inter part of the String to the left
-
-						shift_left(offset, starting_index, shift_length);
-					}
-
-					// Shorten the String
-
-					unreserve(redundant_chars);
-					unsafe_decrement_element_count(redundant_chars);
-				}
+				replace(search_string.data(), search_string.size(),
+					replacement_chars, replacement_chars_count - 1);
 			}
 
 			/**
@@ -1045,111 +1170,17 @@ namespace flow {
 			 *  another replacement_string
 			 *  @param  search_chars  The character sequence to search and replace.
 			 *  @param  replacement_string  The String to replace it with.
-			 *  @note  Runtime: O(n + m * o), n = size(), m = search_chars length,
-			 *  o = found matches
-			 *  @note  Memory: O(o)
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
 			 */
 			template <size_t search_chars_count>
 			void replace(
 				const char (&search_chars)[search_chars_count],
-				String& replacement_string
+				const BasicString& replacement_string
 			)
 			{
-				// Get the indices of the found matches
-
-				DynamicArray<size_t> found_positions = indices_of(search_chars);
-
-				if (replacement_string.size() == search_chars_count - 1) {
-					// The character counts match, no shifting is necessary
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-
-						for (size_t j = 0; j < replacement_string.size(); j++) {
-							set_at_index(pos + j, replacement_string[j]);
-						}
-					}
-				} else if (replacement_string.size() > search_chars_count - 1) {
-					// The String will grow
-					// Reserve enough space and increment the size manually
-
-					size_t size_diff = replacement_string.size() - (search_chars_count - 1);
-					size_t extra_chars = found_positions.size() * size_diff;
-
-					size_t prev_pos = size();
-
-					reserve(extra_chars);
-					unsafe_increment_element_count(extra_chars);
-
-					// Replace each match, right to left
-
-					for (size_t i = found_positions.size(); i > 0; i--) {
-						size_t pos = found_positions[i - 1];
-						size_t offset = i * size_diff;
-
-						// Index to shift from
-
-						size_t starting_index = pos + extra_chars - 1;
-
-						// Length of the right shift
-
-						size_t shift_length = prev_pos - starting_index;
-
-						// Shift the inter part of the String to the right
-
-						shift_right(offset, starting_index, shift_length);
-
-						// Put the new character sequence in the created gap
-
-						for (size_t j = 0; j < replacement_string.size(); j++) {
-							size_t index = pos + (i - 1) * size_diff + j;
-							set_at_index(index, replacement_string[j]);
-						}
-
-						prev_pos = pos;
-					}
-				} else {
-					// The String will shrink
-
-					size_t size_diff = (search_chars_count - 1) - replacement_string.size();
-					size_t redundant_chars = found_positions.size() * size_diff;
-
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-						size_t next_pos = (i == found_positions.size() - 1)
-							? size() - 1
-							: found_positions[i + 1];
-
-						// Put the new character sequence straight in place
-
-						for (size_t j = 0; j < replacement_string.size(); j++) {
-							size_t index = pos - i * size_diff + j;
-							set_at_index(index, replacement_string[j]);
-						}
-
-						size_t offset = (i + 1) * size_diff;
-
-						// Index to shift from
-
-						size_t starting_index = pos + search_chars_count - 1;
-
-						// Length of the left shift
-
-						size_t shift_length = next_pos - starting_index;
-
-						// Shift the inter part of the String to the left
-
-						shift_left(offset, starting_index, shift_length);
-					}
-
-					// Shorten the String
-
-					unreserve(redundant_chars);
-					unsafe_decrement_element_count(redundant_chars);
-				}
+				replace(search_chars, search_chars_count - 1,
+					replacement_string.data(), replacement_string.size());
 			}
 
 			/**
@@ -1157,110 +1188,16 @@ namespace flow {
 			 *  replacement_string
 			 *  @param  search_string  The String to search and replace.
 			 *  @param  replacement_string  The String to replace it with.
-			 *  @note  Runtime: O(n + m * o), n = size(), m = search_string.size(),
-			 *  o = found matches
-			 *  @note  Memory: O(o)
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1) if the String does not grow, O(n) otherwise
 			 */
 			void replace(
-				String& search_string,
-				String& replacement_string
+				const BasicString& search_string,
+				const BasicString& replacement_string
 			)
 			{
-				// Get the indices of the found matches
-
-				DynamicArray<size_t> found_positions = indices_of(search_string);
-
-				if (replacement_string.size() == search_string.size()) {
-					// The string sizes match, no shifting is necessary
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-
-						for (size_t j = 0; j < replacement_string.size(); j++) {
-							set_at_index(pos + j, replacement_string[j]);
-						}
-					}
-				} else if (replacement_string.size() > search_string.size()) {
-					// The String will grow
-					// Reserve enough space and increment the size manually
-
-					size_t size_diff = replacement_string.size() - search_string.size();
-					size_t extra_chars = found_positions.size() * size_diff;
-
-					size_t prev_pos = size();
-
-					reserve(extra_chars);
-					unsafe_increment_element_count(extra_chars);
-
-					// Replace each match, right to left
-
-					for (size_t i = found_positions.size(); i > 0; i--) {
-						size_t pos = found_positions[i - 1];
-						size_t offset = i * size_diff;
-
-						// Index to shift from
-
-						size_t starting_index = pos + extra_chars - 1;
-
-						// Length of the right shift
-
-						size_t shift_length = prev_pos - starting_index;
-
-						// Shift the inter part of the String to the right
-
-						shift_right(offset, starting_index, shift_length);
-
-						// Put the new character sequence in the created gap
-
-						for (size_t j = 0; j < replacement_string.size(); j++) {
-							size_t index = pos + (i - 1) * size_diff + j;
-							set_at_index(index, replacement_string[j]);
-						}
-
-						prev_pos = pos;
-					}
-				} else {
-					// The String will shrink
-
-					size_t size_diff = search_string.size() - replacement_string.size();
-					size_t redundant_chars = found_positions.size() * size_diff;
-
-					// Replace each match, left to right
-
-					for (size_t i = 0; i < found_positions.size(); i++) {
-						size_t pos = found_positions[i];
-						size_t next_pos = (i == found_positions.size() - 1)
-							? size() - 1
-							: found_positions[i + 1];
-
-						// Put the new character sequence straight in place
-
-						for (size_t j = 0; j < replacement_string.size(); j++) {
-							size_t index = pos - i * size_diff + j;
-							set_at_index(index, replacement_string[j]);
-						}
-
-						size_t offset = (i + 1) * size_diff;
-
-						// Index to shift from
-
-						size_t starting_index = pos + search_string.size();
-
-						// Length of the left shift
-
-						size_t shift_length = next_pos - starting_index;
-
-						// Shift the inter part of the String to the left
-
-						shift_left(offset, starting_index, shift_length);
-					}
-
-					// Shorten the String
-
-					unreserve(redundant_chars);
-					unsafe_decrement_element_count(redundant_chars);
-				}
+				replace(search_string.data(), search_string.size(),
+					replacement_string.data(), replacement_string.size());
 			}
 
 			/**
@@ -1272,11 +1209,11 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = min(length, size() - offset)
 			 *  @note  Memory: O(n), n = min(length, size() - offset)
 			 */
-			String substring(size_t offset, size_t length = SIZE_MAX) const
+			BasicString substring(size_t offset, size_t length = SIZE_MAX) const
 			{
 				length = std::min(length, size() - offset);
 
-				String str(length);
+				BasicString str(length);
 				str.unsafe_increment_element_count(length);
 
 				for (size_t i = 0; i < length; i++) {
@@ -1296,17 +1233,17 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = min(right_index, size()) - left_index + 1
 			 *  @note  Memory: O(n), n = min(right_index, size()) - left_index + 1
 			 */
-			String between(size_t left_index, size_t right_index = SIZE_MAX) const
+			BasicString between(size_t left_index, size_t right_index = SIZE_MAX) const
 			{
 				right_index = std::min(right_index, size());
 
 				if (left_index > right_index) {
-					return String(0UL);
+					return BasicString(0UL);
 				}
 
 				size_t length = right_index - left_index + 1;
 
-				String str(length);
+				BasicString str(length);
 				str.unsafe_increment_element_count(length);
 
 				for (size_t i = 0; i < length; i++) {
@@ -1324,12 +1261,12 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = size()
 			 *  @note  Memory: O(n), n = size()
 			 */
-			DynamicArray<String> split(char delimiter) const
+			DynamicArray<BasicString> split(char delimiter) const
 			{
 				DynamicArray<size_t> found_indices = indices_of(delimiter);
 
 				size_t strings_size = found_indices.size() + 1;
-				DynamicArray<String> strings(strings_size);
+				DynamicArray<BasicString> strings(strings_size);
 				strings.unsafe_increment_element_count(strings_size);
 
 				for (size_t i = 0; i < strings_size; i++) {
@@ -1341,7 +1278,7 @@ namespace flow {
 						? found_indices[i] - 1
 						: size() - 1;
 
-					String substr = between(left_index, right_index);
+					BasicString substr = between(left_index, right_index);
 					strings[i] = substr;
 				}
 
@@ -1357,12 +1294,12 @@ namespace flow {
 			 *  @note  Memory: O(n), n = size()
 			 */
 			template <size_t char_count>
-			DynamicArray<String> split(const char (&delimiter)[char_count]) const
+			DynamicArray<BasicString> split(const char (&delimiter)[char_count]) const
 			{
 				DynamicArray<size_t> found_indices = indices_of(delimiter);
 
 				size_t strings_size = found_indices.size() + 1;
-				DynamicArray<String> strings(strings_size);
+				DynamicArray<BasicString> strings(strings_size);
 				strings.unsafe_increment_element_count(strings_size);
 
 				for (size_t i = 0; i < strings_size; i++) {
@@ -1374,7 +1311,7 @@ namespace flow {
 						? found_indices[i] - 1
 						: size() - 1;
 
-					String substr = between(left_index, right_index);
+					BasicString substr = between(left_index, right_index);
 					strings[i] = substr;
 				}
 
@@ -1389,12 +1326,12 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = size()
 			 *  @note  Memory: O(n), n = size()
 			 */
-			DynamicArray<String> split(String delimiter) const
+			DynamicArray<BasicString> split(BasicString delimiter) const
 			{
 				DynamicArray<size_t> found_indices = indices_of(delimiter);
 
 				size_t strings_size = found_indices.size() + 1;
-				DynamicArray<String> strings(strings_size);
+				DynamicArray<BasicString> strings(strings_size);
 				strings.unsafe_increment_element_count(strings_size);
 
 				for (size_t i = 0; i < strings_size; i++) {
@@ -1406,7 +1343,7 @@ namespace flow {
 						? found_indices[i] - 1
 						: size() - 1;
 
-					String substr = between(left_index, right_index);
+					BasicString substr = between(left_index, right_index);
 					strings[i] = substr;
 				}
 
@@ -1422,7 +1359,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = delim_index - index
 			 *  @note  Memory: O(n), n = delim_index - index
 			 */
-			String delimit(char delimiter, size_t index = 0) const
+			BasicString delimit(char delimiter, size_t index = 0) const
 			{
 				size_t right_index = size() - 1;
 
@@ -1446,7 +1383,7 @@ namespace flow {
 			 *  @note  Memory: O(n), n = delim_index - index
 			 */
 			template <size_t delimeter_len>
-			String delimit(const char (&delimiter)[delimeter_len], size_t index = 0) const
+			BasicString delimit(const char (&delimiter)[delimeter_len], size_t index = 0) const
 			{
 				size_t right_index = size() - 1;
 
@@ -1469,7 +1406,7 @@ namespace flow {
 			 *  @note  Runtime: O(n), n = delim_index - index
 			 *  @note  Memory: O(n), n = delim_index - index
 			 */
-			String delimit(const String& delimiter, size_t index = 0) const
+			BasicString delimit(const BasicString& delimiter, size_t index = 0) const
 			{
 				size_t right_index = size() - 1;
 
@@ -1511,686 +1448,437 @@ namespace flow {
 				}
 			}
 
+		private:
 			/**
-			 *  @brief  Formats a String
+			 *  @brief  Returns the unsigned value whose digits are written for
+			 *  an integer argument. For 'd', 'i' and 'u' this is the absolute
+			 *  value, 'o', 'x' and 'X' write the two's complement of negatives.
 			 */
-			static String format(const char* fmt, ...)
+			template <typename intx_t>
+			static std::make_unsigned_t<intx_t> format_int_magnitude(
+				char conversion, intx_t num)
 			{
-				// Size calculation
-
-				va_list args;
-				va_start(args, fmt);
-
-				size_t size = 0;
-				size_t i = 0;
-
-				#define SIZE_8  0
-				#define SIZE_16 1
-				#define SIZE_32 2
-				#define SIZE_64 3
+				using uintx_t = std::make_unsigned_t<intx_t>;
 
-				#define err(message, ...) \
-					fprintf(stderr, message, ##__VA_ARGS__); \
-					exit(1)
-
-				uint8_t length_modifier = SIZE_32;
-				bool length_modifier_set = false;
-				char pad_char = '\0';
-				size_t pad_size = 0;
-				size_t precision = 6;
-				bool precision_modifier_set = false;
-				size_t num_size;
-
-				while (fmt[i] != '\0') {
-					if (fmt[i] == '%') {
-						continue_specifier:
-						i++;
-
-						switch (fmt[i]) {
-							case '%':
-								size++;
-									goto end_specifier;
-
-							case 'd':
-							case 'i':
-								switch (length_modifier) {
-									case SIZE_8:
-										// Max length is 4 ("-128")
-
-										va_arg(args, int32_t);
-										num_size = 4;
-										break;
-
-									case SIZE_16:
-										// Max length is 6 ("-32768")
+				if constexpr (std::is_signed_v<intx_t>) {
+					if (num < 0 && conversion != 'o'
+						&& conversion != 'x' && conversion != 'X') {
+						return (uintx_t) ((uintx_t) 0 - (uintx_t) num);
+					}
+				}
 
-										va_arg(args, int32_t);
-										num_size = 6;
-										break;
+				return (uintx_t) num;
+			}
 
-									case SIZE_32:
-										// Max length is 11 ("-2147483648")
+			template <typename intx_t>
+			static bool format_int_is_negative(intx_t num)
+			{
+				if constexpr (std::is_signed_v<intx_t>) return num < 0;
+				else return false;
+			}
 
-										va_arg(args, int32_t);
-										num_size = 11;
-										break;
+			/**
+			 *  @brief  Returns the number of characters an integer argument
+			 *  is written with, excluding padding.
+			 */
+			template <typename intx_t>
+			static size_t format_int_len(char conversion, intx_t num)
+			{
+				uint64_t magnitude = format_int_magnitude(conversion, num);
 
-									case SIZE_64:
-										// Max length is 20 ("-9223372036854775808")
+				switch (conversion) {
+					case 'c':
+						return 1;
 
-										va_arg(args, int64_t);
-										num_size = 20;
-										break;
-								}
+					case 'o':
+						return 2 + (std::bit_width(magnitude | 1) + 2) / 3;
 
-								size += std::max(num_size, pad_size);
-								goto end_specifier;
+					case 'x':
+					case 'X':
+						return 2 + (std::bit_width(magnitude | 1) + 3) / 4;
 
-							case 'u':
-								switch (length_modifier) {
-									case SIZE_8:
-										// Max length is 3 ("256")
+					default:
+						return format_int_is_negative(num)
+							+ flow_tools::count_digits(magnitude);
+				}
+			}
 
-										va_arg(args, uint32_t);
-										num_size = 3;
-										break;
+			/**
+			 *  @brief  Writes the padding for an argument of a certain length.
+			 *  @returns  The number of bytes written.
+			 */
+			static size_t write_format_padding(const FormatSpec& spec,
+				size_t len, char *buf)
+			{
+				if (spec.pad_size <= len) return 0;
 
-									case SIZE_16:
-										// Max length is 5 ("65536")
+				size_t padding = spec.pad_size - len;
+				memset(buf, spec.pad_char, padding);
+				return padding;
+			}
 
-										va_arg(args, uint32_t);
-										num_size = 5;
-										break;
-
-									case SIZE_32:
-										// Max length is 10 ("4294967296")
-
-										va_arg(args, uint32_t);
-										num_size = 10;
-										break;
-
-									case SIZE_64:
-										// Max length is 20 ("18446744073709551616")
-
-										va_arg(args, uint64_t);
-										num_size = 20;
-										break;
-								}
-
-								size += std::max(num_size, pad_size);
-								goto end_specifier;
-
-							case 'o':
-								switch (length_modifier) {
-									case SIZE_8:
-										// Max length is 5 ("0o400")
-
-										va_arg(args, uint32_t);
-										num_size = 5;
-										break;
-
-									case SIZE_16:
-										// Max length is 8 ("0o200000")
-
-										va_arg(args, uint32_t);
-										num_size = 8;
-										break;
-
-									case SIZE_32:
-										// Max length is 13 ("0o40000000000")
-
-										va_arg(args, uint32_t);
-										num_size = 13;
-										break;
-
-									case SIZE_64:
-										// Max length is 24 ("0o2000000000000000000000")
-
-										va_arg(args, uint64_t);
-										num_size = 24;
-										break;
-								}
-
-								size += std::max(num_size, pad_size);
-								goto end_specifier;
-
-							case 'x':
-							case 'X':
-								switch (length_modifier) {
-									case SIZE_8:
-										// Max length is 5 ("0x100")
+			/**
+			 *  @brief  Writes an integer argument to a buffer.
+			 *  Zero padding goes between the sign or prefix and the digits,
+			 *  space padding goes before the sign or prefix.
+			 *  @returns  The number of bytes written.
+			 */
+			template <typename intx_t>
+			static size_t write_format_int(const FormatSpec& spec, intx_t num,
+				char *buf)
+			{
+				size_t len = format_int_len(spec.conversion, num);
+				size_t offset = 0;
 
-										va_arg(args, uint32_t);
-										num_size = 5;
-										break;
-
-									case SIZE_16:
-										// Max length is 7 ("0x10000")
+				if (spec.conversion == 'c') {
+					offset += write_format_padding(spec, len, buf);
+					buf[offset++] = (char) num;
+					return offset;
+				}
 
-										va_arg(args, uint32_t);
-										num_size = 7;
-										break;
+				if (spec.pad_char == ' ') {
+					offset += write_format_padding(spec, len, buf);
+				}
 
-									case SIZE_32:
-										// Max length is 11 ("0x100000000")
+				size_t prefix_len = 0;
 
-										va_arg(args, uint32_t);
-										num_size = 11;
-										break;
+				if (spec.conversion == 'o' || spec.conversion == 'x'
+					|| spec.conversion == 'X') {
+					buf[offset] = '0';
+					buf[offset + 1] = spec.conversion == 'o' ? 'o' : 'x';
+					prefix_len = 2;
+				} else if (format_int_is_negative(num)) {
+					buf[offset] = '-';
+					prefix_len = 1;
+				}
 
-									case SIZE_64:
-										// Max length is 19 ("0x10000000000000000")
-
-										va_arg(args, uint64_t);
-										num_size = 19;
-										break;
-								}
+				offset += prefix_len;
 
-								size += std::max(num_size, pad_size);
-								goto end_specifier;
+				if (spec.pad_char == '0') {
+					offset += write_format_padding(spec, len, buf + offset);
+				}
 
-							case 'f':
-								switch (length_modifier) {
-									case SIZE_8:
-									case SIZE_16:
-										err("No support for 8 or 16-bit floating point numbers");
+				auto magnitude = format_int_magnitude(spec.conversion, num);
+				size_t digits = len - prefix_len;
 
-									case SIZE_32:
-									case SIZE_64:
-									{
-										double num = va_arg(args, double);
-										num_size = std::max(log10(abs(num)) + 1, 1.0) + 1;
-										break;
-									}
-								}
+				switch (spec.conversion) {
+					case 'o':
+						flow_tools::write_uint_digits<8>(magnitude, buf + offset, digits);
+						break;
 
-								// Fraction digits
-
-								if (precision) num_size += precision + 1; // '.' character
-								size += std::max(num_size, pad_size);
-								goto end_specifier;
+					case 'x':
+						flow_tools::write_uint_digits<16, 'a'>(magnitude, buf + offset, digits);
+						break;
 
-							case 'c':
-							{
-								char c = va_arg(args, int);
-								size += 1;
-								goto end_specifier;
-							}
+					case 'X':
+						flow_tools::write_uint_digits<16, 'A'>(magnitude, buf + offset, digits);
+						break;
 
-							case 's':
-							{
-								const char *char_arr_arg = va_arg(args, const char *);
-
-								if (precision_modifier_set) {
-									size += std::min(precision, strlen(char_arr_arg));
-								} else {
-									size += strlen(char_arr_arg);
-								}
+					default:
+						flow_tools::write_uint_digits<10>(magnitude, buf + offset, digits);
+						break;
+				}
 
-								goto end_specifier;
-							}
+				return offset + digits;
+			}
 
-							case 'S':
-							{
-								String& str_arg = va_arg(args, String);
+			/**
+			 *  @brief  Writes a float argument to a buffer.
+			 *  Zero padding goes between the sign and the digits,
+			 *  space padding goes before the sign.
+			 *  @returns  The number of bytes written.
+			 */
+			static size_t write_format_float(const FormatSpec& spec, double num,
+				char *buf)
+			{
+				size_t len = flow_tools::write_float_to_str(num, buf, spec.precision);
+				if (spec.pad_size <= len) return len;
 
-								if (precision_modifier_set) {
-									size += std::min(precision, str_arg.size());
-								} else {
-									size += str_arg.size();
-								}
-
-								goto end_specifier;
-							}
+				size_t padding = spec.pad_size - len;
+				size_t sign = spec.pad_char == '0' && buf[0] == '-';
 
-							case '0':
-							{
-								if (pad_char) {
-									err("Cannot set padding modifier twice (0)\n");
-								}
-
-								pad_char = '0';
-								flow_tools::UintFromStr num_and_len =
-									flow_tools::read_uint_from_str(fmt + i + 1);
-								i += num_and_len.len;
+				memmove(buf + sign + padding, buf + sign, len - sign);
+				memset(buf + sign, spec.pad_char, padding);
+				return spec.pad_size;
+			}
 
-								pad_size = num_and_len.val;
-
-								goto continue_specifier;
-							}
+			/**
+			 *  @brief  Returns the characters of a string argument, which are
+			 *  at most spec.precision characters if a precision is set.
+			 */
+			template <typename type>
+			static const char *format_str_chars(const FormatSpec& spec,
+				const type& str, size_t& len)
+			{
+				if constexpr (format_arg_kind<type>() == FormatArgKinds::STRING) {
+					len = str.size();
+					if (spec.precision_set) len = std::min(len, spec.precision);
+					return str.data();
+				} else {
+					len = spec.precision_set
+						? strnlen(str, spec.precision) : strlen(str);
+					return str;
+				}
+			}
 
-							case '-':
-							{
-								if (pad_char) {
-									err("Cannot set padding modifier twice (-)\n");
-								}
-
-								pad_char = ' ';
+			/**
+			 *  @brief  Returns the number of bytes an argument is written
+			 *  with. Exact, except for floats, which get an upper bound so
+			 *  they are only converted once, when they are written.
+			 */
+			template <typename type>
+			static size_t format_arg_size(const FormatSpec& spec, const type& arg)
+			{
+				constexpr FormatArgKinds kind = format_arg_kind<type>();
+
+				if constexpr (kind == FormatArgKinds::INTEGER) {
+					return std::max(format_int_len(spec.conversion, arg),
+						spec.pad_size);
+				} else if constexpr (kind == FormatArgKinds::FLOAT) {
+					return std::max(flow_tools::float_to_str_max_size(
+						(double) arg, spec.precision), spec.pad_size);
+				} else {
+					size_t len;
+					format_str_chars(spec, arg, len);
+					return std::max(len, spec.pad_size);
+				}
+			}
 
-								flow_tools::UintFromStr num_and_len =
-									flow_tools::read_uint_from_str(fmt + i + 1);
-								i += num_and_len.len;
+			/**
+			 *  @brief  Writes an argument to a buffer.
+			 *  Does not check if there is enough space left on the buffer.
+			 *  @returns  The number of bytes written.
+			 */
+			template <typename type>
+			static size_t write_format_arg(const FormatSpec& spec,
+				const type& arg, char *buf)
+			{
+				constexpr FormatArgKinds kind = format_arg_kind<type>();
 
-								pad_size = num_and_len.val;
-
-								goto continue_specifier;
-							}
-
-							case '.':
-							{
-								if (precision_modifier_set) {
-									err("Cannot set precision modifier twice (.)\n");
-								}
-
-								precision_modifier_set = true;
-
-								flow_tools::UintFromStr num_and_len =
-									flow_tools::read_uint_from_str(fmt + i + 1);
-								i += num_and_len.len;
-
-								precision = num_and_len.val;
-
-								goto continue_specifier;
-							}
-
-							case 'h':
-								if (length_modifier_set) {
-									err("Cannot set length modifier twice\n");
-								}
+				if constexpr (kind == FormatArgKinds::INTEGER) {
+					return write_format_int(spec, arg, buf);
+				} else if constexpr (kind == FormatArgKinds::FLOAT) {
+					return write_format_float(spec, arg, buf);
+				} else {
+					size_t len;
+					const char *chars = format_str_chars(spec, arg, len);
+					size_t offset = write_format_padding(spec, len, buf);
 
-								length_modifier_set = true;
+					memcpy(buf + offset, chars, len);
+					return offset + len;
+				}
+			}
 
-								if (fmt[i + 1] == 'h') {
-									i++;
-									length_modifier = SIZE_8;
-								} else {
-									length_modifier = SIZE_16;
-								}
+			template <typename... Args>
+			static size_t formatted_size(const FormatString<Args...>& fmt,
+				const Args&... args)
+			{
+				size_t size = fmt.literals_size;
+				size_t i = 0;
 
-								goto continue_specifier;
+				((size += format_arg_size(fmt.specs[i++], args)), ...);
+				return size;
+			}
 
-							case 'l':
-								if (length_modifier_set) {
-									err("Cannot set length modifier twice\n");
-								}
+			template <typename... Args>
+			static size_t write_formatted(char *buf,
+				const FormatString<Args...>& fmt, const Args&... args)
+			{
+				size_t offset = 0;
+				size_t i = 0;
 
-								length_modifier_set = true;
+				((
+					offset += fmt.write_literal(i, buf + offset),
+					offset += write_format_arg(fmt.specs[i++], args, buf + offset)
+				), ...);
 
-								if (fmt[i + 1] == 'l') {
-									i++;
-									length_modifier = SIZE_64;
-								} else {
-									length_modifier = SIZE_32;
-								}
+				offset += fmt.write_literal(i, buf + offset);
+				return offset;
+			}
 
-								goto continue_specifier;
+			/**
+			 *  @brief  Creates a String from an integer in base 10.
+			 */
+			template <typename intx_t>
+			static BasicString from_integer(intx_t num)
+			{
+				// At most 20 digits and a sign
 
-							default:
-								err("Unknown modifier %c passed to String::format()\n",
-									fmt[i]);
-						}
-					} else {
-						size++;
-					}
+				BasicString str(21);
 
-					end_specifier:
-					length_modifier = SIZE_32;
-					length_modifier_set = false;
-					pad_char = '\0';
-					pad_size = 0;
-					precision = 6;
-					precision_modifier_set = false;
-					i++;
+				if constexpr (std::is_signed_v<intx_t>) {
+					str.unsafe_increment_element_count(
+						flow_tools::write_int_to_str(num, str.data()));
+				} else {
+					str.unsafe_increment_element_count(
+						flow_tools::write_uint_to_str(num, str.data()));
 				}
 
-				String str(size);
-
-				va_end(args);
-				va_start(args, fmt);
-
-				i = 0;
-				char *buf = str.data();
-				size_t buf_offset = 0;
-
-				while (fmt[i] != '\0') {
-					if (fmt[i] == '%') {
-						continue_specifier_1:
-						i++;
-
-						switch (fmt[i]) {
-							case '%':
-								buf[buf_offset++] = '%';
-								goto end_specifier_1;
-
-							case 'd':
-							case 'i':
-								switch (length_modifier) {
-									case SIZE_8:
-									{
-										int8_t num = va_arg(args, int32_t);
-										buf_offset += flow_tools::write_int_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-
-										goto end_specifier_1;
-									}
-
-									case SIZE_16:
-									{
-										int16_t num = va_arg(args, int32_t);
-										buf_offset += flow_tools::write_int_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_32:
-									{
-										int32_t num = va_arg(args, int32_t);
-										buf_offset += flow_tools::write_int_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_64:
-									{
-										int64_t num = va_arg(args, int64_t);
-										buf_offset += flow_tools::write_int_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-								}
-
-							case 'u':
-								switch (length_modifier) {
-									case SIZE_8:
-									{
-										uint8_t num = va_arg(args, uint32_t);
-										buf_offset += flow_tools::write_uint_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_16:
-									{
-										uint16_t num = va_arg(args, uint32_t);
-										buf_offset += flow_tools::write_uint_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_32:
-									{
-										uint32_t num = va_arg(args, uint32_t);
-										buf_offset += flow_tools::write_uint_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_64:
-									{
-										uint64_t num = va_arg(args, uint64_t);
-										buf_offset += flow_tools::write_uint_to_str(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-								}
-
-							case 'o':
-								switch (length_modifier) {
-									case SIZE_8:
-									{
-										uint8_t num = va_arg(args, uint32_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'o';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<8>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_16:
-									{
-										uint16_t num = va_arg(args, uint32_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'o';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<8>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_32:
-									{
-										uint32_t num = va_arg(args, uint32_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'o';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<8>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_64:
-									{
-										uint64_t num = va_arg(args, uint64_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'o';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<8>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-								}
-
-							case 'x':
-							case 'X':
-								switch (length_modifier) {
-									case SIZE_8:
-									{
-										uint8_t num = va_arg(args, uint32_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'x';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<16>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_16:
-									{
-										uint16_t num = va_arg(args, uint32_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'x';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<16>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_32:
-									{
-										uint32_t num = va_arg(args, uint32_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'x';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<16>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-
-									case SIZE_64:
-									{
-										uint64_t num = va_arg(args, uint64_t);
-										buf[buf_offset] = '0';
-										buf[buf_offset + 1] = 'x';
-										buf_offset += 2;
-										buf_offset += flow_tools::write_uint_to_str<16>(
-											num, buf + buf_offset, pad_char, pad_size);
-										goto end_specifier_1;
-									}
-								}
-
-							case 'f':
-								switch (length_modifier) {
-									case SIZE_32:
-									case SIZE_64:
-									{
-										double num = va_arg(args, double);
-										buf_offset += flow_tools::write_float_to_str(
-											num, buf + buf_offset, precision);
-										goto end_specifier_1;
-									}
-								}
-
-							case 'c':
-							{
-								char c = va_arg(args, int);
-								buf[buf_offset++] = c;
-
-								goto end_specifier_1;
-							}
-
-							case 's':
-							{
-								const char *str = va_arg(args, const char *);
-								size_t str_size = strlen(str);
-
-								if (precision_modifier_set)
-									str_size = std::min(str_size, precision);
-
-								ssize_t padding = pad_size - str_size;
-								padding = std::max(padding, (ssize_t) 0);
-
-								memset(buf + buf_offset, pad_char, padding);
-								buf_offset += padding;
-
-								memcpy(buf + buf_offset, str, str_size);
-								buf_offset += str_size;
-
-								goto end_specifier_1;
-							}
-
-							case 'S':
-							{
-								String& str_arg = va_arg(args, String);
-								size_t str_size = str_arg.size();
-
-								if (precision_modifier_set)
-									str_size = std::min(str_size, precision);
-
-								ssize_t padding = pad_size - str_size;
-								padding = std::max(padding, (ssize_t) 0);
-
-								memset(buf + buf_offset, pad_char, padding);
-								buf_offset += padding;
-
-								memcpy(buf + buf_offset, str_arg.data(), str_size);
-								buf_offset += str_size;
-
-								goto end_specifier_1;
-							}
-
-							case '0':
-							{
-								pad_char = '0';
-
-								flow_tools::UintFromStr num_and_len =
-									flow_tools::read_uint_from_str(fmt + i + 1);
-								i += num_and_len.len;
-
-								pad_size = num_and_len.val;
-
-								goto continue_specifier_1;
-							}
-
-							case '-':
-							{
-								pad_char = ' ';
-
-								flow_tools::UintFromStr num_and_len =
-									flow_tools::read_uint_from_str(fmt + i + 1);
-								i += num_and_len.len;
-
-								pad_size = num_and_len.val;
-
-								goto continue_specifier_1;
-							}
-
-							case '.':
-							{
-								precision_modifier_set = true;
-
-								flow_tools::UintFromStr num_and_len =
-									flow_tools::read_uint_from_str(fmt + i + 1);
-								i += num_and_len.len;
-
-								precision = num_and_len.val;
+				return str;
+			}
 
-								goto continue_specifier_1;
-							}
+			/**
+			 *  @brief  Creates a String from a floating point number, with the
+			 *  least number of digits that read back to the exact same number.
+			 *  See flow_tools::write_shortest_float_to_str() for the notation.
+			 */
+			template <typename float_t>
+			static BasicString from_shortest_float(float_t num)
+			{
+				BasicString str(flow_tools::SHORTEST_FLOAT_MAX_SIZE);
 
-							case 'h':
-								if (fmt[i + 1] == 'h') {
-									i++;
-									length_modifier = SIZE_8;
-								} else {
-									length_modifier = SIZE_16;
-								}
+				str.unsafe_increment_element_count(
+					flow_tools::write_shortest_float_to_str(num, str.data()));
+				return str;
+			}
 
-								goto continue_specifier_1;
+		public:
+			/**
+			 *  @brief  Computes the number of bytes String::format() writes
+			 *  for a format string and arguments. Exact, unless there are
+			 *  float arguments, then it may exceed it by a few bytes.
+			 *  @param  fmt  The format string, see FormatString.
+			 *  @param  args  The arguments.
+			 *  @note  Runtime: O(n), n = the size of the output
+			 *  @note  Memory: O(1)
+			 */
+			template <typename... Args>
+			static size_t format_size(
+				FormatString<std::type_identity_t<Args>...> fmt,
+				const Args&... args)
+			{
+				return formatted_size(fmt, args...);
+			}
 
-							case 'l':
-								if (fmt[i + 1] == 'l') {
-									i++;
-									length_modifier = SIZE_64;
-								} else {
-									length_modifier = SIZE_32;
-								}
+			/**
+			 *  @brief  Writes a formatted string to a buffer.
+			 *  Does not check if there is enough space left on the buffer,
+			 *  use String::format_size() to get the number of bytes needed.
+			 *  The terminating null byte is not written.
+			 *  @param  buf  The character buffer to write to.
+			 *  @param  fmt  The format string, see FormatString.
+			 *  @param  args  The arguments.
+			 *  @returns  The number of bytes written.
+			 *  @note  Runtime: O(n), n = the size of the output
+			 *  @note  Memory: O(1)
+			 */
+			template <typename... Args>
+			static size_t format_to(char *buf,
+				FormatString<std::type_identity_t<Args>...> fmt,
+				const Args&... args)
+			{
+				return write_formatted(buf, fmt, args...);
+			}
 
-								goto continue_specifier_1;
-						}
-					} else {
-						buf[buf_offset++] = fmt[i];
-					}
+			/**
+			 *  @brief  Formats a String. The format string is parsed and checked
+			 *  against the argument types at compile time, see FormatString.
+			 *  Arguments can be integers, floats, C strings and Strings.
+			 *  @param  fmt  The format string, see FormatString.
+			 *  @param  args  The arguments.
+			 *  @note  Runtime: O(n), n = the size of the output
+			 *  @note  Memory: O(n), n = the size of the output
+			 */
+			template <typename... Args>
+			static BasicString format(FormatString<std::type_identity_t<Args>...> fmt,
+				const Args&... args)
+			{
+				size_t size = formatted_size(fmt, args...);
+				BasicString str(size);
 
-					end_specifier_1:
-					length_modifier = SIZE_32;
-					pad_char = '\0';
-					pad_size = 0;
-					precision = 6;
-					i++;
-				}
+				str.unsafe_increment_element_count(
+					write_formatted(str.data(), fmt, args...));
+				return str;
+			}
 
-				va_end(args);
+			/**
+			 *  @brief  Formats a string and attaches it to the end of this String.
+			 *  The String will automatically grow to a power of 2 if needed.
+			 *  @param  fmt  The format string, see FormatString.
+			 *  @param  args  The arguments.
+			 *  @note  Runtime: O(n), n = size() + the size of the output
+			 *  @note  Memory: O(1)
+			 */
+			template <typename... Args>
+			void attach_formatted(FormatString<std::type_identity_t<Args>...> fmt,
+				const Args&... args)
+			{
+				reserve(formatted_size(fmt, args...));
 
-				str.unsafe_increment_element_count(buf_offset);
-				return str;
+				unsafe_increment_element_count(
+					write_formatted(data() + size(), fmt, args...));
 			}
 
 			/**
-			 *  @brief  Prints this String to a stream, followed by a newline.
+			 *  @brief  Prints this String to a stream with a single fwrite(),
+			 *  followed by a newline.
 			 *  @param  stream  The stream to print to. Defaults to stdout.
+			 *  @param  newline  Whether to print the newline.
 			 *  @note  Runtime: O(n), n = size()
 			 *  @note  Memory: O(1)
 			 */
-			void print(FILE *stream = stdout)
+			void print(FILE *stream = stdout, bool newline = true)
 			{
-				for (size_t i = 0; i < size(); i++) {
-					putc(get_at_index(i), stream);
+				if (size() != 0) fwrite(data(), 1, size(), stream);
+				if (newline) putc('\n', stream);
+			}
+
+			static BasicString from_num(uint8_t  num) { return from_integer(num); }
+			static BasicString from_num(int8_t   num) { return from_integer(num); }
+			static BasicString from_num(uint16_t num) { return from_integer(num); }
+			static BasicString from_num(int16_t  num) { return from_integer(num); }
+			static BasicString from_num(uint32_t num) { return from_integer(num); }
+			static BasicString from_num(int32_t  num) { return from_integer(num); }
+			static BasicString from_num(uint64_t num) { return from_integer(num); }
+			static BasicString from_num(int64_t  num) { return from_integer(num); }
+			static BasicString from_num(float    num) { return from_shortest_float(num); }
+			static BasicString from_num(double   num) { return from_shortest_float(num); }
+
+			/**
+			 *  @brief  Parses this String as an integer in base 10.
+			 *  The whole String must be the number, optionally preceded
+			 *  by a '+' sign, or a '-' sign for signed types.
+			 *  Throws a StringErrors::INVALID_NUMBER if this String is not a
+			 *  number, or a StringErrors::NUMBER_OUT_OF_RANGE if the number does
+			 *  not fit in the requested type.
+			 *  @tparam  intx_t  The integer type to parse as.
+			 *  @returns  The parsed number.
+			 *  @note  Runtime: O(n), n = size()
+			 *  @note  Memory: O(1)
+			 */
+			template <typename intx_t>
+			intx_t to_num() const
+			{
+				static_assert(std::is_integral_v<intx_t> && sizeof(intx_t) <= 8,
+					"String::to_num() only supports integers up to 64 bits");
+
+				const char *str = data();
+				size_t len = size();
+				bool negative = false;
+				size_t offset = 0;
+
+				if (len != 0 && (str[0] == '+'
+					|| (std::is_signed_v<intx_t> && str[0] == '-'))) {
+					negative = str[0] == '-';
+					offset = 1;
 				}
 
-				putc('\n', stream);
-			}
+				flow_tools::UintFromStr num = flow_tools::read_uint_from_str(
+					str + offset, len - offset);
+
+				if (num.len == 0 || offset + num.len != len) {
+					throw StringErrors::INVALID_NUMBER;
+				}
 
-			static String from_num(uint8_t  num) { return String::format("%hhu",  num); }
-			static String from_num(int8_t   num) { return String::format("%hhd",  num); }
-			static String from_num(uint16_t num) { return String::format("%hu",   num); }
-			static String from_num(int16_t  num) { return String::format("%hd",   num); }
-			static String from_num(uint32_t num) { return String::format("%lu",   num); }
-			static String from_num(int32_t  num) { return String::format("%ld",   num); }
-			static String from_num(uint64_t num) { return String::format("%llu",  num); }
-			static String from_num(int64_t  num) { return String::format("%lld",  num); }
-			static String from_num(float    num) { return String::format("%.6f",  num); }
-			static String from_num(double   num) { return String::format("%.15f", num); }
+				uint64_t max = std::numeric_limits<intx_t>::max();
+				if (negative) max++;
+
+				if (num.overflow || num.val > max) {
+					throw StringErrors::NUMBER_OUT_OF_RANGE;
+				}
+
+				return negative ? (intx_t) (0 - num.val) : (intx_t) num.val;
+			}
 
 			/**
 			 *  @brief  Allocates a String with a buffer of a certain size.
@@ -2198,21 +1886,23 @@ namespace flow {
 			 *  Watch out for undefined behaviour.
 			 *  @param  size  The size of the String buffer.
 			 */
-			static String alloc(size_t size)
+			static BasicString alloc(size_t size)
 			{
-				String str(size);
+				BasicString str(size);
 				str.unsafe_increment_element_count(size);
 				return str;
 			}
 	};
+
+	using String = BasicString<>;
 };
 
 /**
  *  @brief  Calculates the hash of a String, used for hash maps etc.
  */
-template <>
-struct std::hash<flow::String> {
-	size_t operator()(const flow::String& str) const
+template <typename Allocator>
+struct std::hash<flow::BasicString<Allocator>> {
+	size_t operator()(const flow::BasicString<Allocator>& str) const
 	{
 		#if SIZE_MAX == 0xFFFFFFFF
 		size_t hash = 443569081;
@@ -0,0 +1,682 @@
+#ifndef FLOW_LOGGER_HEADER
+#define FLOW_LOGGER_HEADER
+
+#include <bits/stdc++.h>
+#include <time.h>
+
+#include "../data-structures/dynamic-array.hpp"
+#include "../data-structures/format-string.hpp"
+#include "../data-structures/string.hpp"
+#include "../fs/group-commit-writer.hpp"
+#include "../memory/arena.hpp"
+
+// Log statements below this level are removed at compile time:
+// 0 = TRACE, 1 = DEBUG, 2 = INFO, 3 = WARN, 4 = ERROR
+
+#ifndef FLOW_LOG_LEVEL
+#define FLOW_LOG_LEVEL (size_t) 2
+#endif
+
+// Size of the buffer of log records of each thread, must be a power of 2
+
+#ifndef FLOW_LOG_BUFFER_SIZE
+#define FLOW_LOG_BUFFER_SIZE (size_t) 262144
+#endif
+
+// Maximum time a log record waits before it is formatted
+
+#ifndef FLOW_LOG_FLUSH_INTERVAL_MS
+#define FLOW_LOG_FLUSH_INTERVAL_MS (size_t) 5
+#endif
+
+namespace flow {
+	enum class LogLevel {
+		TRACE,
+		DEBUG,
+		INFO,
+		WARN,
+		ERROR,
+		OFF
+	};
+
+	class Logger;
+};
+
+namespace flow_logger_tools {
+	/**
+	 *  @brief  The type an argument of a log statement is stored as.
+	 *  Strings are copied into the log record and read back as C strings,
+	 *  other arguments are stored by value.
+	 */
+	template <typename type>
+	struct log_arg {
+		using decayed = std::decay_t<type>;
+
+		using type_t = std::conditional_t<
+			flow::format_arg_kind<type>() == flow::FormatArgKinds::STRING
+				|| flow::format_arg_kind<type>() == flow::FormatArgKinds::C_STRING,
+			const char *, decayed>;
+	};
+
+	template <typename type>
+	using log_arg_t = typename log_arg<type>::type_t;
+
+	inline const char *log_level_name(enum flow::LogLevel level)
+	{
+		switch (level) {
+			case flow::LogLevel::TRACE: return "TRACE";
+			case flow::LogLevel::DEBUG: return "DEBUG";
+			case flow::LogLevel::INFO: return "INFO ";
+			case flow::LogLevel::WARN: return "WARN ";
+			case flow::LogLevel::ERROR: return "ERROR";
+			default: return "?    ";
+		}
+	}
+
+	/**
+	 *  @brief  Returns the number of bytes an argument is stored with.
+	 */
+	template <typename type>
+	size_t encoded_size(const type& arg)
+	{
+		constexpr flow::FormatArgKinds kind = flow::format_arg_kind<type>();
+
+		if constexpr (kind == flow::FormatArgKinds::STRING) {
+			return arg.size() + 1;
+		} else if constexpr (kind == flow::FormatArgKinds::C_STRING) {
+			return strlen(arg) + 1;
+		} else {
+			return sizeof(log_arg_t<type>);
+		}
+	}
+
+	/**
+	 *  @brief  Stores an argument at a cursor and advances it.
+	 *  Strings are stored with a terminating null byte.
+	 */
+	template <typename type>
+	void encode(char *& cursor, const type& arg)
+	{
+		constexpr flow::FormatArgKinds kind = flow::format_arg_kind<type>();
+
+		if constexpr (kind == flow::FormatArgKinds::STRING) {
+			if (arg.size() != 0) memcpy(cursor, arg.data(), arg.size());
+			cursor[arg.size()] = '\0';
+			cursor += arg.size() + 1;
+		} else if constexpr (kind == flow::FormatArgKinds::C_STRING) {
+			size_t len = strlen(arg);
+			memcpy(cursor, arg, len + 1);
+			cursor += len + 1;
+		} else {
+			log_arg_t<type> value = arg;
+			memcpy(cursor, &value, sizeof(value));
+			cursor += sizeof(value);
+		}
+	}
+
+	/**
+	 *  @brief  Reads back an argument stored by encode() and advances the
+	 *  cursor. Strings point into the log record.
+	 */
+	template <typename stored_t>
+	stored_t decode(const char *& cursor)
+	{
+		if constexpr (std::is_same_v<stored_t, const char *>) {
+			const char *str = cursor;
+			cursor += strlen(str) + 1;
+			return str;
+		} else {
+			stored_t value;
+			memcpy(&value, cursor, sizeof(value));
+			cursor += sizeof(value);
+			return value;
+		}
+	}
+
+	typedef void (*format_record_t)(const char *payload, flow::String& line);
+
+	/**
+	 *  @brief  Formats the payload of a log record, the format string
+	 *  followed by the stored arguments, and attaches it to a line.
+	 */
+	template <typename... Stored>
+	void format_record(const char *payload, flow::String& line)
+	{
+		const char *fmt_chars;
+		memcpy(&fmt_chars, payload, sizeof(const char *));
+
+		flow::FormatString<Stored...> fmt = flow::FormatString<Stored...>::reparse(fmt_chars);
+		const char *cursor = payload + sizeof(const char *);
+
+		// Braced initialisers are evaluated in order
+
+		std::tuple<Stored...> args { decode<Stored>(cursor)... };
+
+		std::apply([&line, &fmt](const Stored&... stored) {
+			line.attach_formatted(fmt, stored...);
+		}, args);
+	}
+
+	/**
+	 *  @brief  Formats a statement and writes it to stderr right away, for
+	 *  statements made while no Logger is installed. The arguments go
+	 *  through the same encoding as a log record, so they are formatted
+	 *  the same way.
+	 */
+	template <typename... Args>
+	void log_to_stderr(enum flow::LogLevel level,
+		flow::FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		size_t size = sizeof(const char *);
+		((size += encoded_size(args)), ...);
+
+		flow::String payload(size);
+		char *cursor = payload.data();
+		memcpy(cursor, &fmt.fmt, sizeof(const char *));
+		cursor += sizeof(const char *);
+
+		(encode(cursor, args), ...);
+
+		flow::String line;
+		line.attach_formatted("%s ", log_level_name(level));
+		format_record<log_arg_t<Args>...>(payload.data(), line);
+		line += '\n';
+
+		fwrite(line.data(), 1, line.size(), stderr);
+	}
+
+	/**
+	 *  @brief  The start of a log record. Records are aligned to 8 bytes,
+	 *  a record without a format function pads the end of the ring.
+	 */
+	struct LogRecordHeader {
+		// Size of the record, including this header
+
+		size_t size;
+		format_record_t format;
+		int64_t timestamp_ns;
+		enum flow::LogLevel level;
+	};
+
+	constexpr size_t LOG_RECORD_ALIGNMENT = 8;
+
+	/**
+	 *  @brief  A lock-free ring of log records, written by one thread and
+	 *  read by the formatter thread of a Logger. When the ring is full,
+	 *  records are dropped and counted rather than waiting for the
+	 *  formatter.
+	 */
+	class LogBuffer {
+		private:
+			char *ring;
+
+			// The producer's last view of head, saves loading it per record
+
+			size_t cached_head = 0;
+			size_t reserved_tail = 0;
+
+			alignas(64) std::atomic<size_t> head = 0;
+			alignas(64) std::atomic<size_t> tail = 0;
+
+			/**
+			 *  @brief  Returns the number of bytes from an offset to the end
+			 *  of the ring. Less than a header at the end is skipped by both
+			 *  sides, more is filled with a padding record.
+			 */
+			static size_t contiguous(size_t position)
+			{
+				return FLOW_LOG_BUFFER_SIZE - (position & (FLOW_LOG_BUFFER_SIZE - 1));
+			}
+
+		public:
+			std::thread::id owner;
+			std::atomic<size_t> dropped = 0;
+
+			LogBuffer() : ring(new char[FLOW_LOG_BUFFER_SIZE]),
+				owner(std::this_thread::get_id()) {}
+
+			LogBuffer(const LogBuffer& other) = delete;
+			LogBuffer& operator=(const LogBuffer& other) = delete;
+
+			~LogBuffer()
+			{
+				delete[] ring;
+			}
+
+			/**
+			 *  @brief  Reserves space for a record, which is published by
+			 *  commit(). Called by the owner thread only.
+			 *  @returns  The space, or NULL if the ring is full.
+			 */
+			char *reserve(size_t size)
+			{
+				size_t position = tail.load(std::memory_order_relaxed);
+				size_t until_end = contiguous(position);
+				size_t skipped = until_end < size ? until_end : 0;
+
+				if (position + skipped + size - cached_head > FLOW_LOG_BUFFER_SIZE) {
+					cached_head = head.load(std::memory_order_acquire);
+
+					if (position + skipped + size - cached_head > FLOW_LOG_BUFFER_SIZE) {
+						dropped.fetch_add(1, std::memory_order_relaxed);
+						return NULL;
+					}
+				}
+
+				if (skipped >= sizeof(LogRecordHeader)) {
+					LogRecordHeader *padding = (LogRecordHeader *)
+						(ring + (position & (FLOW_LOG_BUFFER_SIZE - 1)));
+
+					padding->size = skipped;
+					padding->format = NULL;
+				}
+
+				position += skipped;
+				reserved_tail = position + size;
+
+				return ring + (position & (FLOW_LOG_BUFFER_SIZE - 1));
+			}
+
+			/**
+			 *  @brief  Publishes the record of the last reserve().
+			 */
+			void commit()
+			{
+				tail.store(reserved_tail, std::memory_order_release);
+			}
+
+			/**
+			 *  @brief  Passes all published records to a function, then
+			 *  frees their space. Called by the formatter thread only.
+			 */
+			template <typename F>
+			void drain(F&& fn)
+			{
+				size_t position = head.load(std::memory_order_relaxed);
+				size_t end = tail.load(std::memory_order_acquire);
+
+				while (position != end) {
+					if (contiguous(position) < sizeof(LogRecordHeader)) {
+						position += contiguous(position);
+						continue;
+					}
+
+					const LogRecordHeader *record = (const LogRecordHeader *)
+						(ring + (position & (FLOW_LOG_BUFFER_SIZE - 1)));
+
+					if (record->format != NULL) fn(*record);
+					position += record->size;
+				}
+
+				head.store(position, std::memory_order_release);
+			}
+	};
+
+	/**
+	 *  @brief  The LogBuffer of the calling thread for the Logger it was
+	 *  last used with.
+	 */
+	struct ThreadLogBuffer {
+		uint64_t logger_id = 0;
+		LogBuffer *buffer = NULL;
+	};
+
+	inline thread_local ThreadLogBuffer thread_log_buffer;
+
+	inline std::atomic<uint64_t> next_logger_id = 1;
+
+	// The Logger used by log_info() and friends
+
+	inline std::atomic<flow::Logger *> installed_logger = NULL;
+};
+
+namespace flow {
+	using namespace flow_logger_tools;
+
+	/**
+	 *  @brief  Returns whether a level is compiled in, see FLOW_LOG_LEVEL.
+	 */
+	constexpr bool log_level_compiled_in(enum LogLevel level)
+	{
+		return (size_t) level >= FLOW_LOG_LEVEL && level != LogLevel::OFF;
+	}
+
+	/**
+	 *  @brief  An asynchronous logger. A log statement only copies its
+	 *  format string and arguments, in binary, into a lock-free buffer of
+	 *  the calling thread. A background thread formats the records and
+	 *  appends them, one line each, through a GroupCommitWriter.
+	 *  Statements below FLOW_LOG_LEVEL are compiled out, those below the
+	 *  runtime level cost one load. When a buffer is full, records are
+	 *  dropped and a line with the number of dropped records is logged.
+	 *  Lines of different threads may appear out of order, each line
+	 *  starts with the time it was logged at.
+	 */
+	class Logger {
+		private:
+			GroupCommitWriter& writer;
+			std::atomic<LogLevel> level;
+			uint64_t id;
+
+			std::mutex buffers_mutex;
+			DynamicArray<LogBuffer *> buffers;
+			size_t reported_dropped = 0;
+
+			std::mutex wake_mutex;
+			std::condition_variable wake_formatter;
+			bool stopping = false;
+
+			std::thread formatter;
+
+			/**
+			 *  @brief  Returns the LogBuffer of the calling thread,
+			 *  creating it on the first log statement of the thread.
+			 */
+			LogBuffer& thread_buffer()
+			{
+				if (thread_log_buffer.logger_id == id) return *thread_log_buffer.buffer;
+
+				ArenaScope heap_scope(NULL);
+				std::lock_guard<std::mutex> lock(buffers_mutex);
+
+				LogBuffer *buffer = NULL;
+
+				for (size_t i = 0; i < buffers.size(); i++) {
+					if (buffers[i]->owner == std::this_thread::get_id()) buffer = buffers[i];
+				}
+
+				if (buffer == NULL) {
+					buffer = new LogBuffer();
+					buffers.append(buffer);
+				}
+
+				thread_log_buffer = ThreadLogBuffer { id, buffer };
+				return *buffer;
+			}
+
+			static void attach_timestamp(String& line, int64_t timestamp_ns)
+			{
+				time_t seconds = timestamp_ns / 1000000000;
+				struct tm time;
+				gmtime_r(&seconds, &time);
+
+				line.attach_formatted("%04d-%02d-%02dT%02d:%02d:%02d.%06dZ ",
+					time.tm_year + 1900, time.tm_mon + 1, time.tm_mday,
+					time.tm_hour, time.tm_min, time.tm_sec,
+					(int) (timestamp_ns % 1000000000 / 1000));
+			}
+
+			/**
+			 *  @brief  Formats all published records into one batch and
+			 *  writes it.
+			 *  @returns  The number of records formatted.
+			 */
+			size_t format_records()
+			{
+				String batch;
+				size_t dropped = 0;
+				size_t count = 0;
+
+				std::lock_guard<std::mutex> lock(buffers_mutex);
+
+				for (size_t i = 0; i < buffers.size(); i++) {
+					buffers[i]->drain([&batch, &count](const LogRecordHeader& record) {
+						attach_timestamp(batch, record.timestamp_ns);
+						batch.attach_formatted("%s ", log_level_name(record.level));
+						record.format((const char *) &record + sizeof(LogRecordHeader), batch);
+						batch += '\n';
+						count++;
+					});
+
+					dropped += buffers[i]->dropped.load(std::memory_order_relaxed);
+				}
+
+				if (dropped != reported_dropped) {
+					batch.attach_formatted("%zu log records dropped\n", dropped - reported_dropped);
+					reported_dropped = dropped;
+				}
+
+				writer.write(batch);
+				return count;
+			}
+
+			void format_loop()
+			{
+				ArenaScope heap_scope(NULL);
+				bool idle = true;
+
+				while (true) {
+					bool stop;
+
+					// Keep up with bursts, only wait when there was nothing to do
+
+					{
+						std::unique_lock<std::mutex> lock(wake_mutex);
+
+						if (idle) {
+							wake_formatter.wait_for(lock,
+								std::chrono::milliseconds(FLOW_LOG_FLUSH_INTERVAL_MS),
+								[this]() { return stopping; });
+						}
+
+						stop = stopping;
+					}
+
+					idle = format_records() == 0;
+					if (stop) return;
+				}
+			}
+
+		public:
+			/**
+			 *  @brief  Creates a Logger and starts its formatter thread.
+			 *  @param  writer  The writer lines are appended through, must
+			 *  outlive the Logger.
+			 *  @param  level  The lowest level that is logged.
+			 */
+			Logger(GroupCommitWriter& writer, enum LogLevel level = LogLevel::INFO)
+				: writer(writer), level(level), id(next_logger_id++),
+				buffers(on_heap<DynamicArray<LogBuffer *>>())
+			{
+				formatter = std::thread([this]() { format_loop(); });
+			}
+
+			Logger(const Logger& other) = delete;
+			Logger& operator=(const Logger& other) = delete;
+
+			/**
+			 *  @brief  Formats and writes the remaining records. No thread
+			 *  may log to the Logger anymore.
+			 */
+			~Logger()
+			{
+				Logger *self = this;
+				installed_logger.compare_exchange_strong(self, NULL);
+
+				{
+					std::lock_guard<std::mutex> lock(wake_mutex);
+					stopping = true;
+				}
+
+				wake_formatter.notify_one();
+				formatter.join();
+
+				for (size_t i = 0; i < buffers.size(); i++) delete buffers[i];
+			}
+
+			/**
+			 *  @brief  Makes this Logger the one log_info() and friends log to.
+			 */
+			void install()
+			{
+				installed_logger.store(this, std::memory_order_release);
+			}
+
+			/**
+			 *  @brief  Sets the lowest level that is logged. Levels below
+			 *  FLOW_LOG_LEVEL are never logged.
+			 */
+			void set_level(enum LogLevel new_level)
+			{
+				level.store(new_level, std::memory_order_relaxed);
+			}
+
+			/**
+			 *  @brief  Returns whether statements of a level are logged.
+			 */
+			bool enabled(enum LogLevel statement_level) const
+			{
+				return log_level_compiled_in(statement_level)
+					&& statement_level >= level.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 *  @brief  Logs a statement. The format string is checked against
+			 *  the arguments at compile time, see FormatString. Strings are
+			 *  copied, other arguments are stored as they are, all of them
+			 *  are formatted later on the formatter thread.
+			 *  @tparam  statement_level  The level of the statement.
+			 *  @param  fmt  The format string.
+			 *  @param  args  The arguments.
+			 *  @note  Runtime: O(1), plus O(n) for string arguments,
+			 *  n = their total size
+			 *  @note  Memory: O(1), in the buffer of the calling thread
+			 */
+			template <enum LogLevel statement_level, typename... Args>
+			void log(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+			{
+				if constexpr (log_level_compiled_in(statement_level)) {
+					if (statement_level < level.load(std::memory_order_relaxed)) return;
+
+					// The format string is stored as a pointer to the literal,
+					// and parsed again by the formatter
+
+					size_t size = sizeof(LogRecordHeader) + sizeof(const char *);
+					((size += encoded_size(args)), ...);
+					size = (size + LOG_RECORD_ALIGNMENT - 1) & ~(LOG_RECORD_ALIGNMENT - 1);
+
+					// Records that do not fit in half a buffer are dropped
+
+					LogBuffer& buffer = thread_buffer();
+
+					if (size > FLOW_LOG_BUFFER_SIZE / 2) {
+						buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+						return;
+					}
+
+					char *space = buffer.reserve(size);
+					if (space == NULL) return;
+
+					int64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::system_clock::now().time_since_epoch()).count();
+
+					new (space) LogRecordHeader {
+						size, &format_record<log_arg_t<Args>...>, timestamp_ns, statement_level
+					};
+
+					char *cursor = space + sizeof(LogRecordHeader);
+					memcpy(cursor, &fmt.fmt, sizeof(const char *));
+					cursor += sizeof(const char *);
+
+					(encode(cursor, args), ...);
+
+					buffer.commit();
+				}
+			}
+
+			template <typename... Args>
+			void trace(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+			{
+				log<LogLevel::TRACE>(fmt, args...);
+			}
+
+			template <typename... Args>
+			void debug(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+			{
+				log<LogLevel::DEBUG>(fmt, args...);
+			}
+
+			template <typename... Args>
+			void info(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+			{
+				log<LogLevel::INFO>(fmt, args...);
+			}
+
+			template <typename... Args>
+			void warn(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+			{
+				log<LogLevel::WARN>(fmt, args...);
+			}
+
+			template <typename... Args>
+			void error(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+			{
+				log<LogLevel::ERROR>(fmt, args...);
+			}
+
+			/**
+			 *  @brief  Returns the number of records dropped because a
+			 *  buffer was full.
+			 */
+			size_t dropped()
+			{
+				std::lock_guard<std::mutex> lock(buffers_mutex);
+				size_t count = 0;
+
+				for (size_t i = 0; i < buffers.size(); i++) {
+					count += buffers[i]->dropped.load(std::memory_order_relaxed);
+				}
+
+				return count;
+			}
+	};
+
+	/**
+	 *  @brief  Logs a statement to the installed Logger. Without one, the
+	 *  statement is written to stderr synchronously, so diagnostics of
+	 *  programs that never install a Logger are not lost.
+	 *  Compiled out if the level is below FLOW_LOG_LEVEL.
+	 */
+	template <enum LogLevel statement_level, typename... Args>
+	void log(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		if constexpr (log_level_compiled_in(statement_level)) {
+			Logger *logger = installed_logger.load(std::memory_order_acquire);
+
+			if (logger != NULL) logger->log<statement_level>(fmt, args...);
+			else log_to_stderr(statement_level, fmt, args...);
+		}
+	}
+
+	template <typename... Args>
+	void log_trace(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		log<LogLevel::TRACE>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void log_debug(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		log<LogLevel::DEBUG>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void log_info(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		log<LogLevel::INFO>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void log_warn(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		log<LogLevel::WARN>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void log_error(FormatString<log_arg_t<Args>...> fmt, const Args&... args)
+	{
+		log<LogLevel::ERROR>(fmt, args...);
+	}
+};
+
+#endif
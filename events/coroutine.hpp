@@ -0,0 +1,234 @@
+#ifndef FLOW_COROUTINE_HEADER
+#define FLOW_COROUTINE_HEADER
+
+#include <bits/stdc++.h>
+#include <coroutine>
+
+#include "../memory/arena.hpp"
+#include "../memory/block-pool.hpp"
+
+// Coroutine frames up to this size are pooled, bigger ones use the heap
+
+#ifndef FLOW_COROUTINE_FRAME_POOL_MAX_SIZE
+#define FLOW_COROUTINE_FRAME_POOL_MAX_SIZE (size_t) 4096
+#endif
+
+namespace flow_coroutine_tools {
+	// Every loop runs on its own thread, so this is a frame pool per loop
+
+	inline thread_local flow::BlockPool<FLOW_COROUTINE_FRAME_POOL_MAX_SIZE> frame_pool;
+
+	// The exception of a spawned Coroutine whose frame was already freed,
+	// thrown out of whatever resumed it once the resumption returns
+
+	inline thread_local std::exception_ptr detached_exception;
+
+	inline void rethrow_detached_exception()
+	{
+		if (!detached_exception) return;
+
+		std::exception_ptr exception = detached_exception;
+		detached_exception = NULL;
+		std::rethrow_exception(exception);
+	}
+};
+
+namespace flow {
+	using namespace flow_coroutine_tools;
+
+	/**
+	 *  @brief  A coroutine that returns nothing. It is lazy: it starts
+	 *  running when it is awaited by another coroutine, which is resumed
+	 *  when it finishes, or when it is passed to spawn().
+	 *  Frames come from the frame pool of the thread.
+	 */
+	class Coroutine {
+		public:
+			struct promise_type;
+
+		private:
+			std::coroutine_handle<promise_type> handle;
+
+			/**
+			 *  @brief  Resumes the awaiting coroutine when the Coroutine
+			 *  finishes, or destroys the frame of a spawned Coroutine.
+			 */
+			struct FinalAwaiter {
+				bool await_ready() noexcept
+				{
+					return false;
+				}
+
+				std::coroutine_handle<> await_suspend(
+					std::coroutine_handle<promise_type> finished
+				) noexcept {
+					promise_type& promise = finished.promise();
+
+					if (promise.detached) {
+						if (promise.exception && !detached_exception) {
+							detached_exception = promise.exception;
+						}
+
+						finished.destroy();
+						return std::noop_coroutine();
+					}
+
+					if (promise.continuation) return promise.continuation;
+					return std::noop_coroutine();
+				}
+
+				void await_resume() noexcept {}
+			};
+
+			struct Awaiter {
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready()
+				{
+					return false;
+				}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				void await_resume()
+				{
+					if (handle.promise().exception) {
+						std::rethrow_exception(handle.promise().exception);
+					}
+				}
+			};
+
+			friend void spawn(Coroutine&& coroutine);
+
+		public:
+			struct promise_type {
+				std::coroutine_handle<> continuation;
+				std::exception_ptr exception;
+
+				// Set by spawn(), nothing owns the frame then
+
+				bool detached = false;
+
+				static void *operator new(size_t size)
+				{
+					return frame_pool.allocate(size);
+				}
+
+				static void operator delete(void *ptr, size_t size)
+				{
+					frame_pool.deallocate(ptr, size);
+				}
+
+				Coroutine get_return_object()
+				{
+					return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+				}
+
+				std::suspend_always initial_suspend() noexcept
+				{
+					return {};
+				}
+
+				FinalAwaiter final_suspend() noexcept
+				{
+					return {};
+				}
+
+				void return_void() {}
+
+				/**
+				 *  @brief  Keeps the exception for the awaiting coroutine.
+				 *  Nothing awaits a spawned Coroutine, so its frame is freed
+				 *  and its exception is thrown out of whatever resumed it,
+				 *  usually the loop.
+				 */
+				void unhandled_exception()
+				{
+					exception = std::current_exception();
+				}
+			};
+
+			Coroutine(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+			Coroutine(const Coroutine& other) = delete;
+			Coroutine& operator=(const Coroutine& other) = delete;
+
+			Coroutine(Coroutine&& other) : handle(other.handle)
+			{
+				other.handle = NULL;
+			}
+
+			Coroutine& operator=(Coroutine&& other)
+			{
+				if (this == &other) return *this;
+
+				if (handle) handle.destroy();
+				handle = other.handle;
+				other.handle = NULL;
+
+				return *this;
+			}
+
+			~Coroutine()
+			{
+				if (handle) handle.destroy();
+			}
+
+			/**
+			 *  @brief  Runs the Coroutine and resumes the awaiting coroutine
+			 *  once it finished. Rethrows an exception of the Coroutine.
+			 */
+			Awaiter operator co_await() &&
+			{
+				return Awaiter { handle };
+			}
+	};
+
+	/**
+	 *  @brief  Starts a Coroutine without waiting for it. The frame is
+	 *  freed when the Coroutine finishes.
+	 */
+	inline void spawn(Coroutine&& coroutine)
+	{
+		std::coroutine_handle<Coroutine::promise_type> handle = coroutine.handle;
+		coroutine.handle = NULL;
+
+		handle.promise().detached = true;
+		handle.resume();
+
+		rethrow_detached_exception();
+	}
+
+	/**
+	 *  @brief  A suspended coroutine, kept by an awaiter until the event it
+	 *  waits for happens. The Arena that was bound when the coroutine
+	 *  suspended is bound again while it runs, and the Arena of the
+	 *  resuming code is restored when it suspends again.
+	 */
+	class Suspension {
+		private:
+			std::coroutine_handle<> handle;
+			Arena *arena = NULL;
+
+		public:
+			void suspend(std::coroutine_handle<> handle)
+			{
+				this->handle = handle;
+				arena = current_arena();
+			}
+
+			void resume()
+			{
+				ArenaScope arena_scope(arena);
+				handle.resume();
+
+				rethrow_detached_exception();
+			}
+	};
+};
+
+#endif
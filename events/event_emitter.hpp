@@ -5,41 +5,56 @@
 
 #include "../data-structures/dynamic-array.hpp"
 #include "../data-structures/string.hpp"
+#include "inplace-function.hpp"
+
+// Inline storage of a listener callback, captures must fit in it
+
+#ifndef FLOW_EVENT_CALLBACK_SIZE
+#define FLOW_EVENT_CALLBACK_SIZE (size_t) (6 * sizeof(void *))
+#endif
+
+namespace flow_event_emitter_tools {
+	/**
+	 *  @brief  Entry of the slot map of an EventEmitter. An id of a listener
+	 *  is the index of its slot and the generation of the slot, the
+	 *  generation is bumped when the listener is removed, so old ids of a
+	 *  reused slot do not match anymore.
+	 */
+	struct EventSlot {
+		// Index of the listener, or of the next free slot if the slot is free
+
+		uint32_t index;
+		uint32_t generation;
+	};
+};
 
 namespace flow {
+	using namespace flow_event_emitter_tools;
+
 	typedef size_t event_id_t;
 
 	template <typename... Args>
 	class EventListener {
-		private:
-			typedef std::function<void(Args...)> callback_t;
-
 		public:
-			std::function<void(Args...)> callback;
+			typedef InplaceFunction<void(Args...), FLOW_EVENT_CALLBACK_SIZE> callback_t;
+
+			callback_t callback;
 			event_id_t id;
 			bool recurrent;
 
+			// Cleared when the listener is removed while its EventEmitter
+			// is being triggered, it is dropped when the trigger ends
+
+			bool alive = true;
+
 			EventListener() {}
 
 			EventListener(callback_t&& callback, event_id_t id,	bool recurrent)
 				: callback(std::move(callback)), id(id), recurrent(recurrent) {}
 
-			EventListener(const EventListener<Args...>& other)
-				: callback(callback), id(id), recurrent(recurrent) {}
-
 			EventListener(EventListener<Args...>&& other)
-				: callback(std::move(callback)), id(id), recurrent(recurrent) {}
-
-			EventListener<Args...>& operator=(const EventListener<Args...>& other)
-			{
-				if (this == &other) return *this;
-
-				callback = other.callback;
-				id = other.id;
-				recurrent = other.recurrent;
-
-				return *this;
-			}
+				: callback(std::move(other.callback)), id(other.id),
+				recurrent(other.recurrent), alive(other.alive) {}
 
 			EventListener<Args...>& operator=(EventListener<Args...>&& other)
 			{
@@ -48,6 +63,7 @@ namespace flow {
 				callback = std::move(other.callback);
 				id = other.id;
 				recurrent = other.recurrent;
+				alive = other.alive;
 
 				other.callback = NULL;
 
@@ -57,13 +73,129 @@ namespace flow {
 
 	/**
 	 *  @brief  Event handling class. Listeners can be added and triggered.
+	 *  Listeners are stored contiguously and are found by id through a
+	 *  generational slot map, so adding and removing a listener is O(1), and
+	 *  the id of a removed listener never matches a later listener.
+	 *  Listeners can be added and removed from within a callback. Removed
+	 *  listeners are not called anymore, added listeners are first called on
+	 *  the next trigger.
+	 *  Callbacks are stored inline in the listeners, so adding a listener
+	 *  does not allocate once the listeners have grown.
 	 */
 	template <typename... Args>
 	class EventEmitter {
+		public:
+			typedef typename EventListener<Args...>::callback_t callback_t;
+
 		private:
-			typedef std::function<void(Args...)> callback_t;
+			static constexpr uint32_t NO_FREE_SLOT = UINT32_MAX;
+
 			DynamicArray<EventListener<Args...>> listeners;
-			event_id_t current_id = 0;
+			DynamicArray<EventSlot> slots;
+			uint32_t free_slot = NO_FREE_SLOT;
+
+			// Listeners added while triggering, they are moved to the
+			// listeners when the outermost trigger ends, so the listeners
+			// are never moved while one of them is being called
+
+			DynamicArray<EventListener<Args...>> added_listeners;
+
+			size_t trigger_depth = 0;
+			size_t removed_while_triggering = 0;
+			size_t live_count = 0;
+
+			static uint32_t slot_of(event_id_t id)
+			{
+				return id & UINT32_MAX;
+			}
+
+			static uint32_t generation_of(event_id_t id)
+			{
+				return id >> 32;
+			}
+
+			void free_slot_of(event_id_t id)
+			{
+				EventSlot& slot = slots[slot_of(id)];
+
+				slot.generation++;
+				slot.index = free_slot;
+				free_slot = slot_of(id);
+			}
+
+			/**
+			 *  @brief  Returns the listener of an id, or NULL if the listener
+			 *  does not exist or was removed already.
+			 */
+			EventListener<Args...> *find(event_id_t id)
+			{
+				if (slot_of(id) >= slots.size()) return NULL;
+
+				EventSlot& slot = slots[slot_of(id)];
+				if (slot.generation != generation_of(id)) return NULL;
+
+				EventListener<Args...> *listener = slot.index < listeners.size()
+					? &listeners[slot.index]
+					: &added_listeners[slot.index - listeners.size()];
+
+				return listener->alive ? listener : NULL;
+			}
+
+			/**
+			 *  @brief  Removes a listener by moving the last listener
+			 *  into its place.
+			 */
+			void swap_remove(size_t index)
+			{
+				free_slot_of(listeners[index].id);
+
+				if (index != listeners.size() - 1) {
+					listeners[index] = std::move(listeners[listeners.size() - 1]);
+					slots[slot_of(listeners[index].id)].index = index;
+				}
+
+				listeners.extract_rear();
+			}
+
+			/**
+			 *  @brief  Drops the listeners removed while triggering and moves
+			 *  the added listeners in place.
+			 */
+			void settle()
+			{
+				if (removed_while_triggering != 0) {
+					size_t kept = 0;
+
+					for (size_t i = 0; i < listeners.size(); i++) {
+						if (!listeners[i].alive) {
+							free_slot_of(listeners[i].id);
+							continue;
+						}
+
+						if (kept != i) {
+							listeners[kept] = std::move(listeners[i]);
+							slots[slot_of(listeners[kept].id)].index = kept;
+						}
+
+						kept++;
+					}
+
+					while (listeners.size() != kept) listeners.extract_rear();
+				}
+
+				for (size_t i = 0; i < added_listeners.size(); i++) {
+					if (!added_listeners[i].alive) {
+						free_slot_of(added_listeners[i].id);
+						continue;
+					}
+
+					slots[slot_of(added_listeners[i].id)].index = listeners.size();
+					listeners.append(std::move(added_listeners[i]));
+				}
+
+				while (added_listeners.size() != 0) added_listeners.extract_rear();
+				removed_while_triggering = 0;
+			}
 
 		public:
 			/**
@@ -73,11 +205,33 @@ namespace flow {
 			 *  should keep on existing after it has been triggered one time.
 			 *  @returns  The id of this listener. You will need to pass this to
 			 *  EventEmitter::remove_listener() if you wish to delete the listener.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
 			 */
 			event_id_t add_listener(callback_t&& callback, bool recurrent = true)
 			{
-				event_id_t id = current_id++;
-				listeners.append(EventListener<Args...>(std::move(callback), id, recurrent));
+				uint32_t slot_index;
+
+				if (free_slot != NO_FREE_SLOT) {
+					slot_index = free_slot;
+					free_slot = slots[slot_index].index;
+				} else {
+					slot_index = slots.size();
+					slots.append({ 0, 0 });
+				}
+
+				EventSlot& slot = slots[slot_index];
+				event_id_t id = (event_id_t) slot.generation << 32 | slot_index;
+
+				slot.index = listeners.size() + added_listeners.size();
+
+				if (trigger_depth == 0) {
+					listeners.append(EventListener<Args...>(std::move(callback), id, recurrent));
+				} else {
+					added_listeners.append(EventListener<Args...>(std::move(callback), id, recurrent));
+				}
+
+				live_count++;
 				return id;
 			}
 
@@ -87,21 +241,26 @@ namespace flow {
 			 *  EventEmitter::add_listener().
 			 *  @returns  A boolean indicating whether the listener has been found
 			 *  and got removed.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
 			 */
-			bool remove_listener(size_t listener_id)
+			bool remove_listener(event_id_t listener_id)
 			{
-				bool found = false;
-				size_t listeners_size = listeners.size();
+				EventListener<Args...> *listener = find(listener_id);
+				if (listener == NULL) return false;
 
-				for (size_t i = 0; i < listeners_size; i++) {
-					if (listeners[i].id == listener_id && i != listeners_size - 1) {
-						found = true;
-						listeners[i] = listeners[listeners_size - 1];
-					}
+				live_count--;
+
+				if (trigger_depth == 0) {
+					swap_remove(slots[slot_of(listener_id)].index);
+					return true;
 				}
 
-				listeners.extract_rear();
-				return found;
+				// The listener may be running, so it is only marked
+
+				listener->alive = false;
+				removed_while_triggering++;
+				return true;
 			}
 
 			/**
@@ -112,34 +271,33 @@ namespace flow {
 			 */
 			void trigger(Args... args)
 			{
-				size_t i = 0;
-
-				while (i < listeners.size()) {
-					EventListener<Args...>& listener = listeners[i];
-
-					// We must save the recurrent flag in case the callback calls
-					// EventEmitter::remove_listener() or EventEmitter::add_listener().
-					// This would alter the listeners DynamicArray and maybe also the
-					// reference, making it invalid or cause undefined behaviour.
+				trigger_depth++;
 
-					bool recurrent = listener.recurrent;
+				try {
+					// Listeners are not moved while triggering,
+					// added listeners are stored elsewhere
 
-					// Fire the callback now
+					for (size_t i = 0; i < listeners.size(); i++) {
+						EventListener<Args...>& listener = listeners[i];
+						if (!listener.alive) continue;
 
-					listener.callback(args...);
+						// Remove a non recurrent listener before calling it,
+						// so a nested trigger does not call it again
 
-					// And clean up this EventListener if it is not recurrent
-
-					if (recurrent) {
-						i++;
-					} else {
-						if (i != listeners.size() - 1) {
-							listeners[i] = listeners[listeners.size() - 1];
+						if (!listener.recurrent) {
+							listener.alive = false;
+							removed_while_triggering++;
+							live_count--;
 						}
 
-						listeners.extract_rear();
+						listener.callback(args...);
 					}
+				} catch (...) {
+					if (--trigger_depth == 0) settle();
+					throw;
 				}
+
+				if (--trigger_depth == 0) settle();
 			}
 
 			/**
@@ -147,9 +305,9 @@ namespace flow {
 			 */
 			size_t size()
 			{
-				return listeners.size();
+				return live_count;
 			}
 	};
 };
 
-#endif
\ No newline at end of file
+#endif
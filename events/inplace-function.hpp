@@ -0,0 +1,163 @@
+#ifndef FLOW_INPLACE_FUNCTION_HEADER
+#define FLOW_INPLACE_FUNCTION_HEADER
+
+#include <bits/stdc++.h>
+
+namespace flow {
+	template <typename Signature, size_t capacity = 4 * sizeof(void *)>
+	class InplaceFunction;
+
+	/**
+	 *  @brief  A move-only callable wrapper that stores its callable inline.
+	 *  It never allocates: a callable that does not fit in the storage is a
+	 *  compile error instead of a heap fallback.
+	 *  @tparam  R  The return type.
+	 *  @tparam  Args  The argument types.
+	 *  @tparam  capacity  The size of the inline storage in bytes.
+	 */
+	template <typename R, typename... Args, size_t capacity>
+	class InplaceFunction<R(Args...), capacity> {
+		private:
+			/**
+			 *  @brief  The operations of the stored callable type.
+			 */
+			struct Operations {
+				R (*invoke)(void *callable, Args&&... args);
+				void (*move)(void *dst, void *src);
+				void (*destroy)(void *callable);
+			};
+
+			template <typename F>
+			static constexpr Operations operations_of = {
+				[](void *callable, Args&&... args) -> R {
+					return std::invoke(*static_cast<F *>(callable),
+						std::forward<Args>(args)...);
+				},
+				[](void *dst, void *src) {
+					new (dst) F(std::move(*static_cast<F *>(src)));
+					static_cast<F *>(src)->~F();
+				},
+				[](void *callable) {
+					static_cast<F *>(callable)->~F();
+				}
+			};
+
+			alignas(std::max_align_t) mutable unsigned char storage[capacity];
+
+			// NULL if no callable is stored
+
+			const Operations *operations = NULL;
+
+			void take(InplaceFunction& other)
+			{
+				if (other.operations == NULL) return;
+
+				other.operations->move(storage, other.storage);
+				operations = other.operations;
+				other.operations = NULL;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an empty InplaceFunction.
+			 */
+			InplaceFunction() {}
+
+			InplaceFunction(std::nullptr_t) {}
+
+			/**
+			 *  @brief  Creates an InplaceFunction that stores a callable.
+			 *  @param  callable  The callable, must fit in the storage.
+			 */
+			template <typename F>
+			requires (
+				!std::is_same_v<std::decay_t<F>, InplaceFunction>
+				&& std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+			)
+			InplaceFunction(F&& callable)
+			{
+				using Callable = std::decay_t<F>;
+
+				static_assert(sizeof(Callable) <= capacity,
+					"InplaceFunction: the callable does not fit in the inline storage");
+				static_assert(alignof(Callable) <= alignof(std::max_align_t),
+					"InplaceFunction: the callable is over-aligned");
+				static_assert(std::is_nothrow_move_constructible_v<Callable>,
+					"InplaceFunction: the callable must be nothrow move constructible");
+
+				new (storage) Callable(std::forward<F>(callable));
+				operations = &operations_of<Callable>;
+			}
+
+			InplaceFunction(const InplaceFunction& other) = delete;
+			InplaceFunction& operator=(const InplaceFunction& other) = delete;
+
+			/**
+			 *  @brief  Moves the callable of another InplaceFunction,
+			 *  which is left empty.
+			 */
+			InplaceFunction(InplaceFunction&& other)
+			{
+				take(other);
+			}
+
+			/**
+			 *  @brief  Destroys the stored callable and moves the callable of
+			 *  another InplaceFunction, which is left empty.
+			 */
+			InplaceFunction& operator=(InplaceFunction&& other)
+			{
+				if (this == &other) return *this;
+
+				reset();
+				take(other);
+
+				return *this;
+			}
+
+			/**
+			 *  @brief  Destroys the stored callable.
+			 */
+			InplaceFunction& operator=(std::nullptr_t)
+			{
+				reset();
+				return *this;
+			}
+
+			~InplaceFunction()
+			{
+				reset();
+			}
+
+			/**
+			 *  @brief  Destroys the stored callable, leaving the
+			 *  InplaceFunction empty.
+			 */
+			void reset()
+			{
+				if (operations == NULL) return;
+
+				operations->destroy(storage);
+				operations = NULL;
+			}
+
+			/**
+			 *  @brief  Calls the stored callable.
+			 *  Calling an empty InplaceFunction is undefined behaviour.
+			 */
+			R operator()(Args... args) const
+			{
+				return operations->invoke(storage, std::forward<Args>(args)...);
+			}
+
+			/**
+			 *  @brief  Returns whether a callable is stored.
+			 */
+			explicit operator bool() const
+			{
+				return operations != NULL;
+			}
+	};
+};
+
+#endif
@@ -23,6 +23,8 @@ namespace flow {
 		#define ANSI_ERASE_LINE(n)       "\x1b[K"
 		#define ANSI_SCROLL_UP(n)        "\x1b[" #n "S"
 		#define ANSI_SCROLL_DOWN(n)      "\x1b[" #n "T"
+		#define ANSI_HIDE_CURSOR         "\x1b[?25l"
+		#define ANSI_SHOW_CURSOR         "\x1b[?25h"
 
 		/*
 			Rendition
@@ -0,0 +1,214 @@
+#ifndef FLOW_FRAME_BUILDER_HEADER
+#define FLOW_FRAME_BUILDER_HEADER
+
+#include <bits/stdc++.h>
+
+#include "ansi.hpp"
+#include "output-writer.hpp"
+#include "../data-structures/format-string.hpp"
+#include "../data-structures/string.hpp"
+#include "../data-structures/string-tools.hpp"
+#include "../data-structures/string-view.hpp"
+
+// Initial capacity of the buffer of a FrameBuilder
+
+#ifndef FLOW_FRAME_BUILDER_SIZE
+#define FLOW_FRAME_BUILDER_SIZE (size_t) 16384
+#endif
+
+namespace flow {
+	/**
+	 *  @brief  Composes a frame of a terminal status display, its text and
+	 *  ANSI escape sequences, in one buffer, so it is written with a single
+	 *  write and appears at once. The buffer is allocated once and reused
+	 *  by every frame, begin() starts the next frame. Unlike the macros of
+	 *  formatting/ansi.hpp, positions and colours may be runtime values.
+	 *  All methods return the FrameBuilder, so calls can be chained.
+	 */
+	class FrameBuilder {
+		private:
+			String frame;
+
+			/**
+			 *  @brief  Attaches "ESC [", a number and a final character.
+			 */
+			FrameBuilder& escape(size_t n, char final_char)
+			{
+				// "ESC [", at most 20 digits and the final character
+
+				frame.reserve(23);
+
+				char *buf = frame.data() + frame.size();
+				buf[0] = '\x1b';
+				buf[1] = '[';
+
+				size_t len = 2 + flow_tools::write_uint_to_str(n, buf + 2);
+				buf[len++] = final_char;
+
+				frame.unsafe_increment_element_count(len);
+				return *this;
+			}
+
+			/**
+			 *  @brief  Attaches a 24-bit colour sequence, "ESC [38;2;r;g;bm"
+			 *  for the foreground and "ESC [48;2;r;g;bm" for the background.
+			 */
+			FrameBuilder& colour(char layer, uint8_t r, uint8_t g, uint8_t b)
+			{
+				frame.reserve(19);
+
+				char *buf = frame.data() + frame.size();
+				memcpy(buf, "\x1b[38;2;", 7);
+				buf[2] = layer;
+
+				size_t len = 7;
+				len += flow_tools::write_uint_to_str(r, buf + len);
+				buf[len++] = ';';
+				len += flow_tools::write_uint_to_str(g, buf + len);
+				buf[len++] = ';';
+				len += flow_tools::write_uint_to_str(b, buf + len);
+				buf[len++] = 'm';
+
+				frame.unsafe_increment_element_count(len);
+				return *this;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates a FrameBuilder.
+			 *  @param  capacity  The initial capacity of the buffer, it grows
+			 *  if a frame does not fit.
+			 */
+			FrameBuilder(size_t capacity = FLOW_FRAME_BUILDER_SIZE) : frame(capacity) {}
+
+			/**
+			 *  @brief  Starts a new frame, keeping the buffer.
+			 *  @param  home  Whether the frame starts by hiding the cursor
+			 *  and moving it to the top left corner.
+			 */
+			FrameBuilder& begin(bool home = true)
+			{
+				frame.unsafe_set_element_count(0);
+
+				if (home) text(ANSI_HIDE_CURSOR ANSI_CURSOR_TO(1, 1));
+				return *this;
+			}
+
+			/**
+			 *  @brief  Moves the cursor to a position, 1-based.
+			 */
+			FrameBuilder& move_to(size_t row, size_t col)
+			{
+				frame.reserve(44);
+
+				char *buf = frame.data() + frame.size();
+				buf[0] = '\x1b';
+				buf[1] = '[';
+
+				size_t len = 2 + flow_tools::write_uint_to_str(row, buf + 2);
+				buf[len++] = ';';
+				len += flow_tools::write_uint_to_str(col, buf + len);
+				buf[len++] = 'H';
+
+				frame.unsafe_increment_element_count(len);
+				return *this;
+			}
+
+			FrameBuilder& cursor_up(size_t n = 1) { return escape(n, 'A'); }
+			FrameBuilder& cursor_down(size_t n = 1) { return escape(n, 'B'); }
+			FrameBuilder& cursor_forward(size_t n = 1) { return escape(n, 'C'); }
+			FrameBuilder& cursor_back(size_t n = 1) { return escape(n, 'D'); }
+			FrameBuilder& cursor_to_col(size_t col) { return escape(col, 'G'); }
+
+			/**
+			 *  @brief  Erases from the cursor to the end of the line.
+			 */
+			FrameBuilder& erase_line() { return text(ANSI_ERASE_LINE()); }
+
+			/**
+			 *  @brief  Erases from the cursor to the end of the display.
+			 */
+			FrameBuilder& erase_display() { return text(ANSI_ERASE_DISPLAY()); }
+
+			/**
+			 *  @brief  Attaches a Select Graphic Rendition sequence,
+			 *  e.g. 1 for bold or 31 for a red foreground.
+			 */
+			FrameBuilder& sgr(size_t code) { return escape(code, 'm'); }
+
+			FrameBuilder& reset() { return text(ANSI_RESET); }
+
+			/**
+			 *  @brief  Sets a 24-bit foreground colour.
+			 */
+			FrameBuilder& fg(uint8_t r, uint8_t g, uint8_t b) { return colour('3', r, g, b); }
+
+			/**
+			 *  @brief  Sets a 24-bit background colour.
+			 */
+			FrameBuilder& bg(uint8_t r, uint8_t g, uint8_t b) { return colour('4', r, g, b); }
+
+			/**
+			 *  @brief  Attaches text, or a sequence from formatting/ansi.hpp.
+			 */
+			template <size_t char_count>
+			FrameBuilder& text(const char (&chars)[char_count])
+			{
+				return text(chars, char_count - 1);
+			}
+
+			FrameBuilder& text(const char *chars, size_t size)
+			{
+				frame.reserve(size);
+				if (size != 0) memcpy(frame.data() + frame.size(), chars, size);
+				frame.unsafe_increment_element_count(size);
+
+				return *this;
+			}
+
+			FrameBuilder& text(const String& str) { return text(str.data(), str.size()); }
+			FrameBuilder& text(const StringView& view) { return text(view.data(), view.size()); }
+
+			/**
+			 *  @brief  Formats text into the frame, see FormatString.
+			 */
+			template <typename... Args>
+			FrameBuilder& formatted(FormatString<std::type_identity_t<Args>...> fmt,
+				const Args&... args)
+			{
+				frame.attach_formatted(fmt, args...);
+				return *this;
+			}
+
+			/**
+			 *  @brief  Erases the rest of the line and moves to the next one,
+			 *  so a shorter line leaves nothing of the previous frame behind.
+			 */
+			FrameBuilder& end_line() { return text(ANSI_ERASE_LINE() "\r\n"); }
+
+			/**
+			 *  @brief  Returns the frame built so far.
+			 */
+			StringView view() const
+			{
+				return StringView(frame);
+			}
+
+			size_t size() const
+			{
+				return frame.size();
+			}
+
+			/**
+			 *  @brief  Writes the frame through an OutputWriter and flushes
+			 *  it, one write for the whole frame.
+			 */
+			void present(OutputWriter& out)
+			{
+				out.write(frame);
+				out.flush();
+			}
+	};
+};
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef FLOW_OUTPUT_WRITER_HEADER
+#define FLOW_OUTPUT_WRITER_HEADER
+
+#include <bits/stdc++.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../data-structures/format-string.hpp"
+#include "../data-structures/string.hpp"
+#include "../data-structures/string-view.hpp"
+
+// Size of the buffer of an OutputWriter
+
+#ifndef FLOW_OUTPUT_WRITER_BUFFER_SIZE
+#define FLOW_OUTPUT_WRITER_BUFFER_SIZE (size_t) 65536
+#endif
+
+namespace flow {
+	enum class OutputWriterErrors {
+		WRITE_FAILED
+	};
+
+	/**
+	 *  @brief  Batches output for a file descriptor, e.g. a terminal, in a
+	 *  large buffer and writes it with a single write() when the buffer is
+	 *  full or flush() is called. Data larger than the buffer is written
+	 *  together with the buffered data with one writev(), without copying.
+	 *  Bypasses stdio, so output written through FILE *streams to the same
+	 *  descriptor should be flushed first. Not thread safe.
+	 */
+	class OutputWriter {
+		private:
+			int fd;
+			char *buffer;
+			size_t buffered = 0;
+
+			/**
+			 *  @brief  Writes a number of buffers completely, retrying on
+			 *  short writes. Throws OutputWriterErrors::WRITE_FAILED if a
+			 *  write fails.
+			 */
+			void write_all(struct iovec *iov, int iov_count)
+			{
+				while (iov_count != 0) {
+					ssize_t n = ::writev(fd, iov, iov_count);
+
+					if (n < 0) {
+						if (errno == EINTR) continue;
+						throw OutputWriterErrors::WRITE_FAILED;
+					}
+
+					// Skip what was written
+
+					while (iov_count != 0 && (size_t) n >= iov->iov_len) {
+						n -= iov->iov_len;
+						iov++;
+						iov_count--;
+					}
+
+					if (iov_count != 0) {
+						iov->iov_base = (char *) iov->iov_base + n;
+						iov->iov_len -= n;
+					}
+				}
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an OutputWriter.
+			 *  @param  fd  The file descriptor to write to, defaults to stdout.
+			 *  It is not closed by the OutputWriter.
+			 */
+			OutputWriter(int fd = STDOUT_FILENO)
+				: fd(fd), buffer(new char[FLOW_OUTPUT_WRITER_BUFFER_SIZE]) {}
+
+			OutputWriter(const OutputWriter& other) = delete;
+			OutputWriter& operator=(const OutputWriter& other) = delete;
+
+			/**
+			 *  @brief  Flushes the buffer. Errors are ignored.
+			 */
+			~OutputWriter()
+			{
+				try {
+					flush();
+				} catch (OutputWriterErrors) {}
+
+				delete[] buffer;
+			}
+
+			/**
+			 *  @brief  Returns the number of buffered bytes.
+			 */
+			size_t size() const
+			{
+				return buffered;
+			}
+
+			/**
+			 *  @brief  Writes the buffered data to the file descriptor.
+			 *  Throws OutputWriterErrors::WRITE_FAILED if the write fails.
+			 */
+			void flush()
+			{
+				if (buffered == 0) return;
+
+				struct iovec iov = { buffer, buffered };
+				buffered = 0;
+				write_all(&iov, 1);
+			}
+
+			/**
+			 *  @brief  Buffers data, or writes it at once with the buffered
+			 *  data if it does not fit.
+			 *  @param  data  A pointer to the data.
+			 *  @param  size  The size of the data.
+			 *  @note  Runtime: O(size)
+			 *  @note  Memory: O(1)
+			 */
+			void write(const char *data, size_t size)
+			{
+				if (buffered + size <= FLOW_OUTPUT_WRITER_BUFFER_SIZE) {
+					if (size != 0) memcpy(buffer + buffered, data, size);
+					buffered += size;
+					return;
+				}
+
+				struct iovec iov[2] = {
+					{ buffer, buffered },
+					{ const_cast<char *>(data), size }
+				};
+
+				buffered = 0;
+				write_all(iov, 2);
+			}
+
+			void write(const String& str)
+			{
+				write(str.data(), str.size());
+			}
+
+			void write(const StringView& view)
+			{
+				write(view.data(), view.size());
+			}
+
+			/**
+			 *  @brief  Buffers a string literal, without its terminating NULL
+			 *  byte. Works with the macros of formatting/ansi.hpp.
+			 */
+			template <size_t char_count>
+			void write(const char (&chars)[char_count])
+			{
+				write(chars, char_count - 1);
+			}
+
+			/**
+			 *  @brief  Buffers a String followed by a newline.
+			 */
+			void write_line(const String& str)
+			{
+				write(str.data(), str.size());
+				write("\n", 1);
+			}
+
+			/**
+			 *  @brief  Formats a string straight into the buffer, without
+			 *  creating a String. See FormatString.
+			 *  @param  fmt  The format string.
+			 *  @param  args  The arguments.
+			 *  @note  Runtime: O(n), n = the size of the output
+			 *  @note  Memory: O(1) if the output fits in the buffer
+			 */
+			template <typename... Args>
+			void write_formatted(FormatString<std::type_identity_t<Args>...> fmt,
+				const Args&... args)
+			{
+				size_t size = String::format_size(fmt, args...);
+
+				if (buffered + size > FLOW_OUTPUT_WRITER_BUFFER_SIZE) flush();
+
+				if (size > FLOW_OUTPUT_WRITER_BUFFER_SIZE) {
+					write(String::format(fmt, args...));
+					return;
+				}
+
+				buffered += String::format_to(buffer + buffered, fmt, args...);
+			}
+	};
+};
+
+#endif
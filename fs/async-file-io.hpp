@@ -0,0 +1,782 @@
+#ifndef FLOW_ASYNC_FILE_IO_HEADER
+#define FLOW_ASYNC_FILE_IO_HEADER
+
+#include <bits/stdc++.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "file-stream.hpp"
+#include "file-descriptor-cache.hpp"
+#include "../concurrency/future.hpp"
+#include "../concurrency/thread-pool.hpp"
+#include "../data-structures/queue.hpp"
+#include "../data-structures/stream.hpp"
+#include "../data-structures/string.hpp"
+#include "../events/inplace-function.hpp"
+#include "../memory/arena.hpp"
+
+// Inline storage of a completion callback, captures must fit in it
+
+#ifndef FLOW_FILE_IO_CALLBACK_SIZE
+#define FLOW_FILE_IO_CALLBACK_SIZE (size_t) (6 * sizeof(void *))
+#endif
+
+// Number of submission queue entries of an io_uring
+
+#ifndef FLOW_IO_URING_ENTRIES
+#define FLOW_IO_URING_ENTRIES (size_t) 256
+#endif
+
+namespace flow {
+	/**
+	 *  @brief  The outcome of a file operation of AsyncFileIO.
+	 */
+	struct FileIOResult {
+		// The bytes read, or the data that was written
+
+		String data;
+
+		// The number of bytes transferred
+
+		size_t size = 0;
+
+		// 0 on success, the errno of the failure otherwise
+
+		int error = 0;
+	};
+
+	typedef InplaceFunction<void(FileIOResult&&), FLOW_FILE_IO_CALLBACK_SIZE>
+		file_io_callback_t;
+
+	// Reads from or writes to the current position of the file
+
+	constexpr off_t FILE_IO_CURRENT_POSITION = -1;
+
+	enum class FileIOBackends {
+		AUTO,
+		IO_URING,
+		THREAD_POOL
+	};
+};
+
+namespace flow_async_file_io_tools {
+	enum class FileIOKinds { READ, WRITE };
+
+	/**
+	 *  @brief  A read or write in flight. Owned by the backend until it
+	 *  completes, then by the task that runs its callback on the loop.
+	 */
+	struct FileIOOperation {
+		FileIOKinds kind;
+		int fd;
+		off_t offset;
+		size_t length;
+
+		flow::FileIOResult result;
+		flow::file_io_callback_t callback;
+	};
+
+	typedef flow::InplaceFunction<void(FileIOOperation *)> completion_t;
+
+	/**
+	 *  @brief  Runs FileIOOperations and reports them as completed,
+	 *  possibly on another thread.
+	 */
+	class FileIOBackend {
+		public:
+			virtual ~FileIOBackend() {}
+
+			virtual void submit(FileIOOperation *op) = 0;
+	};
+
+	/**
+	 *  @brief  Runs FileIOOperations as blocking pread() and pwrite() calls
+	 *  on a ThreadPool of its own, so they do not block the loop.
+	 */
+	class ThreadPoolFileIOBackend : public FileIOBackend {
+		private:
+			completion_t complete;
+			flow::ThreadPool pool;
+
+			static void run(FileIOOperation *op)
+			{
+				char *data = op->result.data.data();
+
+				while (op->result.size < op->length) {
+					size_t left = op->length - op->result.size;
+					char *position = data + op->result.size;
+					ssize_t n;
+
+					if (op->kind == FileIOKinds::READ) {
+						n = op->offset == flow::FILE_IO_CURRENT_POSITION
+							? ::read(op->fd, position, left)
+							: ::pread(op->fd, position, left, op->offset + op->result.size);
+					} else {
+						n = op->offset == flow::FILE_IO_CURRENT_POSITION
+							? ::write(op->fd, position, left)
+							: ::pwrite(op->fd, position, left, op->offset + op->result.size);
+					}
+
+					if (n < 0) {
+						if (errno == EINTR) continue;
+
+						op->result.error = errno;
+						return;
+					}
+
+					// End of file
+
+					if (n == 0) return;
+
+					op->result.size += n;
+				}
+			}
+
+		public:
+			ThreadPoolFileIOBackend(completion_t&& complete, size_t thread_count)
+				: complete(std::move(complete)), pool(thread_count) {}
+
+			void submit(FileIOOperation *op)
+			{
+				pool.submit([this, op]() {
+					run(op);
+					complete(op);
+				});
+			}
+	};
+
+	/**
+	 *  @brief  Runs FileIOOperations on an io_uring, set up with raw system
+	 *  calls. Operations are submitted right away, a reaper thread waits
+	 *  for their completions. Short reads and writes are resubmitted for
+	 *  the rest, a read until it reaches the end of the file.
+	 *  At most as many operations as the completion queue holds are in
+	 *  flight, more are queued until some complete.
+	 */
+	class IoUringFileIOBackend : public FileIOBackend {
+		private:
+			completion_t complete;
+
+			int ring_fd = -1;
+
+			void *sq_ring = MAP_FAILED;
+			void *cq_ring = MAP_FAILED;
+			size_t sq_ring_size = 0;
+			size_t cq_ring_size = 0;
+
+			struct io_uring_sqe *sqes = (struct io_uring_sqe *) MAP_FAILED;
+			size_t sqes_size = 0;
+
+			unsigned *sq_tail;
+			unsigned *sq_mask;
+			unsigned *sq_array;
+
+			unsigned *cq_head;
+			unsigned *cq_tail;
+			unsigned *cq_mask;
+			struct io_uring_cqe *cqes;
+
+			size_t max_in_flight;
+
+			// Guards the submission queue, in_flight and waiting
+
+			std::mutex mutex;
+			size_t in_flight = 0;
+			flow::Queue<FileIOOperation *> waiting;
+
+			std::thread reaper;
+
+			template <typename type>
+			static type *at(void *ring, unsigned offset)
+			{
+				return (type *) ((char *) ring + offset);
+			}
+
+			static int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+			{
+				return (int) ::syscall(__NR_io_uring_enter, fd, to_submit,
+					min_complete, flags, NULL, 0);
+			}
+
+			/**
+			 *  @brief  Places an entry on the submission queue and submits it.
+			 *  The mutex must be held.
+			 */
+			void push_entry(uint8_t opcode, FileIOOperation *op)
+			{
+				unsigned tail = *sq_tail;
+				unsigned index = tail & *sq_mask;
+				struct io_uring_sqe *sqe = &sqes[index];
+
+				memset(sqe, 0, sizeof(*sqe));
+				sqe->opcode = opcode;
+				sqe->user_data = (uint64_t) op;
+
+				if (op != NULL) {
+					sqe->fd = op->fd;
+					sqe->addr = (uint64_t) (op->result.data.data() + op->result.size);
+					sqe->len = op->length - op->result.size;
+					sqe->off = op->offset == flow::FILE_IO_CURRENT_POSITION
+						? (uint64_t) -1 : op->offset + op->result.size;
+				}
+
+				sq_array[index] = index;
+				__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+				while (enter(ring_fd, 1, 0, 0) < 0 && errno == EINTR);
+			}
+
+			void push_operation(FileIOOperation *op)
+			{
+				push_entry(op->kind == FileIOKinds::READ
+					? IORING_OP_READ : IORING_OP_WRITE, op);
+			}
+
+			/**
+			 *  @brief  Handles a completion. Returns whether the operation
+			 *  is done, or was resubmitted for the rest of a short read or
+			 *  write. A read that transferred nothing reached the end of
+			 *  the file.
+			 *  The mutex must be held, it also orders the accesses to the
+			 *  operation of the submitting thread before those of the reaper.
+			 */
+			bool handle_completion(FileIOOperation *op, int res)
+			{
+				if (res < 0) {
+					op->result.error = -res;
+				} else {
+					op->result.size += res;
+
+					if (res > 0 && op->result.size < op->length) {
+						push_operation(op);
+						return false;
+					}
+				}
+
+				in_flight--;
+
+				if (waiting.size() != 0) {
+					in_flight++;
+					push_operation(waiting.pop());
+				}
+
+				return true;
+			}
+
+			void reap()
+			{
+				bool stop_seen = false;
+
+				while (true) {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (stop_seen && in_flight == 0) return;
+					}
+
+					if (enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+						return;
+					}
+
+					unsigned head = *cq_head;
+					unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+					while (head != tail) {
+						struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+						FileIOOperation *op = (FileIOOperation *) cqe->user_data;
+						int res = cqe->res;
+
+						head++;
+						__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+						// The entry without an operation is the stop signal
+
+						if (op == NULL) {
+							stop_seen = true;
+							continue;
+						}
+
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+							if (!handle_completion(op, res)) continue;
+						}
+
+						complete(op);
+					}
+				}
+			}
+
+			/**
+			 *  @brief  Returns whether the kernel supports the read and write
+			 *  opcodes, which io_uring gained after it was introduced.
+			 */
+			bool supports_read_write()
+			{
+				size_t ops_len = (size_t) IORING_OP_WRITE + 1;
+				struct io_uring_probe *probe = (struct io_uring_probe *) calloc(1,
+					sizeof(struct io_uring_probe) + ops_len * sizeof(struct io_uring_probe_op));
+
+				bool supported = ::syscall(__NR_io_uring_register, ring_fd,
+						IORING_REGISTER_PROBE, probe, ops_len) >= 0
+					&& probe->last_op >= IORING_OP_WRITE
+					&& (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)
+					&& (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+
+				free(probe);
+				return supported;
+			}
+
+			void unmap()
+			{
+				if (sqes != MAP_FAILED) ::munmap(sqes, sqes_size);
+				if (cq_ring != MAP_FAILED && cq_ring != sq_ring) ::munmap(cq_ring, cq_ring_size);
+				if (sq_ring != MAP_FAILED) ::munmap(sq_ring, sq_ring_size);
+				if (ring_fd >= 0) ::close(ring_fd);
+			}
+
+		public:
+			IoUringFileIOBackend(completion_t&& complete)
+				: complete(std::move(complete)) {}
+
+			IoUringFileIOBackend(const IoUringFileIOBackend& other) = delete;
+			IoUringFileIOBackend& operator=(const IoUringFileIOBackend& other) = delete;
+
+			/**
+			 *  @brief  Creates the io_uring and starts the reaper.
+			 *  @returns  False if io_uring is not available, e.g. on an old
+			 *  kernel or when it is disabled.
+			 */
+			bool setup()
+			{
+				struct io_uring_params params;
+				memset(&params, 0, sizeof(params));
+
+				ring_fd = (int) ::syscall(__NR_io_uring_setup, FLOW_IO_URING_ENTRIES, &params);
+				if (ring_fd < 0) return false;
+
+				// Without IORING_FEAT_NODROP completions can be lost
+
+				if (!(params.features & IORING_FEAT_NODROP)) return false;
+
+				// Kernels without probing do not have the read and write opcodes
+
+				if (!supports_read_write()) return false;
+
+				sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				cq_ring_size = params.cq_off.cqes
+					+ params.cq_entries * sizeof(struct io_uring_cqe);
+
+				bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+				if (single_mmap) sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+				sq_ring = ::mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+				if (sq_ring == MAP_FAILED) return false;
+
+				cq_ring = single_mmap ? sq_ring : ::mmap(NULL, cq_ring_size,
+					PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+				if (cq_ring == MAP_FAILED) return false;
+
+				sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+				sqes = (struct io_uring_sqe *) ::mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+				if (sqes == MAP_FAILED) return false;
+
+				sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+				sq_mask = at<unsigned>(sq_ring, params.sq_off.ring_mask);
+				sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+
+				cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+				cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+				cq_mask = at<unsigned>(cq_ring, params.cq_off.ring_mask);
+				cqes = at<struct io_uring_cqe>(cq_ring, params.cq_off.cqes);
+
+				// One completion queue entry is kept for the stop signal
+
+				max_in_flight = params.cq_entries - 1;
+
+				reaper = std::thread([this]() { reap(); });
+				return true;
+			}
+
+			/**
+			 *  @brief  Waits for all operations in flight, then stops.
+			 */
+			~IoUringFileIOBackend()
+			{
+				if (reaper.joinable()) {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						push_entry(IORING_OP_NOP, NULL);
+					}
+
+					reaper.join();
+				}
+
+				unmap();
+			}
+
+			void submit(FileIOOperation *op)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				if (in_flight == max_in_flight) {
+					waiting.push(op);
+					return;
+				}
+
+				in_flight++;
+				push_operation(op);
+			}
+	};
+};
+
+namespace flow {
+	using namespace flow_async_file_io_tools;
+
+	/**
+	 *  @brief  Reads and writes files without blocking the loop. Operations
+	 *  run on an io_uring if the kernel supports it, and as blocking calls
+	 *  on a ThreadPool of their own otherwise. Completion callbacks are
+	 *  posted to the loop, so they may use Sockets and Arenas of the loop.
+	 *  Buffers are allocated on the heap, an operation may complete after
+	 *  the request that started it finished.
+	 *  Must be destroyed before the loop, it waits for the operations in
+	 *  flight.
+	 */
+	class AsyncFileIO {
+		private:
+			InplaceFunction<void(task_t&&)> post_to_loop;
+			FileIOBackend *backend = NULL;
+			bool io_uring = false;
+
+			void complete(FileIOOperation *op)
+			{
+				post_to_loop([op]() {
+					op->result.data.unsafe_set_element_count(op->result.size);
+					op->callback(std::move(op->result));
+
+					delete op;
+				});
+			}
+
+			void submit(FileIOOperation *op)
+			{
+				backend->submit(op);
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an AsyncFileIO.
+			 *  @param  loop  The loop completions are posted to, e.g. a
+			 *  SocketServer.
+			 *  @param  preferred  The backend to use. AUTO uses io_uring when
+			 *  available. IO_URING falls back to THREAD_POOL if unavailable.
+			 *  @param  thread_count  The number of threads of the ThreadPool
+			 *  backend, which each block on one operation at a time.
+			 */
+			template <FutureExecutor Loop>
+			AsyncFileIO(
+				Loop& loop,
+				enum FileIOBackends preferred = FileIOBackends::AUTO,
+				size_t thread_count = 4
+			) : post_to_loop([&loop](task_t&& fn) { execute_on(loop, std::move(fn)); })
+			{
+				completion_t completion = [this](FileIOOperation *op) { complete(op); };
+
+				if (preferred != FileIOBackends::THREAD_POOL) {
+					IoUringFileIOBackend *ring = new IoUringFileIOBackend(std::move(completion));
+
+					if (ring->setup()) {
+						backend = ring;
+						io_uring = true;
+						return;
+					}
+
+					delete ring;
+					completion = [this](FileIOOperation *op) { complete(op); };
+				}
+
+				backend = new ThreadPoolFileIOBackend(std::move(completion), thread_count);
+			}
+
+			AsyncFileIO(const AsyncFileIO& other) = delete;
+			AsyncFileIO& operator=(const AsyncFileIO& other) = delete;
+
+			~AsyncFileIO()
+			{
+				delete backend;
+			}
+
+			/**
+			 *  @brief  Returns whether operations run on an io_uring.
+			 */
+			bool uses_io_uring() const
+			{
+				return io_uring;
+			}
+
+			/**
+			 *  @brief  Reads from a file without blocking.
+			 *  @param  fd  The file descriptor, must stay open until the
+			 *  callback runs.
+			 *  @param  offset  The offset to read at, or
+			 *  FILE_IO_CURRENT_POSITION.
+			 *  @param  length  The maximum number of bytes to read, fewer are
+			 *  read at the end of the file.
+			 *  @param  callback  Called on the loop with the bytes read.
+			 */
+			void read(int fd, off_t offset, size_t length, file_io_callback_t&& callback)
+			{
+				ArenaScope heap_scope(NULL);
+
+				FileIOOperation *op = new FileIOOperation {
+					FileIOKinds::READ, fd, offset, length,
+					FileIOResult { String(std::max(length, (size_t) 1)) },
+					std::move(callback)
+				};
+
+				submit(op);
+			}
+
+			/**
+			 *  @brief  Writes to a file without blocking.
+			 *  @param  fd  The file descriptor, must stay open until the
+			 *  callback runs.
+			 *  @param  offset  The offset to write at, or
+			 *  FILE_IO_CURRENT_POSITION, e.g. for a file opened with O_APPEND.
+			 *  @param  data  The data to write, it is kept until the callback.
+			 *  Data on an Arena is copied to the heap, the Arena may be reset
+			 *  before the write completes.
+			 *  @param  callback  Called on the loop once all data was written
+			 *  or the write failed.
+			 */
+			void write(int fd, off_t offset, String&& data, file_io_callback_t&& callback)
+			{
+				ArenaScope heap_scope(NULL);
+
+				size_t length = data.size();
+
+				FileIOOperation *op = new FileIOOperation {
+					FileIOKinds::WRITE, fd, offset, length,
+					FileIOResult { std::move(data) },
+					std::move(callback)
+				};
+
+				submit(op);
+			}
+
+			/**
+			 *  @brief  Reads from a file without blocking.
+			 *  @returns  A Future of the bytes read, made ready on the loop.
+			 *  It fails with FileErrors::READ_FAILED.
+			 */
+			Future<String> async_read(int fd, off_t offset, size_t length)
+			{
+				Promise<String> promise;
+				Future<String> future = promise.get_future();
+
+				read(fd, offset, length, [promise = std::move(promise)]
+					(FileIOResult&& result) mutable
+				{
+					if (result.error != 0) {
+						promise.set_exception(std::make_exception_ptr(FileErrors::READ_FAILED));
+					} else {
+						promise.set_value(std::move(result.data));
+					}
+				});
+
+				return future;
+			}
+
+			/**
+			 *  @brief  Writes to a file without blocking.
+			 *  @returns  A Future of the number of bytes written, made ready
+			 *  on the loop. It fails with FileErrors::WRITE_FAILED.
+			 */
+			Future<size_t> async_write(int fd, off_t offset, String&& data)
+			{
+				Promise<size_t> promise;
+				Future<size_t> future = promise.get_future();
+
+				write(fd, offset, std::move(data), [promise = std::move(promise)]
+					(FileIOResult&& result) mutable
+				{
+					if (result.error != 0) {
+						promise.set_exception(std::make_exception_ptr(FileErrors::WRITE_FAILED));
+					} else {
+						promise.set_value(result.size);
+					}
+				});
+
+				return future;
+			}
+	};
+
+	/**
+	 *  @brief  Reads a file from start to end into a Stream, keeping a
+	 *  number of chunks in flight ahead of the consumer. Only chunks the
+	 *  consumer asked for with request_more() are read, so a consumer that
+	 *  hands chunks to a slower sink, e.g. a Socket, asks for more once the
+	 *  sink caught up, and the file is not read into memory faster than
+	 *  it is sent. Chunks are written to read_stream in order, on the loop,
+	 *  and read_stream is ended at the end of the file or on the first error.
+	 */
+	class AsyncFileReader {
+		private:
+			AsyncFileIO& io;
+			SharedFileDescriptor file;
+			size_t chunk_size;
+			size_t depth;
+
+			// Chunks that completed out of order, indexed by chunk number
+
+			DynamicArray<String> slots;
+			DynamicArray<bool> filled;
+
+			size_t next_issued = 0;
+			size_t next_delivered = 0;
+			size_t chunk_count;
+
+			// Number of chunks the consumer asked for, from the start of the file
+
+			size_t requested = 0;
+
+			// Number of reads whose callback has not run yet
+
+			size_t in_flight = 0;
+
+			bool started = false;
+			bool failed = false;
+
+			/**
+			 *  @brief  Reads the requested chunks that fit in the read-ahead.
+			 */
+			void issue_requested()
+			{
+				size_t limit = std::min({ chunk_count, requested, next_delivered + depth });
+				while (next_issued < limit) issue();
+			}
+
+			void issue()
+			{
+				size_t chunk = next_issued++;
+				in_flight++;
+
+				io.read(file.fd(), chunk * chunk_size, chunk_size, [this, chunk]
+					(FileIOResult&& result)
+				{
+					in_flight--;
+
+					if (!failed && result.error != 0) {
+						failed = true;
+						error = result.error;
+					}
+
+					// The reads still in flight refer to the reader and its
+					// file, so after a failure read_stream only ends, and the
+					// reader may be destroyed, once the last one completed
+
+					if (failed) {
+						if (in_flight == 0) read_stream.end();
+						return;
+					}
+
+					slots[chunk % depth] = std::move(result.data);
+					filled[chunk % depth] = true;
+					deliver();
+				});
+			}
+
+			void deliver()
+			{
+				while (next_delivered < chunk_count && filled[next_delivered % depth]) {
+					size_t slot = next_delivered % depth;
+
+					filled[slot] = false;
+					next_delivered++;
+
+					read_stream.write(slots[slot]);
+					if (!failed) issue_requested();
+				}
+
+				if (next_delivered == chunk_count) read_stream.end();
+			}
+
+		public:
+			Stream<String&> read_stream;
+
+			// The errno of the failed read, 0 if none failed
+
+			int error = 0;
+
+			/**
+			 *  @brief  Creates an AsyncFileReader.
+			 *  @param  io  The AsyncFileIO to read with, must outlive the reader.
+			 *  @param  file  The file to read.
+			 *  @param  chunk_size  The size of a chunk.
+			 *  @param  depth  The number of chunks read ahead.
+			 */
+			AsyncFileReader(
+				AsyncFileIO& io,
+				const SharedFileDescriptor& file,
+				size_t chunk_size = 65536,
+				size_t depth = 4
+			) : io(io), file(file), chunk_size(chunk_size), depth(depth),
+				slots(depth), filled(depth)
+			{
+				for (size_t i = 0; i < depth; i++) {
+					slots.append(String());
+					filled.append(false);
+				}
+
+				chunk_count = (file.size() + chunk_size - 1) / chunk_size;
+			}
+
+			AsyncFileReader(const AsyncFileReader& other) = delete;
+			AsyncFileReader& operator=(const AsyncFileReader& other) = delete;
+
+			/**
+			 *  @brief  Starts reading, requesting a number of chunks on top
+			 *  of those requested before. The reader must not be destroyed
+			 *  before read_stream ended.
+			 *  @param  chunks  The number of chunks to request.
+			 */
+			void start(size_t chunks)
+			{
+				read_stream.start();
+				started = true;
+
+				if (chunk_count == 0) {
+					read_stream.end();
+					return;
+				}
+
+				request_more(chunks);
+			}
+
+			/**
+			 *  @brief  Starts reading, requesting as many chunks as are
+			 *  read ahead.
+			 */
+			void start()
+			{
+				start(depth);
+			}
+
+			/**
+			 *  @brief  Asks for more chunks to be read and written to
+			 *  read_stream. May be called from a listener of read_stream.
+			 *  @param  chunks  The number of chunks, SIZE_MAX to read the rest
+			 *  of the file as fast as the read-ahead allows.
+			 */
+			void request_more(size_t chunks = 1)
+			{
+				requested = chunks > SIZE_MAX - requested ? SIZE_MAX : requested + chunks;
+				if (started && !failed) issue_requested();
+			}
+	};
+};
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef FLOW_DIRECTORY_WALKER_HEADER
+#define FLOW_DIRECTORY_WALKER_HEADER
+
+#include <bits/stdc++.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../concurrency/thread-pool.hpp"
+#include "../data-structures/stream.hpp"
+#include "../data-structures/string.hpp"
+#include "../events/inplace-function.hpp"
+#include "../memory/arena.hpp"
+
+// Size of the getdents64() buffer of each thread, a directory with fewer
+// entries than fit in it is read with one syscall
+
+#ifndef FLOW_DIRECTORY_WALKER_BUFFER_SIZE
+#define FLOW_DIRECTORY_WALKER_BUFFER_SIZE (size_t) 65536
+#endif
+
+// Size of the captures of the callback of DirectoryWalker::walk(), in pointers
+
+#ifndef FLOW_DIRECTORY_WALKER_CALLBACK_SIZE
+#define FLOW_DIRECTORY_WALKER_CALLBACK_SIZE (size_t) 6
+#endif
+
+namespace flow {
+	enum class FileType {
+		FILE,
+		DIRECTORY,
+		SYMLINK,
+
+		// Devices, sockets and pipes
+		OTHER
+	};
+
+	enum class DirectoryWalkerErrors {
+		OPEN_FAILED
+	};
+
+	/**
+	 *  @brief  An entry found by a DirectoryWalker.
+	 */
+	struct DirectoryEntry {
+		// The path of the root that was walked, followed by the path of
+		// the entry relative to it
+
+		String path;
+		enum FileType type;
+		uint64_t inode;
+	};
+
+	/**
+	 *  @brief  Totals of a walk of a DirectoryWalker.
+	 */
+	struct DirectoryWalkResult {
+		size_t entries;
+		size_t directories;
+
+		// Directories that could not be read, e.g. for lack of permissions,
+		// and entries whose type could not be found
+
+		size_t errors;
+	};
+
+	typedef InplaceFunction<void(DirectoryEntry&),
+		sizeof(void *) * FLOW_DIRECTORY_WALKER_CALLBACK_SIZE> directory_entry_callback_t;
+};
+
+namespace flow_directory_walker_tools {
+	/**
+	 *  @brief  A record returned by getdents64(), glibc does not declare it.
+	 */
+	struct linux_dirent64 {
+		uint64_t d_ino;
+		int64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[];
+	};
+
+	/**
+	 *  @brief  The state of one walk, shared by all of its tasks.
+	 */
+	struct DirectoryWalk {
+		flow::TaskGroup group;
+		flow::directory_entry_callback_t callback;
+
+		std::atomic<size_t> entries = 0;
+		std::atomic<size_t> directories = 0;
+		std::atomic<size_t> errors = 0;
+
+		DirectoryWalk(flow::ThreadPool& pool, flow::directory_entry_callback_t&& callback)
+			: group(pool), callback(std::move(callback)) {}
+	};
+
+	inline bool to_file_type(unsigned char d_type, enum flow::FileType& type)
+	{
+		switch (d_type) {
+			case DT_REG:
+				type = flow::FileType::FILE;
+				return true;
+
+			case DT_DIR:
+				type = flow::FileType::DIRECTORY;
+				return true;
+
+			case DT_LNK:
+				type = flow::FileType::SYMLINK;
+				return true;
+
+			case DT_UNKNOWN:
+				return false;
+
+			default:
+				type = flow::FileType::OTHER;
+				return true;
+		}
+	}
+
+	inline enum flow::FileType mode_to_file_type(mode_t mode)
+	{
+		if (S_ISREG(mode)) return flow::FileType::FILE;
+		if (S_ISDIR(mode)) return flow::FileType::DIRECTORY;
+		if (S_ISLNK(mode)) return flow::FileType::SYMLINK;
+		return flow::FileType::OTHER;
+	}
+
+	inline bool is_dot_or_dot_dot(const char *name)
+	{
+		return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+	}
+
+	inline void scan_directory(DirectoryWalk *walk, int dir_fd, flow::String&& path);
+
+	/**
+	 *  @brief  Opens a subdirectory and scans it, on a worker.
+	 */
+	inline void scan_subdirectory(DirectoryWalk *walk, flow::String&& path)
+	{
+		int fd = ::open(path.to_char_arr(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+
+		if (fd < 0) {
+			walk->errors.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		scan_directory(walk, fd, std::move(path));
+	}
+
+	/**
+	 *  @brief  Reports every entry of an open directory and hands each
+	 *  subdirectory to the TaskGroup of the walk. Closes the directory.
+	 */
+	inline void scan_directory(DirectoryWalk *walk, int dir_fd, flow::String&& path)
+	{
+		using flow::String;
+		using flow::DirectoryEntry;
+
+		// One buffer per thread, reused for every directory it reads
+
+		alignas(linux_dirent64) static thread_local char buf[FLOW_DIRECTORY_WALKER_BUFFER_SIZE];
+
+		walk->directories.fetch_add(1, std::memory_order_relaxed);
+
+		if (path.size() == 0 || path[path.size() - 1] != '/') path += '/';
+		size_t prefix_size = path.size();
+
+		while (true) {
+			long n = ::syscall(SYS_getdents64, dir_fd, buf, FLOW_DIRECTORY_WALKER_BUFFER_SIZE);
+
+			if (n < 0 && errno == EINTR) continue;
+
+			if (n < 0) {
+				walk->errors.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+
+			if (n == 0) break;
+
+			for (long offset = 0; offset < n;) {
+				linux_dirent64 *dirent = (linux_dirent64 *) (buf + offset);
+				offset += dirent->d_reclen;
+
+				if (is_dot_or_dot_dot(dirent->d_name)) continue;
+
+				DirectoryEntry entry;
+
+				// Only file systems that do not fill in d_type cost a stat
+
+				if (!to_file_type(dirent->d_type, entry.type)) {
+					struct stat st;
+
+					if (::fstatat(dir_fd, dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+						walk->errors.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					}
+
+					entry.type = mode_to_file_type(st.st_mode);
+				}
+
+				size_t name_size = strlen(dirent->d_name);
+
+				entry.path = String(prefix_size + name_size);
+				memcpy(entry.path.data(), path.data(), prefix_size);
+				memcpy(entry.path.data() + prefix_size, dirent->d_name, name_size);
+				entry.path.unsafe_set_element_count(prefix_size + name_size);
+				entry.inode = dirent->d_ino;
+
+				// The callback may take the path, keep a copy to descend into
+
+				if (entry.type == flow::FileType::DIRECTORY) {
+					walk->group.run([walk, subdirectory = entry.path]() mutable {
+						flow::ArenaScope heap_scope(NULL);
+						scan_subdirectory(walk, std::move(subdirectory));
+					});
+				}
+
+				walk->entries.fetch_add(1, std::memory_order_relaxed);
+				walk->callback(entry);
+			}
+		}
+
+		::close(dir_fd);
+	}
+};
+
+namespace flow {
+	using namespace flow_directory_walker_tools;
+
+	/**
+	 *  @brief  Walks a directory tree recursively on a ThreadPool, for
+	 *  indexing large trees at startup. Directories are read with
+	 *  getdents64() into a large buffer, so most take one syscall, and the
+	 *  type of an entry is taken from d_type, so no stat() is needed unless
+	 *  the file system does not report it. Every subdirectory becomes a
+	 *  task of the pool, so the walk scales with the number of workers
+	 *  instead of being bound by the latency of each syscall.
+	 *  Symbolic links are reported but not followed.
+	 */
+	class DirectoryWalker {
+		private:
+			ThreadPool& pool;
+
+		public:
+			/**
+			 *  @brief  Creates a DirectoryWalker.
+			 *  @param  pool  The pool that reads the directories, must outlive
+			 *  the DirectoryWalker.
+			 */
+			DirectoryWalker(ThreadPool& pool) : pool(pool) {}
+
+			/**
+			 *  @brief  Walks a directory tree and returns once every entry
+			 *  under it was reported. The calling thread helps the workers.
+			 *  Throws DirectoryWalkerErrors::OPEN_FAILED if the root cannot
+			 *  be opened, subdirectories that cannot be opened are counted
+			 *  as errors and skipped.
+			 *  @param  root  The path of the directory, it is not reported.
+			 *  @param  callback  Called for every entry below the root, in no
+			 *  particular order, concurrently from the workers, so it must be
+			 *  thread safe. It may move the path out of the entry. Runs
+			 *  with the heap as the ArenaScope.
+			 *  @returns  The totals of the walk.
+			 *  @note  Runtime: O(n / t), n = the number of entries,
+			 *  t = the number of workers, for trees that are not too narrow
+			 *  @note  Memory: O(d), d = the number of directories waiting to
+			 *  be read
+			 */
+			DirectoryWalkResult walk(const String& root, directory_entry_callback_t&& callback)
+			{
+				// Paths are extended by the workers, keep them off the arena
+
+				ArenaScope heap_scope(NULL);
+				String root_path = root;
+
+				int fd = ::open(root_path.to_char_arr(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				if (fd < 0) throw DirectoryWalkerErrors::OPEN_FAILED;
+
+				DirectoryWalk walk(pool, std::move(callback));
+
+				walk.group.run([walk = &walk, fd, root_path = std::move(root_path)]() mutable {
+					ArenaScope heap_scope(NULL);
+					scan_directory(walk, fd, std::move(root_path));
+				});
+
+				walk.group.wait();
+
+				return DirectoryWalkResult {
+					walk.entries.load(std::memory_order_relaxed),
+					walk.directories.load(std::memory_order_relaxed),
+					walk.errors.load(std::memory_order_relaxed)
+				};
+			}
+
+			/**
+			 *  @brief  Walks a directory tree and writes every entry to a
+			 *  Stream, one at a time, so listeners need not be thread safe.
+			 *  They are called from the workers. Ends the stream once the
+			 *  walk is done. See the callback variant.
+			 *  @param  root  The path of the directory, it is not reported.
+			 *  @param  stream  The stream, it must have been started.
+			 *  @returns  The totals of the walk.
+			 */
+			DirectoryWalkResult walk(const String& root, Stream<DirectoryEntry&>& stream)
+			{
+				std::mutex mutex;
+
+				DirectoryWalkResult result = walk(root, [&stream, &mutex](DirectoryEntry& entry) {
+					std::lock_guard<std::mutex> lock(mutex);
+					stream.write(entry);
+				});
+
+				stream.end();
+				return result;
+			}
+	};
+};
+
+#endif
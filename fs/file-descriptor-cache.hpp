@@ -0,0 +1,269 @@
+#ifndef FLOW_FILE_DESCRIPTOR_CACHE_HEADER
+#define FLOW_FILE_DESCRIPTOR_CACHE_HEADER
+
+#include <bits/stdc++.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file-stream.hpp"
+#include "../data-structures/string.hpp"
+#include "../memory/arena.hpp"
+
+namespace flow {
+	class FileDescriptorCache;
+};
+
+namespace flow_file_descriptor_cache_tools {
+	/**
+	 *  @brief  An open file of a FileDescriptorCache, and the number of
+	 *  SharedFileDescriptors that use it.
+	 */
+	struct CachedFile {
+		int fd;
+		size_t size;
+		size_t ref_count;
+		flow::String path;
+
+		// Identity of the file when it was opened, to notice it changed
+
+		dev_t device;
+		ino_t inode;
+		struct timespec modified;
+
+		/**
+		 *  @brief  Returns whether a stat() of the path still describes
+		 *  the file that was opened.
+		 */
+		bool matches(const struct stat& file_stat) const
+		{
+			return file_stat.st_dev == device && file_stat.st_ino == inode
+				&& (size_t) file_stat.st_size == size
+				&& file_stat.st_mtim.tv_sec == modified.tv_sec
+				&& file_stat.st_mtim.tv_nsec == modified.tv_nsec;
+		}
+	};
+};
+
+namespace flow {
+	using namespace flow_file_descriptor_cache_tools;
+
+	/**
+	 *  @brief  A reference to a file opened read-only by a
+	 *  FileDescriptorCache. The file is closed when the last reference to
+	 *  it goes away. Reads should be positional, with pread(), because the
+	 *  descriptor and its file offset are shared.
+	 */
+	class SharedFileDescriptor {
+		private:
+			FileDescriptorCache *cache = NULL;
+			CachedFile *file = NULL;
+
+			friend class FileDescriptorCache;
+
+			SharedFileDescriptor(FileDescriptorCache *cache, CachedFile *file)
+				: cache(cache), file(file) {}
+
+			void release();
+
+		public:
+			/**
+			 *  @brief  Creates a SharedFileDescriptor that refers to no file.
+			 */
+			SharedFileDescriptor() {}
+
+			SharedFileDescriptor(const SharedFileDescriptor& other);
+			SharedFileDescriptor& operator=(const SharedFileDescriptor& other);
+
+			SharedFileDescriptor(SharedFileDescriptor&& other) noexcept
+				: cache(other.cache), file(other.file)
+			{
+				other.cache = NULL;
+				other.file = NULL;
+			}
+
+			SharedFileDescriptor& operator=(SharedFileDescriptor&& other)
+			{
+				if (this == &other) return *this;
+
+				release();
+				cache = other.cache;
+				file = other.file;
+				other.cache = NULL;
+				other.file = NULL;
+
+				return *this;
+			}
+
+			~SharedFileDescriptor()
+			{
+				release();
+			}
+
+			/**
+			 *  @brief  Returns the file descriptor, or -1 if there is no file.
+			 */
+			int fd() const
+			{
+				return file == NULL ? -1 : file->fd;
+			}
+
+			/**
+			 *  @brief  Returns the size of the file when it was opened.
+			 */
+			size_t size() const
+			{
+				return file == NULL ? 0 : file->size;
+			}
+
+			explicit operator bool() const
+			{
+				return file != NULL;
+			}
+	};
+
+	/**
+	 *  @brief  Shares read-only file descriptors between all readers of the
+	 *  same path, so many concurrent responses of one file use a single
+	 *  descriptor. A file stays open while a SharedFileDescriptor refers to
+	 *  it. A file that was replaced or modified since it was opened is
+	 *  opened again for new readers, those of the old one keep reading it.
+	 *  All methods are thread safe.
+	 */
+	class FileDescriptorCache {
+		private:
+			std::mutex mutex;
+			std::unordered_map<String, CachedFile *> files;
+
+			friend class SharedFileDescriptor;
+
+			void retain(CachedFile *file)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				file->ref_count++;
+			}
+
+			void release(CachedFile *file)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (--file->ref_count != 0) return;
+
+					// A file that changed was already replaced by a new one
+
+					auto it = files.find(file->path);
+					if (it != files.end() && it->second == file) files.erase(it);
+				}
+
+				::close(file->fd);
+				delete file;
+			}
+
+		public:
+			FileDescriptorCache() {}
+
+			FileDescriptorCache(const FileDescriptorCache& other) = delete;
+			FileDescriptorCache& operator=(const FileDescriptorCache& other) = delete;
+
+			/**
+			 *  @brief  Returns a reference to an open file, opening it if no
+			 *  reference to it exists or the file changed since it was
+			 *  opened, i.e. its inode, size or modification time differ.
+			 *  Throws FileErrors::DOES_NOT_EXIST if the file cannot be opened.
+			 *  @param  path  The path of the file.
+			 *  @note  Runtime: O(1) on average, plus stat(), and open() and
+			 *  fstat() if the file was not open or changed
+			 */
+			SharedFileDescriptor open(const String& path)
+			{
+				// Cached files outlive the Arena of the request that opened them
+
+				ArenaScope heap_scope(NULL);
+
+				String path_str = path;
+				struct stat file_stat;
+				bool exists = ::stat(path_str.to_char_arr(), &file_stat) == 0;
+
+				std::lock_guard<std::mutex> lock(mutex);
+
+				auto it = files.find(path_str);
+
+				if (it != files.end()) {
+					if (exists && it->second->matches(file_stat)) {
+						it->second->ref_count++;
+						return SharedFileDescriptor(this, it->second);
+					}
+
+					// The file changed, its readers keep the old descriptor,
+					// which is closed once the last of them is done
+
+					files.erase(it);
+				}
+
+				int fd = ::open(path_str.to_char_arr(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0) throw FileErrors::DOES_NOT_EXIST;
+
+				if (::fstat(fd, &file_stat) < 0) {
+					::close(fd);
+					throw FileErrors::DOES_NOT_EXIST;
+				}
+
+				CachedFile *file = new CachedFile {
+					fd, (size_t) file_stat.st_size, 1, path_str,
+					file_stat.st_dev, file_stat.st_ino, file_stat.st_mtim
+				};
+
+				files[path_str] = file;
+
+				return SharedFileDescriptor(this, file);
+			}
+
+			/**
+			 *  @brief  Returns the number of open files.
+			 */
+			size_t size()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				return files.size();
+			}
+	};
+
+	inline void SharedFileDescriptor::release()
+	{
+		if (file != NULL) cache->release(file);
+
+		cache = NULL;
+		file = NULL;
+	}
+
+	inline SharedFileDescriptor::SharedFileDescriptor(const SharedFileDescriptor& other)
+		: cache(other.cache), file(other.file)
+	{
+		if (file != NULL) cache->retain(file);
+	}
+
+	inline SharedFileDescriptor& SharedFileDescriptor::operator=(
+		const SharedFileDescriptor& other
+	) {
+		if (this == &other) return *this;
+
+		if (other.file != NULL) other.cache->retain(other.file);
+		release();
+
+		cache = other.cache;
+		file = other.file;
+
+		return *this;
+	}
+
+	/**
+	 *  @brief  Returns the FileDescriptorCache shared by the whole process.
+	 */
+	inline FileDescriptorCache& default_file_descriptor_cache()
+	{
+		static FileDescriptorCache cache;
+		return cache;
+	}
+};
+
+#endif
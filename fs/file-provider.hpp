@@ -2,23 +2,98 @@
 #define FLOW_FILE_PROVIDER_HEADER
 
 #include <bits/stdc++.h>
+#include <unistd.h>
 
 #include "../data-structures/content-provider.hpp"
 #include "file-stream.hpp"
+#include "file-descriptor-cache.hpp"
 
 namespace flow {
-	class FileProvider : public FileReadStream, public ContentProvider {
+	/**
+	 *  @brief  Provides a file, or a range of it, with positional reads.
+	 *  Any offset can be read at any time, so chunks can be retried and
+	 *  providers of the same file can run concurrently. The descriptor comes
+	 *  from a FileDescriptorCache, so all providers of one file share it.
+	 */
+	class FileProvider : public ContentProvider {
+		private:
+			SharedFileDescriptor file;
+
+			// Offset of the provided range in the file
+
+			size_t range_offset;
+
 		public:
-			FileProvider(const char *file_name)
-				: FileReadStream(file_name),
-					ContentProvider(FileReadStream::size()) {}
+			/**
+			 *  @brief  Creates a FileProvider of a whole file.
+			 *  Throws FileErrors::DOES_NOT_EXIST if it cannot be opened.
+			 *  @param  file_name  The path of the file.
+			 *  @param  cache  The cache the file is opened through.
+			 */
+			FileProvider(
+				const String& file_name,
+				FileDescriptorCache& cache = default_file_descriptor_cache()
+			) : ContentProvider(0), file(cache.open(file_name)), range_offset(0)
+			{
+				size = file.size();
+			}
+
+			/**
+			 *  @brief  Creates a FileProvider of a range of a file,
+			 *  e.g. for a Range request. The range is clamped to the file.
+			 *  @param  file_name  The path of the file.
+			 *  @param  offset  The offset of the first byte of the range.
+			 *  @param  length  The length of the range.
+			 *  @param  cache  The cache the file is opened through.
+			 */
+			FileProvider(
+				const String& file_name,
+				size_t offset,
+				size_t length,
+				FileDescriptorCache& cache = default_file_descriptor_cache()
+			) : ContentProvider(0), file(cache.open(file_name))
+			{
+				range_offset = std::min(offset, file.size());
+				size = std::min(length, file.size() - range_offset);
+			}
 
+			/**
+			 *  @brief  Reads a chunk at an offset of the range with pread(),
+			 *  the shared descriptor is never seeked. Throws
+			 *  FileErrors::READ_FAILED if the read fails.
+			 *  @param  offset  The offset in the range.
+			 *  @param  desired_size  The maximum size of the chunk. The chunk
+			 *  is shorter at the end of the range, and empty if the file was
+			 *  truncated.
+			 */
 			String next_chunk(size_t offset, size_t desired_size)
 			{
-				return read(desired_size);
+				if (offset >= size) return String();
+
+				size_t chunk_size = std::min(desired_size, size - offset);
+				String chunk(chunk_size);
+				size_t bytes_read = 0;
+
+				// pread() may return less than asked, only 0 means end of file
+
+				while (bytes_read < chunk_size) {
+					ssize_t n = ::pread(file.fd(), chunk.data() + bytes_read,
+						chunk_size - bytes_read, range_offset + offset + bytes_read);
+
+					if (n < 0) {
+						if (errno == EINTR) continue;
+						throw FileErrors::READ_FAILED;
+					}
+
+					if (n == 0) break;
+					bytes_read += n;
+				}
+
+				chunk.unsafe_set_element_count(bytes_read);
+				return chunk;
 			}
 	};
 };
 
 
-#endif
\ No newline at end of file
+#endif
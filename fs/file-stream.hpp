@@ -7,10 +7,11 @@
 #include "../data-structures/stream.hpp"
 #include <cstdio>
 #include <cstdlib>
+#include <sys/stat.h>
 
 namespace flow_file_tools {
 	enum class FileMode { READ, WRITE, APPEND };
-	enum class FileErrors { DOES_NOT_EXIST };
+	enum class FileErrors { DOES_NOT_EXIST, READ_FAILED, WRITE_FAILED };
 };
 
 namespace flow {
@@ -97,6 +98,14 @@ namespace flow {
 			 */
 			size_t size()
 			{
+				// Nothing is buffered for writing in a read stream,
+				// so the size on disk is the size, without seeking
+
+				if constexpr (Mode == FileMode::READ) {
+					struct stat file_stat;
+					if (fstat(fileno(file), &file_stat) == 0) return file_stat.st_size;
+				}
+
 				// Save current file pointer location
 
 				size_t current_offset = std::ftell(file);
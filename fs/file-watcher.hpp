@@ -0,0 +1,295 @@
+#ifndef FLOW_FILE_WATCHER_HEADER
+#define FLOW_FILE_WATCHER_HEADER
+
+#include <bits/stdc++.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "../data-structures/string.hpp"
+#include "../events/event_emitter.hpp"
+#include "../memory/arena.hpp"
+#include "../memory/shared-pointer.hpp"
+#include "../networking/socket-server.hpp"
+
+// Time changes are collected for before they are reported
+
+#ifndef FLOW_FILE_WATCHER_COALESCE_MS
+#define FLOW_FILE_WATCHER_COALESCE_MS (size_t) 50
+#endif
+
+namespace flow {
+	class FileWatcher;
+
+	/**
+	 *  @brief  A change to a watched path, as reported by a FileWatcher.
+	 */
+	enum class FileChange {
+		CREATED,
+		MODIFIED,
+		DELETED,
+
+		// Events were lost, everything that is watched should be rescanned.
+		// Reported with an empty path
+
+		OVERFLOW
+	};
+
+	enum class FileWatcherErrors {
+		INIT_FAILED,
+		WATCH_FAILED
+	};
+};
+
+namespace flow_file_watcher_tools {
+	/**
+	 *  @brief  Lets a pending flush of a FileWatcher find out whether the
+	 *  watcher still exists, timers of the SocketServer cannot be cancelled.
+	 */
+	struct FlushToken : public flow::RefCounted<false> {
+		flow::FileWatcher *watcher;
+
+		FlushToken(flow::FileWatcher *watcher) : watcher(watcher) {}
+	};
+
+	/**
+	 *  @brief  Returns the change a path went through over two consecutive
+	 *  changes, e.g. a file that is created and then written to was
+	 *  created, a file that is deleted and created again was modified.
+	 */
+	inline enum flow::FileChange merge_changes(
+		enum flow::FileChange first,
+		enum flow::FileChange second
+	) {
+		using flow::FileChange;
+
+		if (second == FileChange::DELETED) return FileChange::DELETED;
+		if (first == FileChange::CREATED) return FileChange::CREATED;
+		if (first == FileChange::DELETED) return FileChange::MODIFIED;
+
+		return second;
+	}
+
+	constexpr uint32_t FILE_WATCHER_DEFAULT_MASK = IN_CREATE | IN_MODIFY | IN_DELETE
+		| IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+};
+
+namespace flow {
+	using namespace flow_file_watcher_tools;
+
+	/**
+	 *  @brief  Watches files and directories for changes with inotify, so
+	 *  caches and configuration can be invalidated when something changes
+	 *  instead of polling the file system. The inotify descriptor is
+	 *  watched by the loop of a SocketServer. Changes are collected for
+	 *  FLOW_FILE_WATCHER_COALESCE_MS, and each changed path is reported
+	 *  once, through change_event, on the server loop.
+	 *  A change of a file in a watched directory is reported with the path
+	 *  of the file, directories are not watched recursively.
+	 *  Must be created and used on the thread of the server loop.
+	 */
+	class FileWatcher {
+		private:
+			SocketServer& server;
+			int inotify_fd;
+
+			// Watched paths by watch descriptor
+
+			std::unordered_map<int, String> watched_paths;
+
+			// Changes since the last flush, in the order the paths changed
+
+			std::unordered_map<String, FileChange> pending;
+			DynamicArray<String> pending_order;
+			bool overflowed = false;
+
+			IntrusivePointer<FlushToken> flush_token;
+			bool flush_scheduled = false;
+
+			static bool to_change(uint32_t mask, FileChange& change)
+			{
+				if (mask & (IN_CREATE | IN_MOVED_TO)) change = FileChange::CREATED;
+				else if (mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF))
+					change = FileChange::DELETED;
+				else if (mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB))
+					change = FileChange::MODIFIED;
+				else return false;
+
+				return true;
+			}
+
+			void add_pending(const String& path, FileChange change)
+			{
+				auto it = pending.find(path);
+
+				if (it == pending.end()) {
+					pending[path] = change;
+					pending_order.append(path);
+					return;
+				}
+
+				it->second = merge_changes(it->second, change);
+			}
+
+			/**
+			 *  @brief  Reads all queued inotify events.
+			 */
+			void read_events()
+			{
+				ArenaScope heap_scope(NULL);
+				alignas(struct inotify_event) char buf[4096];
+
+				while (true) {
+					ssize_t n = ::read(inotify_fd, buf, sizeof(buf));
+
+					if (n < 0 && errno == EINTR) continue;
+					if (n <= 0) break;
+
+					for (ssize_t offset = 0; offset < n;) {
+						struct inotify_event *event = (struct inotify_event *) (buf + offset);
+						offset += sizeof(struct inotify_event) + event->len;
+
+						handle_event(*event);
+					}
+				}
+
+				schedule_flush();
+			}
+
+			void handle_event(const struct inotify_event& event)
+			{
+				if (event.mask & IN_Q_OVERFLOW) {
+					overflowed = true;
+					return;
+				}
+
+				auto it = watched_paths.find(event.wd);
+				if (it == watched_paths.end()) return;
+
+				FileChange change;
+
+				if (to_change(event.mask, change)) {
+					if (event.len == 0) {
+						add_pending(it->second, change);
+					} else {
+						String path = it->second;
+						path += '/';
+						path += String(event.name);
+						add_pending(path, change);
+					}
+				}
+
+				// The watch is gone, e.g. because the path was deleted
+
+				if (event.mask & IN_IGNORED) watched_paths.erase(it);
+			}
+
+			void schedule_flush()
+			{
+				if (flush_scheduled || (pending_order.size() == 0 && !overflowed)) return;
+
+				flush_scheduled = true;
+
+				server.set_timeout(std::chrono::milliseconds(FLOW_FILE_WATCHER_COALESCE_MS),
+					[token = flush_token]()
+				{
+					if (token->watcher != NULL) token->watcher->flush();
+				});
+			}
+
+		public:
+			EventEmitter<const String&, FileChange> change_event;
+
+			/**
+			 *  @brief  Creates a FileWatcher whose events are read by the loop
+			 *  of a SocketServer. Throws FileWatcherErrors::INIT_FAILED if
+			 *  inotify is not available.
+			 *  @param  server  The server, must outlive the FileWatcher.
+			 */
+			FileWatcher(SocketServer& server)
+				: server(server), flush_token(new FlushToken(this))
+			{
+				inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+				if (inotify_fd < 0) throw FileWatcherErrors::INIT_FAILED;
+
+				server.add_watch(inotify_fd, [this]() { read_events(); });
+			}
+
+			FileWatcher(const FileWatcher& other) = delete;
+			FileWatcher& operator=(const FileWatcher& other) = delete;
+
+			/**
+			 *  @brief  Stops watching. Pending changes are not reported.
+			 */
+			~FileWatcher()
+			{
+				flush_token->watcher = NULL;
+				server.remove_watch(inotify_fd);
+				::close(inotify_fd);
+			}
+
+			/**
+			 *  @brief  Starts watching a file or directory.
+			 *  Throws FileWatcherErrors::WATCH_FAILED if it cannot be watched,
+			 *  e.g. because it does not exist.
+			 *  @param  path  The path, changes are reported with paths that
+			 *  start with it.
+			 *  @param  mask  The inotify events to watch for.
+			 */
+			void watch(const String& path, uint32_t mask = FILE_WATCHER_DEFAULT_MASK)
+			{
+				// Paths live as long as the watcher, not a request
+
+				ArenaScope heap_scope(NULL);
+				String path_str = path;
+
+				int wd = ::inotify_add_watch(inotify_fd, path_str.to_char_arr(), mask);
+				if (wd < 0) throw FileWatcherErrors::WATCH_FAILED;
+
+				watched_paths[wd] = path_str;
+			}
+
+			/**
+			 *  @brief  Stops watching a file or directory.
+			 *  @returns  Whether it was watched.
+			 */
+			bool unwatch(const String& path)
+			{
+				for (auto it = watched_paths.begin(); it != watched_paths.end(); it++) {
+					if (it->second != path) continue;
+
+					::inotify_rm_watch(inotify_fd, it->first);
+					watched_paths.erase(it);
+					return true;
+				}
+
+				return false;
+			}
+
+			/**
+			 *  @brief  Reports the changes collected so far through
+			 *  change_event. Called by the coalescing timer.
+			 */
+			void flush()
+			{
+				flush_scheduled = false;
+
+				// Listeners may watch or unwatch, report from a snapshot
+
+				std::unordered_map<String, FileChange> changes = std::move(pending);
+				DynamicArray<String> order = std::move(pending_order);
+				bool lost = overflowed;
+
+				pending.clear();
+				pending_order = DynamicArray<String>();
+				overflowed = false;
+
+				if (lost) change_event.trigger(String(), FileChange::OVERFLOW);
+
+				for (size_t i = 0; i < order.size(); i++) {
+					change_event.trigger(order[i], changes[order[i]]);
+				}
+			}
+	};
+};
+
+#endif
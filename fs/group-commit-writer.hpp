@@ -0,0 +1,364 @@
+#ifndef FLOW_GROUP_COMMIT_WRITER_HEADER
+#define FLOW_GROUP_COMMIT_WRITER_HEADER
+
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file-stream.hpp"
+#include "../concurrency/future.hpp"
+#include "../data-structures/queue.hpp"
+#include "../data-structures/stream.hpp"
+#include "../data-structures/string.hpp"
+#include "../memory/arena.hpp"
+
+// Initial capacity of each of the two staging buffers
+
+#ifndef FLOW_GROUP_COMMIT_BUFFER_SIZE
+#define FLOW_GROUP_COMMIT_BUFFER_SIZE (size_t) (1 << 20)
+#endif
+
+// Maximum time staged data waits before it is written to the file
+
+#ifndef FLOW_GROUP_COMMIT_FLUSH_INTERVAL_MS
+#define FLOW_GROUP_COMMIT_FLUSH_INTERVAL_MS (size_t) 10
+#endif
+
+namespace flow_group_commit_writer_tools {
+	enum class FsyncPolicies {
+		// Only sync() makes data durable
+
+		NONE,
+
+		// Data is made durable at most amount milliseconds after it is written
+
+		INTERVAL,
+
+		// Data is made durable once amount bytes are not durable yet
+
+		BYTES
+	};
+
+	/**
+	 *  @brief  When a GroupCommitWriter makes written data durable with
+	 *  fdatasync(), besides when sync() asks for it.
+	 */
+	struct FsyncPolicy {
+		enum FsyncPolicies kind;
+		size_t amount;
+
+		static FsyncPolicy none()
+		{
+			return FsyncPolicy { FsyncPolicies::NONE, 0 };
+		}
+
+		static FsyncPolicy every_ms(size_t ms)
+		{
+			return FsyncPolicy { FsyncPolicies::INTERVAL, ms };
+		}
+
+		static FsyncPolicy every_bytes(size_t bytes)
+		{
+			return FsyncPolicy { FsyncPolicies::BYTES, bytes };
+		}
+	};
+
+	/**
+	 *  @brief  A sync() waiting until the file is durable up to an offset.
+	 */
+	struct SyncRequest {
+		uint64_t offset;
+		flow::Promise<void> promise;
+	};
+};
+
+namespace flow {
+	using namespace flow_group_commit_writer_tools;
+
+	/**
+	 *  @brief  Appends to a file from any thread without blocking on the
+	 *  disk. Writes are copied into a staging buffer, a background thread
+	 *  swaps it with a second buffer and writes that one to the file while
+	 *  new writes fill the first. The staging buffer grows instead of
+	 *  waiting when the disk falls behind.
+	 *  Durability follows an FsyncPolicy, and sync() returns a Future that
+	 *  is made ready once everything written before it is on disk. Syncs
+	 *  that are requested together are served by one fdatasync(), a group
+	 *  commit. Like a FileAppendStream, Strings written to write_stream are
+	 *  appended too.
+	 *  Continuations of sync() run on the background thread, use
+	 *  Future::then(executor, fn) to get back to the loop.
+	 */
+	class GroupCommitWriter {
+		private:
+			int fd;
+			FsyncPolicy policy;
+
+			// Guards staging, appended, sync_requests, flush_requested and stopping
+
+			std::mutex mutex;
+			std::condition_variable wake_flusher;
+
+			String staging;
+			uint64_t appended = 0;
+			Queue<SyncRequest> sync_requests;
+			bool flush_requested = false;
+			bool stopping = false;
+
+			// Only used by the background thread
+
+			String flushing;
+			uint64_t written = 0;
+			uint64_t synced = 0;
+			std::chrono::steady_clock::time_point last_sync;
+
+			// The errno of the first failed write or fdatasync(), 0 if none failed
+
+			std::atomic<int> error = 0;
+
+			std::thread flusher;
+
+			void write_all(const String& data)
+			{
+				size_t offset = 0;
+
+				while (offset < data.size()) {
+					ssize_t n = ::write(fd, data.data() + offset, data.size() - offset);
+
+					if (n < 0) {
+						if (errno == EINTR) continue;
+
+						int no_error = 0;
+						error.compare_exchange_strong(no_error, errno);
+						return;
+					}
+
+					offset += n;
+				}
+			}
+
+			bool should_sync(bool sync_requested, bool stop)
+			{
+				if (written == synced) return false;
+				if (sync_requested) return true;
+
+				switch (policy.kind) {
+					default:
+					case FsyncPolicies::NONE:
+						return false;
+
+					case FsyncPolicies::INTERVAL:
+						return stop || std::chrono::steady_clock::now() - last_sync
+							>= std::chrono::milliseconds(policy.amount);
+
+					case FsyncPolicies::BYTES:
+						return stop || written - synced >= policy.amount;
+				}
+			}
+
+			void flush_loop()
+			{
+				ArenaScope heap_scope(NULL);
+				last_sync = std::chrono::steady_clock::now();
+
+				while (true) {
+					bool stop;
+					bool sync_requested;
+
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+
+						wake_flusher.wait_for(lock,
+							std::chrono::milliseconds(FLOW_GROUP_COMMIT_FLUSH_INTERVAL_MS),
+							[this]() { return stopping || flush_requested; });
+
+						std::swap(staging, flushing);
+						written = appended;
+						stop = stopping;
+						sync_requested = sync_requests.size() != 0;
+						flush_requested = false;
+					}
+
+					write_all(flushing);
+					flushing.unsafe_set_element_count(0);
+
+					if (should_sync(sync_requested, stop)) {
+						if (::fdatasync(fd) < 0) {
+							int no_error = 0;
+							error.compare_exchange_strong(no_error, errno);
+						}
+
+						synced = written;
+						last_sync = std::chrono::steady_clock::now();
+					}
+
+					complete_sync_requests();
+
+					if (stop) return;
+				}
+			}
+
+			/**
+			 *  @brief  Makes the Futures of the sync() calls that are covered
+			 *  by the last fdatasync() ready, outside the lock, so their
+			 *  continuations may write again.
+			 */
+			void complete_sync_requests()
+			{
+				Queue<SyncRequest> completed;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					while (sync_requests.size() != 0
+						&& sync_requests.front().offset <= synced) {
+						completed.push(sync_requests.pop());
+					}
+				}
+
+				while (completed.size() != 0) {
+					SyncRequest request = completed.pop();
+
+					if (error != 0) {
+						request.promise.set_exception(
+							std::make_exception_ptr(FileErrors::WRITE_FAILED));
+					} else {
+						request.promise.set_value();
+					}
+				}
+			}
+
+		public:
+			Stream<String&> write_stream;
+
+			/**
+			 *  @brief  Opens a file for appending, creating it if it does
+			 *  not exist, and starts the background thread.
+			 *  Throws FileErrors::DOES_NOT_EXIST if it cannot be opened.
+			 *  @param  file_path  The path of the file.
+			 *  @param  policy  When written data is made durable.
+			 */
+			GroupCommitWriter(const char *file_path, FsyncPolicy policy = FsyncPolicy::none())
+				: policy(policy),
+
+				// The buffers and sync requests live as long as the
+				// writer, not a request, so they are kept off its Arena
+
+				staging(on_heap<String>(FLOW_GROUP_COMMIT_BUFFER_SIZE)),
+				sync_requests(on_heap<Queue<SyncRequest>>()),
+				flushing(on_heap<String>(FLOW_GROUP_COMMIT_BUFFER_SIZE))
+			{
+				fd = ::open(file_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+				if (fd < 0) throw FileErrors::DOES_NOT_EXIST;
+
+				write_stream.on_data([this](String& str) {
+					write(str.data(), str.size());
+				});
+
+				write_stream.start();
+
+				flusher = std::thread([this]() { flush_loop(); });
+			}
+
+			/**
+			 *  @brief  Opens a file for appending.
+			 */
+			GroupCommitWriter(String& file_path, FsyncPolicy policy = FsyncPolicy::none())
+				: GroupCommitWriter(file_path.to_char_arr(), policy) {}
+
+			GroupCommitWriter(const GroupCommitWriter& other) = delete;
+			GroupCommitWriter& operator=(const GroupCommitWriter& other) = delete;
+
+			/**
+			 *  @brief  Writes everything that was staged, makes it durable
+			 *  unless the FsyncPolicy is none, and closes the file.
+			 */
+			~GroupCommitWriter()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+
+				wake_flusher.notify_one();
+				flusher.join();
+
+				::close(fd);
+			}
+
+			/**
+			 *  @brief  Appends data to the file. Only copies it into the
+			 *  staging buffer, the background thread writes it.
+			 *  @param  data  A pointer to the data.
+			 *  @param  size  The size of the data.
+			 *  @note  Runtime: O(size), plus a resize of the staging buffer
+			 *  if the disk falls behind
+			 *  @note  Memory: O(1) amortised
+			 */
+			void write(const char *data, size_t size)
+			{
+				if (size == 0) return;
+
+				bool half_full;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					staging.reserve(size);
+					memcpy(staging.data() + staging.size(), data, size);
+					staging.unsafe_increment_element_count(size);
+					appended += size;
+
+					// Do not wait for the flush interval when staging fills up
+
+					half_full = staging.size() >= FLOW_GROUP_COMMIT_BUFFER_SIZE / 2
+						&& !flush_requested;
+					if (half_full) flush_requested = true;
+				}
+
+				if (half_full) wake_flusher.notify_one();
+			}
+
+			/**
+			 *  @brief  Appends a String to the file.
+			 */
+			void write(const String& str)
+			{
+				write(str.data(), str.size());
+			}
+
+			/**
+			 *  @brief  Requests that everything written so far is made durable.
+			 *  All requests that are pending when the background thread
+			 *  gets to them share one fdatasync().
+			 *  @returns  A Future that is made ready once the data is on disk.
+			 *  It fails with FileErrors::WRITE_FAILED if a write or
+			 *  fdatasync() failed.
+			 */
+			Future<void> sync()
+			{
+				Promise<void> promise;
+				Future<void> future = promise.get_future();
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					sync_requests.push(SyncRequest { appended, std::move(promise) });
+					flush_requested = true;
+				}
+
+				wake_flusher.notify_one();
+				return future;
+			}
+
+			/**
+			 *  @brief  Returns the errno of the first failed write or
+			 *  fdatasync(), 0 if none failed.
+			 */
+			int last_error() const
+			{
+				return error;
+			}
+	};
+};
+
+#endif
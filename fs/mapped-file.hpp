@@ -0,0 +1,245 @@
+#ifndef FLOW_MAPPED_FILE_HEADER
+#define FLOW_MAPPED_FILE_HEADER
+
+#include <bits/stdc++.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file-stream.hpp"
+#include "../data-structures/string.hpp"
+#include "../data-structures/string-view.hpp"
+#include "../data-structures/stream.hpp"
+
+namespace flow_mapped_file_tools {
+	/**
+	 *  @brief  Hints about how a MappedFile will be accessed,
+	 *  passed on to madvise().
+	 */
+	enum class MappedFileAdvice {
+		NORMAL,
+		SEQUENTIAL,
+		RANDOM,
+		WILLNEED,
+		DONTNEED,
+		HUGEPAGE
+	};
+
+	inline int to_madvise_flag(enum MappedFileAdvice advice)
+	{
+		switch (advice) {
+			default:
+			case MappedFileAdvice::NORMAL: return MADV_NORMAL;
+			case MappedFileAdvice::SEQUENTIAL: return MADV_SEQUENTIAL;
+			case MappedFileAdvice::RANDOM: return MADV_RANDOM;
+			case MappedFileAdvice::WILLNEED: return MADV_WILLNEED;
+			case MappedFileAdvice::DONTNEED: return MADV_DONTNEED;
+			case MappedFileAdvice::HUGEPAGE: return MADV_HUGEPAGE;
+		}
+	}
+};
+
+namespace flow {
+	using namespace flow_mapped_file_tools;
+
+	enum class MappedFileErrors {
+		MAPPING_FAILED,
+		OUT_OF_RANGE,
+		INVALID_CHUNK_SIZE
+	};
+
+	/**
+	 *  @brief  A file mapped read-only into memory. Its contents are
+	 *  handed out as StringViews of the mapping, so reading a file, however
+	 *  big, does not copy it and does not allocate. Pages are read in by
+	 *  the kernel on first access, advise() tells it what to expect.
+	 *  Like a FileReadStream, chunks can be read one by one from a cursor,
+	 *  each chunk is also written to read_stream.
+	 *  Views must not outlive the MappedFile.
+	 */
+	class MappedFile {
+		private:
+			char *mapping = NULL;
+			size_t length = 0;
+
+			// Offset of the next chunk to read
+
+			size_t cursor = 0;
+
+		public:
+			Stream<StringView&> read_stream;
+
+			/**
+			 *  @brief  Maps a file. Throws FileErrors::DOES_NOT_EXIST if it
+			 *  cannot be opened, MappedFileErrors::MAPPING_FAILED if it cannot
+			 *  be mapped.
+			 *  @param  file_path  The path of the file.
+			 */
+			MappedFile(const char *file_path)
+			{
+				int fd = ::open(file_path, O_RDONLY | O_CLOEXEC);
+				if (fd < 0) throw FileErrors::DOES_NOT_EXIST;
+
+				struct stat file_stat;
+
+				if (::fstat(fd, &file_stat) < 0) {
+					::close(fd);
+					throw MappedFileErrors::MAPPING_FAILED;
+				}
+
+				length = file_stat.st_size;
+
+				// An empty file cannot be mapped, it is an empty view instead
+
+				if (length != 0) {
+					void *ptr = ::mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+					if (ptr == MAP_FAILED) {
+						::close(fd);
+						throw MappedFileErrors::MAPPING_FAILED;
+					}
+
+					mapping = (char *) ptr;
+				}
+
+				// The mapping keeps the file alive
+
+				::close(fd);
+				read_stream.start();
+			}
+
+			/**
+			 *  @brief  Maps a file.
+			 */
+			MappedFile(String& file_path) : MappedFile(file_path.to_char_arr()) {}
+
+			MappedFile(const MappedFile& other) = delete;
+			MappedFile& operator=(const MappedFile& other) = delete;
+
+			/**
+			 *  @brief  Unmaps the file, all views of it become invalid.
+			 */
+			~MappedFile()
+			{
+				if (mapping != NULL) ::munmap(mapping, length);
+			}
+
+			/**
+			 *  @brief  Returns the size of the file when it was mapped.
+			 */
+			size_t size() const
+			{
+				return length;
+			}
+
+			/**
+			 *  @brief  Returns a pointer to the first byte of the mapping.
+			 */
+			const char *data() const
+			{
+				return mapping;
+			}
+
+			/**
+			 *  @brief  Returns a view of the whole file.
+			 */
+			StringView view() const
+			{
+				return StringView(mapping, length);
+			}
+
+			/**
+			 *  @brief  Returns a view of a part of the file.
+			 *  @param  offset  The offset of the first byte.
+			 *  @param  count  The maximum number of bytes, the view ends at
+			 *  the end of the file if there are fewer.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			StringView slice(size_t offset, size_t count = SIZE_MAX) const
+			{
+				if (offset > length) throw MappedFileErrors::OUT_OF_RANGE;
+				return StringView(mapping + offset, std::min(count, length - offset));
+			}
+
+			/**
+			 *  @brief  Tells the kernel how a part of the file will be accessed.
+			 *  The range is widened to whole pages.
+			 *  @param  advice  SEQUENTIAL for a scan, which reads ahead
+			 *  aggressively and drops pages behind, RANDOM to disable read
+			 *  ahead, WILLNEED to start reading the range in now, DONTNEED
+			 *  to drop it, HUGEPAGE to back it with huge pages where the
+			 *  file system supports it.
+			 *  @param  offset  The offset of the first byte of the range.
+			 *  @param  count  The number of bytes, defaults to the rest of the file.
+			 *  @returns  Whether the kernel accepted the advice.
+			 */
+			bool advise(
+				enum MappedFileAdvice advice,
+				size_t offset = 0,
+				size_t count = SIZE_MAX
+			) {
+				if (mapping == NULL || offset >= length) return true;
+
+				count = std::min(count, length - offset);
+
+				static const size_t page_size = ::sysconf(_SC_PAGESIZE);
+				size_t aligned_offset = offset / page_size * page_size;
+
+				return ::madvise(mapping + aligned_offset, count + offset - aligned_offset,
+					to_madvise_flag(advice)) == 0;
+			}
+
+			/**
+			 *  @brief  Returns the number of bytes after the cursor.
+			 */
+			size_t remaining() const
+			{
+				return length - cursor;
+			}
+
+			/**
+			 *  @brief  Moves the cursor to an offset.
+			 */
+			void seek(size_t offset)
+			{
+				if (offset > length) throw MappedFileErrors::OUT_OF_RANGE;
+				cursor = offset;
+			}
+
+			/**
+			 *  @brief  Reads a chunk at the cursor and advances the cursor.
+			 *  The chunk is written to read_stream and also returned.
+			 *  @param  size  The maximum size of the chunk, it is empty at the
+			 *  end of the file.
+			 *  @note  Runtime: O(1), without the listeners of read_stream
+			 *  @note  Memory: O(1)
+			 */
+			StringView read(size_t size)
+			{
+				StringView chunk = slice(cursor, size);
+				cursor += chunk.size();
+
+				read_stream.write(chunk);
+				return chunk;
+			}
+
+			/**
+			 *  @brief  Writes the rest of the file to read_stream in chunks,
+			 *  without copying. Advises the kernel of the sequential scan.
+			 *  Throws MappedFileErrors::INVALID_CHUNK_SIZE if chunk_size is 0.
+			 *  @param  chunk_size  The maximum size of a chunk.
+			 */
+			void stream_remaining(size_t chunk_size)
+			{
+				if (chunk_size == 0) throw MappedFileErrors::INVALID_CHUNK_SIZE;
+
+				advise(MappedFileAdvice::SEQUENTIAL, cursor);
+
+				while (remaining() != 0) read(chunk_size);
+			}
+	};
+};
+
+#endif
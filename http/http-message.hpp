@@ -7,7 +7,16 @@
 #include "../data-structures/string-delimiter.hpp"
 #include "../data-structures/stream.hpp"
 #include "../data-structures/content-provider.hpp"
+#include "../debug/logger.hpp"
+#include "../events/inplace-function.hpp"
 #include "../networking/socket.hpp"
+#include "../memory/arena.hpp"
+
+// Inline storage of the body callbacks of a response, captures must fit in it
+
+#ifndef FLOW_HTTP_BODY_CALLBACK_SIZE
+#define FLOW_HTTP_BODY_CALLBACK_SIZE (size_t) (6 * sizeof(void *))
+#endif
 
 namespace flow_http_tools {
 	using namespace flow;
@@ -351,10 +360,19 @@ namespace flow_http_tools {
 			EventEmitter<> first_line_received_event;
 			EventEmitter<> headers_received_event;
 
+		private:
+			Stream<String&>& stream;
+			event_id_t data_listener_id;
+
+		public:
 			HTTPRequestParser(Stream<String&>& stream)
-				: buffer(String(FLOW_SOCKET_READ_BUFFER_SIZE))
+				: buffer(String(FLOW_SOCKET_READ_BUFFER_SIZE)), stream(stream)
 			{
-				stream.on_data([&](String& chunk) {
+				data_listener_id = stream.on_data([this](String& chunk) {
+					// The parsed request lives as long as the parser
+
+					ArenaScope heap_scope(NULL);
+
 					// Convert CRLF to LF
 
 					chunk.replace("\r\n", "\n");
@@ -462,6 +480,17 @@ namespace flow_http_tools {
 					}
 				});
 			}
+
+			HTTPRequestParser(const HTTPRequestParser& other) = delete;
+			HTTPRequestParser& operator=(const HTTPRequestParser& other) = delete;
+
+			/**
+			 *  @brief  Stops listening to the Stream.
+			 */
+			~HTTPRequestParser()
+			{
+				stream.write_event.remove_listener(data_listener_id);
+			}
 	};
 };
 
@@ -519,12 +548,39 @@ namespace flow {
 	};
 
 	class OutgoingHTTPResponse : public OutgoingHTTPMessage {
+		public:
+			typedef InplaceFunction<
+				bool(size_t offset, size_t desired_chunk_size, Stream<String&>& stream),
+				FLOW_HTTP_BODY_CALLBACK_SIZE
+			> body_callback_t;
+
+			typedef InplaceFunction<void(), FLOW_HTTP_BODY_CALLBACK_SIZE>
+				body_finished_callback_t;
+
 		private:
 			size_t body_provider_offset;
+			bool finished = false;
+
+			// Listener on the io_event of the Socket that sends the body,
+			// only set while body_pending is true
+
+			event_id_t body_listener_id;
+			bool body_pending = false;
+
+			// Number of holds on the response, see hold()
+
+			size_t holds = 0;
+
+			body_callback_t body_callback;
+			body_finished_callback_t body_finished_callback;
 
 		public:
 			HTTPResponseFirstLine first_line;
 
+			// Triggered once, when the whole response has been queued for writing
+
+			EventEmitter<> finish_event;
+
 			OutgoingHTTPResponse(
 				Socket& socket
 			) : OutgoingHTTPMessage(socket)
@@ -532,6 +588,67 @@ namespace flow {
 				first_line.http_version = "HTTP/1.1";
 			}
 
+			OutgoingHTTPResponse(const OutgoingHTTPResponse& other) = delete;
+			OutgoingHTTPResponse& operator=(const OutgoingHTTPResponse& other) = delete;
+
+			/**
+			 *  @brief  Stops sending the body, if it is still being sent,
+			 *  so the Socket does not call into a destroyed response.
+			 */
+			~OutgoingHTTPResponse()
+			{
+				if (body_pending) socket.io_event.remove_listener(body_listener_id);
+			}
+
+			/**
+			 *  @brief  Returns whether a body given to provide_body() is
+			 *  still being sent. The response finishes once it is sent.
+			 */
+			bool sending_body() const
+			{
+				return body_pending;
+			}
+
+			/**
+			 *  @brief  Keeps the response open for work that writes it later,
+			 *  e.g. work handed to HTTPServer::dispatch(). Every hold must be
+			 *  released with release(), and the response must not be
+			 *  finished while it is held.
+			 */
+			void hold()
+			{
+				holds++;
+			}
+
+			/**
+			 *  @brief  Releases a hold of hold().
+			 */
+			void release()
+			{
+				holds--;
+			}
+
+			/**
+			 *  @brief  Returns whether the response is held open.
+			 */
+			bool held() const
+			{
+				return holds != 0;
+			}
+
+			/**
+			 *  @brief  Marks the response as complete. provide_body() calls this
+			 *  when the body has been provided, a response that is sent without
+			 *  a body must call it after send().
+			 */
+			void finish()
+			{
+				if (finished) return;
+
+				finished = true;
+				finish_event.trigger();
+			}
+
 			void send(enum HTTPStatusCodes status_code)
 			{
 				first_line.status_code = status_code;
@@ -561,27 +678,18 @@ namespace flow {
 
 				send(status_code);
 
-				String::format(
-					"provide_body called. "
-					"OutgoingHTTPResponse = %llx, "
-					"content_provider = %llx",
-					(size_t) this, (size_t) content_provider
-				).print();
+				log_debug("provide_body called. OutgoingHTTPResponse = %llx, "
+					"content_provider = %llx", (size_t) this, (size_t) content_provider);
 
 				// Send the body
 
-				size_t *io_event_listener_id = new size_t;
-
-				*io_event_listener_id = socket.io_event.add_listener(
-					[content_provider, io_event_listener_id, this]
+				body_listener_id = socket.io_event.add_listener(
+					[content_provider, this]
 					(Stream<String&>& in, Stream<String&>& out)
 				{
-					String::format(
-						"io_event: sending chunk. id = %llu, "
-						"OutgoingHTTPResponse = %llx, "
-						"content_provider = %llx",
-						*io_event_listener_id, (size_t) this, (size_t) content_provider
-					).print();
+					log_trace("io_event: sending chunk. id = %llu, "
+						"OutgoingHTTPResponse = %llx, content_provider = %llx",
+						body_listener_id, (size_t) this, (size_t) content_provider);
 
 					// Send a chunk
 
@@ -590,25 +698,25 @@ namespace flow {
 					// Stop when the content is fully sent
 
 					if (content_provider->finished) {
-						socket.io_event.remove_listener(*io_event_listener_id);
-						delete io_event_listener_id;
+						socket.io_event.remove_listener(body_listener_id);
+						body_pending = false;
 						delete content_provider;
+
+						finish();
 					}
 				});
 
-				printf("socket.io_event.add_listener -> %lu\n", *io_event_listener_id);
+				body_pending = true;
+
+				log_debug("socket.io_event.add_listener -> %lu", body_listener_id);
 			}
 
 			void provide_body(
 				enum HTTPStatusCodes status_code,
 				size_t size,
 				const String& content_type,
-				std::function<bool(
-					size_t offset,
-					size_t desired_chunk_size,
-					Stream<String&>& stream
-				)> callback,
-				std::function<void()> finished_callback
+				body_callback_t&& callback,
+				body_finished_callback_t&& finished_callback
 			) {
 				// Set the headers
 
@@ -621,26 +729,27 @@ namespace flow {
 
 				// Send the body
 
-				// Fix the reference to the offset, it goes out of scope after this
-				// function returns.
+				// The callbacks are kept on the response, the listeners
+				// only capture this, so nothing dangles after returning
 
 				body_provider_offset = 0;
-				Stream<String&>& out = socket.out;
+				body_callback = std::move(callback);
+				body_finished_callback = std::move(finished_callback);
 
-				size_t io_event_listener_id = socket.io_event.add_listener([&](
+				body_listener_id = socket.io_event.add_listener([this](
 					Stream<String&>& in, Stream<String&>& out)
 				{
 					// Count the number of bytes being written
 
-					size_t write_event_listener_id = out.write_event.add_listener(
-						[&](String& data)
+					event_id_t write_event_listener_id = out.write_event.add_listener(
+						[this](String& data)
 					{
 						body_provider_offset += data.size();
 					});
 
 					// Fire the callback
 
-					bool keep_going = callback(body_provider_offset,
+					bool keep_going = body_callback(body_provider_offset,
 						FLOW_SOCKET_WRITE_BUFFER_SIZE, out);
 
 					// Stop counting the number of bytes being written
@@ -649,8 +758,16 @@ namespace flow {
 
 					// Stop on cancel
 
-					if (!keep_going) socket.io_event.remove_listener(io_event_listener_id);
+					if (!keep_going) {
+						socket.io_event.remove_listener(body_listener_id);
+						body_pending = false;
+						if (body_finished_callback) body_finished_callback();
+
+						finish();
+					}
 				});
+
+				body_pending = true;
 			}
 	};
 };
@@ -4,37 +4,328 @@
 #include <bits/stdc++.h>
 
 #include "../data-structures/string.hpp"
+#include "../data-structures/dynamic-array.hpp"
 #include "http-message.hpp"
 #include "../networking/socket.hpp"
 #include "../networking/socket-server.hpp"
-#include "http-message.hpp"
+#include "../memory/arena.hpp"
+#include "../concurrency/thread-pool.hpp"
+#include "../events/coroutine.hpp"
+
+namespace flow_http_server_tools {
+	/**
+	 *  @brief  A connection of an HTTPServer, with the parser of its request.
+	 */
+	struct HTTPConnection {
+		flow::Socket& socket;
+		flow::HTTPRequestParser parser;
+
+		// Listener on the end of the in Stream of the Socket
+
+		flow::event_id_t end_listener_id;
+
+		// Whether the request is being responded to, it refers to the parser
+
+		bool responding = false;
+		bool ended = false;
+
+		HTTPConnection(flow::Socket& socket) : socket(socket), parser(socket.in) {}
+
+		HTTPConnection(const HTTPConnection& other) = delete;
+		HTTPConnection& operator=(const HTTPConnection& other) = delete;
+
+		~HTTPConnection()
+		{
+			socket.in.end_event.remove_listener(end_listener_id);
+		}
+	};
+};
 
 namespace flow {
 	using namespace flow_http_tools;
+	using namespace flow_http_server_tools;
 
+	/**
+	 *  @brief  An HTTP server. Every request gets its own Arena, which holds
+	 *  the request and response objects and the Strings created while
+	 *  running the request listeners. The parser of a connection is on
+	 *  the heap, it is freed once the peer closed the connection and the
+	 *  response is finished.
+	 *  The Arena is reset once the response is finished, and its blocks are
+	 *  reused by a later request. Data that request listeners want to keep
+	 *  after the response is finished must be created in an ArenaScope
+	 *  of NULL, so it is allocated on the heap.
+	 *  Blocking or CPU heavy work of a request listener can be moved off
+	 *  the server loop with dispatch(), which runs it on a ThreadPool.
+	 *  Requests can also be handled by a coroutine instead, see on_request().
+	 */
 	class HTTPServer : public SocketServer {
+		private:
+			// All Arenas of the server
+
+			DynamicArray<Arena *> arenas;
+
+			// All open connections
+
+			DynamicArray<HTTPConnection *> connections;
+
+			// Arenas of finished responses. They are reset lazily, when a new
+			// request needs an Arena, because a response finishes while its
+			// own methods are still running
+
+			DynamicArray<Arena *> finished_arenas;
+
+			// Runs dispatched work, NULL to run it on the server loop
+
+			ThreadPool *thread_pool;
+
+			// The response whose listeners are running, it is held open
+			// by the work they dispatch
+
+			OutgoingHTTPResponse *handled_response = NULL;
+
+		public:
+			typedef InplaceFunction<
+				Coroutine(const IncomingHTTPRequest&, OutgoingHTTPResponse&)
+			> coroutine_handler_t;
+
+		private:
+			coroutine_handler_t coroutine_handler;
+
+			Coroutine run_coroutine_handler(
+				const IncomingHTTPRequest& req,
+				OutgoingHTTPResponse& res
+			) {
+				co_await coroutine_handler(req, res);
+				finish_unless_pending(res);
+			}
+
+			/**
+			 *  @brief  Finishes a response once its handler is done with it,
+			 *  unless a body is still being sent, which finishes it itself,
+			 *  or dispatched work still holds it.
+			 */
+			void finish_unless_pending(OutgoingHTTPResponse& res)
+			{
+				if (!res.sending_body() && !res.held()) res.finish();
+			}
+
+			/**
+			 *  @brief  Runs the second function of dispatch() and releases
+			 *  the response it held.
+			 */
+			template <typename Done>
+			void run_done(OutgoingHTTPResponse *res, Done& done)
+			{
+				OutgoingHTTPResponse *previous = handled_response;
+				handled_response = res;
+				done();
+				handled_response = previous;
+
+				if (res == NULL) return;
+
+				res->release();
+				finish_unless_pending(*res);
+			}
+
+			/**
+			 *  @brief  Frees a connection on the server loop, after the
+			 *  events of its Socket and response that are running returned.
+			 */
+			void close_connection(HTTPConnection *connection)
+			{
+				post([this, connection]() {
+					for (size_t i = 0; i < connections.size(); i++) {
+						if (connections[i] != connection) continue;
+
+						std::swap(connections[i], connections.back());
+						connections.extract_rear();
+						break;
+					}
+
+					delete connection;
+				});
+			}
+
+			Arena *acquire_arena()
+			{
+				if (finished_arenas.size() != 0) {
+					Arena *arena = finished_arenas.extract_rear();
+					arena->reset();
+					return arena;
+				}
+
+				Arena *arena = new Arena();
+				arenas.append(arena);
+				return arena;
+			}
+
 		public:
 			EventEmitter<
 				const IncomingHTTPRequest&,
 				OutgoingHTTPResponse&
 			> request_event;
 
-			HTTPServer()
+			/**
+			 *  @brief  Creates an HTTPServer.
+			 *  @param  thread_pool  The ThreadPool that runs dispatched work.
+			 *  If NULL, dispatched work runs on the server loop.
+			 */
+			HTTPServer(ThreadPool *thread_pool = NULL) : thread_pool(thread_pool)
 			{
 				new_socket_event.add_listener([this](Socket *socket) {
-					HTTPRequestParser *parser = new HTTPRequestParser(socket->in);
+					ArenaScope heap_scope(NULL);
+
+					HTTPConnection *connection = new HTTPConnection(*socket);
+					connections.append(connection);
+
+					connection->end_listener_id = socket->in.end_event.add_listener(
+						[connection, this]()
+					{
+						connection->ended = true;
+						if (!connection->responding) close_connection(connection);
+					});
 
-					parser->headers_received_event.add_listener([parser, socket, this]() {
-						IncomingHTTPRequest *req = new IncomingHTTPRequest(
+					connection->parser.headers_received_event.add_listener(
+						[connection, socket, this]()
+					{
+						HTTPRequestParser *parser = &connection->parser;
+						connection->responding = true;
+
+						// The response triggers finish_event once,
+						// so the Arena is handed back exactly once
+
+						Arena *arena = acquire_arena();
+						ArenaScope arena_scope(arena);
+
+						IncomingHTTPRequest *req = arena->create<IncomingHTTPRequest>(
 							*socket, parser->first_line, parser->headers);
 
-						OutgoingHTTPResponse *res = new OutgoingHTTPResponse(*socket);
+						OutgoingHTTPResponse *res
+							= arena->create<OutgoingHTTPResponse>(*socket);
+
+						res->finish_event.add_listener([arena, connection, this]() {
+							finished_arenas.append(arena);
+
+							connection->responding = false;
+							if (connection->ended) close_connection(connection);
+						});
 
+						if (coroutine_handler) {
+							spawn(run_coroutine_handler(*req, *res));
+							return;
+						}
+
+						handled_response = res;
 						request_event.trigger(*req, *res);
+						handled_response = NULL;
+
+						finish_unless_pending(*res);
 					});
 				});
 			}
+
+			HTTPServer(const HTTPServer& other) = delete;
+			HTTPServer& operator=(const HTTPServer& other) = delete;
+
+			/**
+			 *  @brief  Destroys all connections and Arenas, including the
+			 *  objects of requests that are still running.
+			 */
+			~HTTPServer()
+			{
+				for (size_t i = 0; i < connections.size(); i++) delete connections[i];
+				for (size_t i = 0; i < arenas.size(); i++) delete arenas[i];
+			}
+
+			/**
+			 *  @brief  Handles every request with a coroutine, which can
+			 *  await reads and writes of the Socket, sleeps and other
+			 *  Coroutines. The response is finished when the coroutine returns,
+			 *  or once its body is sent if it called provide_body().
+			 *  The coroutine runs in the Arena of its request whenever it is
+			 *  resumed. While a handler is set, request_event is not triggered.
+			 *  @param  handler  Creates the coroutine of a request. Captures of
+			 *  a lambda coroutine live in the handler, so it must be set once,
+			 *  before the server starts listening.
+			 */
+			void on_request(coroutine_handler_t&& handler)
+			{
+				coroutine_handler = std::move(handler);
+			}
+
+			/**
+			 *  @brief  Runs a function on the ThreadPool and passes its result
+			 *  to a second function, which runs on the server loop, where it
+			 *  may write the response. The work must not touch the socket,
+			 *  request or response. Both functions are moved into a task on
+			 *  the heap, so captured DynamicArrays, Strings and LinkedLists
+			 *  are copied off the Arena of the request, which may be reset
+			 *  while the work runs. Other captures must not point into the
+			 *  Arena, e.g. references to the request or a std::vector of
+			 *  Strings created in the ArenaScope. The work runs without an
+			 *  Arena, so everything it creates is allocated on the heap.
+			 *  The second function runs in the Arena that was bound when
+			 *  dispatch() was called. Called from a request listener, the
+			 *  response is held open until the second function returned,
+			 *  and finished then, unless it sends a body.
+			 *  @param  work  The function to run on the ThreadPool.
+			 *  @param  done  The function that is called with the result of
+			 *  work on the server loop. Without arguments if work returns void.
+			 */
+			template <typename Work, typename Done>
+			void dispatch(Work&& work, Done&& done)
+			{
+				using Result = std::invoke_result_t<std::decay_t<Work>&>;
+
+				if (thread_pool == NULL) {
+					if constexpr (std::is_void_v<Result>) {
+						work();
+						done();
+					} else {
+						done(work());
+					}
+
+					return;
+				}
+
+				Arena *arena = current_arena();
+				OutgoingHTTPResponse *res = handled_response;
+				if (res != NULL) res->hold();
+
+				// Copies the captures that are on the Arena to the heap
+
+				ArenaScope heap_scope(NULL);
+
+				thread_pool->submit([
+					this, arena, res,
+					work = std::forward<Work>(work),
+					done = std::forward<Done>(done)
+				]() mutable {
+					if constexpr (std::is_void_v<Result>) {
+						work();
+
+						post([this, arena, res, done = std::move(done)]() mutable {
+							ArenaScope arena_scope(arena);
+							run_done(res, done);
+						});
+					} else {
+						Result result = work();
+
+						post([
+							this, arena, res,
+							done = std::move(done),
+							result = std::move(result)
+						]() mutable {
+							ArenaScope arena_scope(arena);
+
+							auto done_with_result = [&]() { done(std::move(result)); };
+							run_done(res, done_with_result);
+						});
+					}
+				});
+			}
 	};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,92 @@
+#ifndef FLOW_RING_BUFFER_ITERATOR_HEADER
+#define FLOW_RING_BUFFER_ITERATOR_HEADER
+
+#include <bits/stdc++.h>
+
+namespace flow {
+	/**
+	 *  @brief  Iterator over a ring buffer with a power of 2 capacity.
+	 *  The iterator stores an unwrapped position, which is wrapped around
+	 *  the capacity on every access.
+	 */
+	template <typename type, bool Const = false>
+	class RingBufferIterator {
+		private:
+			type *buffer;
+			size_t mask;
+			size_t index;
+
+		public:
+			RingBufferIterator(type *buffer, size_t mask, size_t index)
+				: buffer(buffer), mask(mask), index(index) {}
+
+			RingBufferIterator(const RingBufferIterator<type, Const>& other)
+				: buffer(other.buffer), mask(other.mask), index(other.index) {}
+
+			RingBufferIterator<type, Const>& operator=(
+				const RingBufferIterator<type, Const>& other
+			) {
+				if (this == &other) return *this;
+
+				buffer = other.buffer;
+				mask = other.mask;
+				index = other.index;
+				return *this;
+			}
+
+			const type& operator*() const
+			{
+				return buffer[index & mask];
+			}
+
+			template <bool T = true>
+			typename std::enable_if<T && !Const, type&>::type
+			/* type & */ operator*()
+			{
+				return buffer[index & mask];
+			}
+
+			type *operator->()
+			{
+				return buffer + (index & mask);
+			}
+
+			RingBufferIterator<type, Const>& /* prefix */ operator++()
+			{
+				index++;
+				return *this;
+			}
+
+			RingBufferIterator<type, Const> /* postfix */ operator++(int)
+			{
+				RingBufferIterator<type, Const> old_it = *this;
+				index++;
+				return old_it;
+			}
+
+			RingBufferIterator<type, Const>& /* prefix */ operator--()
+			{
+				index--;
+				return *this;
+			}
+
+			RingBufferIterator<type, Const> /* postfix */ operator--(int)
+			{
+				RingBufferIterator<type, Const> old_it = *this;
+				index--;
+				return old_it;
+			}
+
+			bool operator==(const RingBufferIterator<type, Const>& other) const
+			{
+				return index == other.index;
+			}
+
+			bool operator!=(const RingBufferIterator<type, Const>& other) const
+			{
+				return index != other.index;
+			}
+	};
+};
+
+#endif
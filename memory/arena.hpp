@@ -0,0 +1,296 @@
+#ifndef FLOW_ARENA_HEADER
+#define FLOW_ARENA_HEADER
+
+#include <bits/stdc++.h>
+
+namespace flow {
+	class Arena;
+};
+
+namespace flow_arena_tools {
+	/**
+	 *  @brief  Header at the start of every block of an Arena,
+	 *  the memory of the block follows it.
+	 */
+	struct ArenaBlock {
+		ArenaBlock *next;
+		size_t size;
+	};
+
+	/**
+	 *  @brief  Destroys an object living on an Arena when the Arena is reset.
+	 *  Finalisers are stored on the Arena themselves, in front of their object.
+	 */
+	struct ArenaFinaliser {
+		ArenaFinaliser *next;
+		void (*destroy)(void *obj);
+		void *obj;
+	};
+
+	// The Arena that containers created on this thread allocate from
+
+	inline thread_local flow::Arena *bound_arena = NULL;
+};
+
+namespace flow {
+	using namespace flow_arena_tools;
+
+	/**
+	 *  @brief  A monotonic allocator. Memory is bumped out of big blocks and
+	 *  is never freed individually. Instead, the whole Arena is reset at once,
+	 *  after which its blocks are reused from the start.
+	 *  Containers created while an ArenaScope is active allocate from the
+	 *  Arena of the scope, so everything that belongs to a single unit of work
+	 *  (e.g. an HTTP request) can be thrown away in one go.
+	 *  @note  An Arena is not thread safe.
+	 */
+	class Arena {
+		public:
+			static constexpr size_t MIN_BLOCK_SIZE = 16 * 1024;
+
+		private:
+			// All blocks, kept across resets
+
+			ArenaBlock *first_block = NULL;
+			ArenaBlock *current_block = NULL;
+
+			char *cursor = NULL;
+			char *block_end = NULL;
+
+			// Objects that need to be destroyed on reset, newest first
+
+			ArenaFinaliser *finalisers = NULL;
+
+			size_t next_block_size;
+
+			static char *block_data(ArenaBlock *block)
+			{
+				return reinterpret_cast<char *>(block + 1);
+			}
+
+			void enter_block(ArenaBlock *block)
+			{
+				current_block = block;
+				cursor = block_data(block);
+				block_end = cursor + block->size;
+			}
+
+			/**
+			 *  @brief  Moves to the next block that can hold an allocation,
+			 *  reusing blocks from before the last reset when they are big
+			 *  enough, and allocating a new block otherwise.
+			 */
+			void next_block(size_t size, size_t alignment)
+			{
+				size_t needed = size + alignment;
+
+				// Reuse the next block if it fits
+
+				if (current_block != NULL && current_block->next != NULL
+					&& current_block->next->size >= needed) {
+					enter_block(current_block->next);
+					return;
+				}
+
+				size_t block_size = std::max(next_block_size, needed);
+				next_block_size = std::max(next_block_size, block_size * 2);
+
+				ArenaBlock *block = static_cast<ArenaBlock *>(
+					::operator new(sizeof(ArenaBlock) + block_size));
+
+				block->size = block_size;
+
+				// Link the new block in after the current one,
+				// so the blocks that are not reached yet stay reusable
+
+				if (current_block == NULL) {
+					block->next = first_block;
+					first_block = block;
+				} else {
+					block->next = current_block->next;
+					current_block->next = block;
+				}
+
+				enter_block(block);
+			}
+
+			void run_finalisers()
+			{
+				while (finalisers != NULL) {
+					finalisers->destroy(finalisers->obj);
+					finalisers = finalisers->next;
+				}
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an Arena. No memory is allocated until the
+			 *  first allocation.
+			 *  @param  first_block_size  The size of the first block in bytes.
+			 */
+			Arena(size_t first_block_size = MIN_BLOCK_SIZE)
+				: next_block_size(std::max(first_block_size, sizeof(void *))) {}
+
+			Arena(const Arena& other) = delete;
+			Arena& operator=(const Arena& other) = delete;
+
+			/**
+			 *  @brief  Destroys all objects created on the Arena and releases
+			 *  all blocks.
+			 */
+			~Arena()
+			{
+				run_finalisers();
+
+				ArenaBlock *block = first_block;
+
+				while (block != NULL) {
+					ArenaBlock *next = block->next;
+					::operator delete(block);
+					block = next;
+				}
+			}
+
+			/**
+			 *  @brief  Allocates memory on the Arena. The memory stays valid
+			 *  until the Arena is reset.
+			 *  @param  size  The number of bytes to allocate.
+			 *  @param  alignment  The alignment of the memory, a power of 2.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(size)
+			 */
+			void *allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+			{
+				uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor)
+					+ alignment - 1) & ~(alignment - 1);
+
+				if (cursor == NULL
+					|| aligned + size > reinterpret_cast<uintptr_t>(block_end)) {
+					next_block(size, alignment);
+					aligned = (reinterpret_cast<uintptr_t>(cursor)
+						+ alignment - 1) & ~(alignment - 1);
+				}
+
+				cursor = reinterpret_cast<char *>(aligned + size);
+				return reinterpret_cast<void *>(aligned);
+			}
+
+			/**
+			 *  @brief  Creates an object on the Arena. Its destructor is
+			 *  called when the Arena is reset or destroyed.
+			 *  @param  args  The arguments to pass to the constructor.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1)
+			 */
+			template <typename type, typename... Args>
+			type *create(Args&&... args)
+			{
+				if constexpr (std::is_trivially_destructible_v<type>) {
+					return new (allocate(sizeof(type), alignof(type)))
+						type(std::forward<Args>(args)...);
+				} else {
+					ArenaFinaliser *finaliser = static_cast<ArenaFinaliser *>(
+						allocate(sizeof(ArenaFinaliser), alignof(ArenaFinaliser)));
+
+					type *obj = new (allocate(sizeof(type), alignof(type)))
+						type(std::forward<Args>(args)...);
+
+					finaliser->destroy = [](void *obj) {
+						static_cast<type *>(obj)->~type();
+					};
+
+					finaliser->obj = obj;
+					finaliser->next = finalisers;
+					finalisers = finaliser;
+
+					return obj;
+				}
+			}
+
+			/**
+			 *  @brief  Destroys all objects created on the Arena and rewinds
+			 *  it to the start of its first block. The blocks are kept and
+			 *  reused by later allocations.
+			 *  @note  Runtime: O(1), plus O(f) for f objects with a destructor
+			 *  @note  Memory: O(1)
+			 */
+			void reset()
+			{
+				run_finalisers();
+
+				if (first_block != NULL) enter_block(first_block);
+			}
+
+			/**
+			 *  @brief  Returns the total size of all blocks in bytes.
+			 *  @note  Runtime: O(b), b = number of blocks
+			 */
+			size_t capacity() const
+			{
+				size_t total = 0;
+
+				for (ArenaBlock *block = first_block; block != NULL; block = block->next) {
+					total += block->size;
+				}
+
+				return total;
+			}
+	};
+
+	/**
+	 *  @brief  Returns the Arena bound to this thread by the innermost
+	 *  ArenaScope, or NULL if there is none.
+	 */
+	inline Arena *current_arena()
+	{
+		return bound_arena;
+	}
+
+	/**
+	 *  @brief  Binds an Arena to this thread for the lifetime of the
+	 *  ArenaScope. DynamicArrays, Strings and LinkedLists created while the
+	 *  scope is active allocate from the Arena, and keep doing so after the
+	 *  scope ends. They must not outlive the next reset of the Arena.
+	 *  Moving one into a container created outside the scope copies the
+	 *  data off the Arena.
+	 *  Scopes can be nested, the previous Arena is bound again on destruction.
+	 *  A scope of a NULL Arena binds the heap, for data that must outlive
+	 *  the Arena of an enclosing scope.
+	 */
+	class ArenaScope {
+		private:
+			Arena *previous;
+
+		public:
+			ArenaScope(Arena *arena) : previous(bound_arena)
+			{
+				bound_arena = arena;
+			}
+
+			ArenaScope(Arena& arena) : ArenaScope(&arena) {}
+
+			ArenaScope(const ArenaScope& other) = delete;
+			ArenaScope& operator=(const ArenaScope& other) = delete;
+
+			~ArenaScope()
+			{
+				bound_arena = previous;
+			}
+	};
+
+	/**
+	 *  @brief  Creates a value on the heap, whichever ArenaScope is active.
+	 *  The value is constructed in place, so a member initialised with
+	 *  `member(on_heap<String>(size))` allocates from the heap, which
+	 *  assigning to it in the body of a constructor would not do.
+	 *  @param  args  The arguments of the constructor of the value.
+	 */
+	template <typename type, typename... Args>
+	type on_heap(Args&&... args)
+	{
+		ArenaScope heap_scope(NULL);
+		return type(std::forward<Args>(args)...);
+	}
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef FLOW_BLOCK_POOL_HEADER
+#define FLOW_BLOCK_POOL_HEADER
+
+#include <bits/stdc++.h>
+
+namespace flow_block_pool_tools {
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+};
+
+namespace flow {
+	using namespace flow_block_pool_tools;
+
+	/**
+	 *  @brief  Free lists of blocks of memory, one per multiple of
+	 *  size_class bytes. Freed blocks are kept for the next allocation of
+	 *  the same size class, so code that keeps creating and destroying
+	 *  objects of the same sizes stops allocating once it is warmed up.
+	 *  Every block is a separate heap allocation, so a block may be freed
+	 *  to another BlockPool than the one it came from, e.g. the pool of the
+	 *  thread that frees it.
+	 *  @tparam  max_size  Blocks up to this size are pooled, bigger ones
+	 *  are allocated and freed on the heap.
+	 *  @tparam  size_class  The granularity of the block sizes.
+	 *  @note  A BlockPool is not thread safe, it is meant to be thread local.
+	 */
+	template <size_t max_size, size_t size_class = 64>
+	class BlockPool {
+		static_assert(size_class >= sizeof(FreeBlock),
+			"A size class must fit a free list link");
+
+		private:
+			static constexpr size_t SIZE_CLASS_COUNT
+				= (max_size + size_class - 1) / size_class;
+
+			FreeBlock *free_lists[SIZE_CLASS_COUNT] = {};
+
+			static size_t size_class_of(size_t size)
+			{
+				return (size - 1) / size_class;
+			}
+
+		public:
+			BlockPool() {}
+
+			BlockPool(const BlockPool& other) = delete;
+			BlockPool& operator=(const BlockPool& other) = delete;
+
+			/**
+			 *  @brief  Frees all free blocks.
+			 */
+			~BlockPool()
+			{
+				for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+					while (free_lists[i] != NULL) {
+						FreeBlock *block = free_lists[i];
+						free_lists[i] = block->next;
+						::operator delete(block);
+					}
+				}
+			}
+
+			/**
+			 *  @brief  Returns a block of at least a given size.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1), O(size) if no block was free
+			 */
+			void *allocate(size_t size)
+			{
+				if (size > max_size) return ::operator new(size);
+
+				size_t index = size_class_of(size);
+				FreeBlock *block = free_lists[index];
+
+				if (block == NULL) return ::operator new((index + 1) * size_class);
+
+				free_lists[index] = block->next;
+				return block;
+			}
+
+			/**
+			 *  @brief  Puts a block back in its free list.
+			 *  @param  size  The size the block was allocated with.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			void deallocate(void *ptr, size_t size)
+			{
+				if (size > max_size) {
+					::operator delete(ptr);
+					return;
+				}
+
+				FreeBlock *block = static_cast<FreeBlock *>(ptr);
+				size_t index = size_class_of(size);
+
+				block->next = free_lists[index];
+				free_lists[index] = block;
+			}
+	};
+};
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef FLOW_EPOCH_RECLAMATION_HEADER
+#define FLOW_EPOCH_RECLAMATION_HEADER
+
+#include <bits/stdc++.h>
+
+namespace flow {
+	class EpochDomain;
+};
+
+namespace flow_epoch_reclamation_tools {
+	/**
+	 *  @brief  An object that was unlinked from a shared data structure,
+	 *  and is deleted once no reader can still see it.
+	 */
+	struct RetiredObject {
+		void *ptr;
+		void (*deleter)(void *ptr);
+	};
+
+	/**
+	 *  @brief  Retired objects of a single thread, tagged with the global
+	 *  epoch at the moment they were handed to the EpochDomain.
+	 */
+	struct RetiredBatch {
+		uint64_t epoch;
+		std::vector<RetiredObject> objects;
+	};
+
+	/**
+	 *  @brief  The state a thread shares with an EpochDomain.
+	 *  Participants are reused by later threads and only freed together
+	 *  with their EpochDomain.
+	 */
+	struct EpochParticipant {
+		// The epoch the thread entered at shifted left by 1,
+		// with the lowest bit set while it is inside a guard
+
+		std::atomic<uint64_t> state = 0;
+		std::atomic<bool> in_use = true;
+		EpochParticipant *next = NULL;
+
+		// Only touched by the owning thread
+
+		size_t nesting = 0;
+		std::vector<RetiredObject> retired;
+	};
+
+	/**
+	 *  @brief  The participants of the current thread, one per EpochDomain
+	 *  it used. They are given back when the thread exits.
+	 */
+	struct EpochThreadRecords {
+		std::vector<std::pair<flow::EpochDomain *, EpochParticipant *>> entries;
+
+		~EpochThreadRecords();
+	};
+
+	inline thread_local EpochThreadRecords epoch_thread_records;
+};
+
+namespace flow {
+	using namespace flow_epoch_reclamation_tools;
+
+	/**
+	 *  @brief  Epoch based memory reclamation for lock-free data structures.
+	 *  Readers enter an EpochGuard before touching shared nodes, writers
+	 *  retire nodes they unlinked instead of deleting them. A retired node is
+	 *  deleted once the global epoch moved on twice, at which point every
+	 *  reader that could have seen it has left its guard.
+	 *  Entering and leaving a guard costs a store and a fence, there is no
+	 *  atomic read-modify-write on the read path.
+	 *  Retired nodes are collected in thread-local batches, which are handed
+	 *  to the EpochDomain and deleted by collect(), by the background
+	 *  reclaimer, or by a retiring thread once too many nodes are pending.
+	 *  Pending memory stays bounded as long as no reader stays in a guard
+	 *  forever.
+	 *  @note  An EpochDomain must outlive all threads that used it,
+	 *  except the thread that destroys it.
+	 */
+	class EpochDomain {
+		public:
+			static constexpr size_t BATCH_SIZE = 64;
+			static constexpr size_t MAX_PENDING = 64 * 1024;
+
+		private:
+			std::atomic<uint64_t> global_epoch = 0;
+
+			// All participants, never unlinked before destruction
+
+			std::atomic<EpochParticipant *> participants = NULL;
+
+			// Batches handed over by threads, oldest epoch first
+
+			std::mutex pending_mutex;
+			std::deque<RetiredBatch> pending;
+			std::atomic<size_t> pending_count = 0;
+
+			// Background reclaimer
+
+			std::thread reclaimer;
+			std::mutex reclaimer_mutex;
+			std::condition_variable reclaimer_wakeup;
+			bool reclaimer_stopping = false;
+
+			static void delete_objects(std::vector<RetiredObject>& objects)
+			{
+				for (RetiredObject& object : objects) object.deleter(object.ptr);
+				objects.clear();
+			}
+
+			EpochParticipant *acquire_participant()
+			{
+				// Reuse a participant of a thread that exited
+
+				for (EpochParticipant *p = participants.load(std::memory_order_acquire);
+					p != NULL; p = p->next) {
+					bool in_use = false;
+
+					if (!p->in_use.load(std::memory_order_relaxed)
+						&& p->in_use.compare_exchange_strong(in_use, true,
+							std::memory_order_acquire, std::memory_order_relaxed)) {
+						return p;
+					}
+				}
+
+				EpochParticipant *p = new EpochParticipant();
+				p->next = participants.load(std::memory_order_relaxed);
+
+				while (!participants.compare_exchange_weak(p->next, p,
+					std::memory_order_release, std::memory_order_relaxed));
+
+				return p;
+			}
+
+			/**
+			 *  @brief  Hands the retired objects of a participant to the
+			 *  EpochDomain, tagged with the current epoch.
+			 */
+			void flush(EpochParticipant *p)
+			{
+				if (p->retired.empty()) return;
+
+				size_t count = p->retired.size();
+
+				{
+					std::lock_guard<std::mutex> lock(pending_mutex);
+
+					// The epoch is read under the lock,
+					// so the pending batches stay sorted
+
+					pending.push_back({
+						global_epoch.load(std::memory_order_acquire),
+						std::move(p->retired)
+					});
+				}
+
+				p->retired = std::vector<RetiredObject>();
+				p->retired.reserve(BATCH_SIZE);
+
+				if (pending_count.fetch_add(count, std::memory_order_relaxed)
+					+ count > MAX_PENDING) {
+					collect();
+				}
+			}
+
+			friend struct flow_epoch_reclamation_tools::EpochThreadRecords;
+
+			void release_participant(EpochParticipant *p)
+			{
+				flush(p);
+				p->nesting = 0;
+				p->state.store(0, std::memory_order_release);
+				p->in_use.store(false, std::memory_order_release);
+			}
+
+		public:
+			EpochDomain() {}
+
+			EpochDomain(const EpochDomain& other) = delete;
+			EpochDomain& operator=(const EpochDomain& other) = delete;
+
+			/**
+			 *  @brief  Stops the background reclaimer and deletes all retired
+			 *  objects. No thread may be inside a guard of this EpochDomain.
+			 */
+			~EpochDomain()
+			{
+				stop_reclaimer();
+
+				std::vector<std::pair<EpochDomain *, EpochParticipant *>>& entries
+					= epoch_thread_records.entries;
+
+				for (size_t i = 0; i < entries.size(); i++) {
+					if (entries[i].first == this) {
+						entries.erase(entries.begin() + i);
+						break;
+					}
+				}
+
+				for (RetiredBatch& batch : pending) delete_objects(batch.objects);
+
+				EpochParticipant *p = participants.load(std::memory_order_acquire);
+
+				while (p != NULL) {
+					EpochParticipant *next = p->next;
+					delete_objects(p->retired);
+					delete p;
+					p = next;
+				}
+			}
+
+			/**
+			 *  @brief  Returns the participant of the current thread,
+			 *  registering the thread on its first call.
+			 *  @note  Runtime: O(d), d = number of EpochDomains the thread uses
+			 */
+			EpochParticipant *participant()
+			{
+				std::vector<std::pair<EpochDomain *, EpochParticipant *>>& entries
+					= epoch_thread_records.entries;
+
+				for (size_t i = 0; i < entries.size(); i++) {
+					if (entries[i].first == this) return entries[i].second;
+				}
+
+				EpochParticipant *p = acquire_participant();
+				entries.push_back({ this, p });
+				return p;
+			}
+
+			/**
+			 *  @brief  Marks a participant as reading. Guards can be nested,
+			 *  only the outermost one publishes the epoch.
+			 *  @note  Runtime: O(1)
+			 */
+			void enter(EpochParticipant *p)
+			{
+				if (p->nesting++ != 0) return;
+
+				p->state.store(global_epoch.load(std::memory_order_relaxed) << 1 | 1,
+					std::memory_order_relaxed);
+
+				// Reads of shared nodes must not move before the store
+
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+
+			/**
+			 *  @brief  Marks a participant as no longer reading.
+			 *  @note  Runtime: O(1)
+			 */
+			void leave(EpochParticipant *p)
+			{
+				if (--p->nesting != 0) return;
+
+				p->state.store(0, std::memory_order_release);
+			}
+
+			/**
+			 *  @brief  Defers the deletion of an object until no reader can
+			 *  see it anymore. The object must already be unreachable for
+			 *  readers that enter a guard from now on.
+			 *  @param  ptr  The object.
+			 *  @param  deleter  The function that deletes the object.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1)
+			 */
+			void retire(void *ptr, void (*deleter)(void *ptr))
+			{
+				EpochParticipant *p = participant();
+
+				p->retired.push_back({ ptr, deleter });
+
+				if (p->retired.size() >= BATCH_SIZE) flush(p);
+			}
+
+			/**
+			 *  @brief  Defers deleting an object allocated with new until no
+			 *  reader can see it anymore.
+			 *  @param  ptr  The object.
+			 */
+			template <typename type>
+			void retire(type *ptr)
+			{
+				retire(ptr, [](void *ptr) { delete static_cast<type *>(ptr); });
+			}
+
+			/**
+			 *  @brief  Hands the retired objects of the current thread to the
+			 *  EpochDomain, so they can be deleted by any thread.
+			 */
+			void flush()
+			{
+				flush(participant());
+			}
+
+			/**
+			 *  @brief  Moves the global epoch forward if every reader inside a
+			 *  guard has seen the current epoch.
+			 *  @returns  Whether the epoch moved forward.
+			 *  @note  Runtime: O(p), p = number of participants
+			 */
+			bool try_advance()
+			{
+				uint64_t epoch = global_epoch.load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				for (EpochParticipant *p = participants.load(std::memory_order_acquire);
+					p != NULL; p = p->next) {
+					uint64_t state = p->state.load(std::memory_order_relaxed);
+
+					if ((state & 1) && (state >> 1) != epoch) return false;
+				}
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				// Fails only if another thread advanced it already
+
+				global_epoch.compare_exchange_strong(epoch, epoch + 1,
+					std::memory_order_release, std::memory_order_relaxed);
+
+				return true;
+			}
+
+			/**
+			 *  @brief  Tries to move the epoch forward and deletes all handed
+			 *  over objects that no reader can see anymore.
+			 *  @returns  The number of deleted objects.
+			 *  @note  Runtime: O(p + r), p = number of participants,
+			 *  r = number of deleted objects
+			 */
+			size_t collect()
+			{
+				try_advance();
+
+				uint64_t epoch = global_epoch.load(std::memory_order_acquire);
+				std::vector<RetiredBatch> ready;
+
+				{
+					std::lock_guard<std::mutex> lock(pending_mutex);
+
+					while (!pending.empty() && pending.front().epoch + 2 <= epoch) {
+						ready.push_back(std::move(pending.front()));
+						pending.pop_front();
+					}
+				}
+
+				size_t deleted = 0;
+
+				for (RetiredBatch& batch : ready) {
+					deleted += batch.objects.size();
+					delete_objects(batch.objects);
+				}
+
+				pending_count.fetch_sub(deleted, std::memory_order_relaxed);
+				return deleted;
+			}
+
+			/**
+			 *  @brief  Returns the number of handed over objects that were not
+			 *  deleted yet.
+			 */
+			size_t pending_size() const
+			{
+				return pending_count.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 *  @brief  Starts a thread that calls collect() periodically.
+			 *  Does nothing if it is running already.
+			 *  @param  interval  The time between two collections.
+			 */
+			void start_reclaimer(
+				std::chrono::milliseconds interval = std::chrono::milliseconds(10))
+			{
+				if (reclaimer.joinable()) return;
+
+				reclaimer_stopping = false;
+
+				reclaimer = std::thread([this, interval]() {
+					std::unique_lock<std::mutex> lock(reclaimer_mutex);
+
+					while (!reclaimer_wakeup.wait_for(lock, interval,
+						[this]() { return reclaimer_stopping; })) {
+						lock.unlock();
+						collect();
+						lock.lock();
+					}
+				});
+			}
+
+			/**
+			 *  @brief  Stops the background reclaimer and waits for it to exit.
+			 */
+			void stop_reclaimer()
+			{
+				if (!reclaimer.joinable()) return;
+
+				{
+					std::lock_guard<std::mutex> lock(reclaimer_mutex);
+					reclaimer_stopping = true;
+				}
+
+				reclaimer_wakeup.notify_all();
+				reclaimer.join();
+			}
+	};
+
+	/**
+	 *  @brief  Returns the process wide EpochDomain.
+	 */
+	inline EpochDomain& default_epoch_domain()
+	{
+		static EpochDomain domain;
+		return domain;
+	}
+
+	/**
+	 *  @brief  Keeps the current thread inside an epoch for its lifetime.
+	 *  Shared nodes that are read while the guard is alive are not deleted
+	 *  before the guard is destroyed.
+	 */
+	class EpochGuard {
+		private:
+			EpochDomain& domain;
+			EpochParticipant *p;
+
+		public:
+			EpochGuard(EpochDomain& domain = default_epoch_domain())
+				: domain(domain), p(domain.participant())
+			{
+				domain.enter(p);
+			}
+
+			EpochGuard(const EpochGuard& other) = delete;
+			EpochGuard& operator=(const EpochGuard& other) = delete;
+
+			~EpochGuard()
+			{
+				domain.leave(p);
+			}
+
+			/**
+			 *  @brief  Defers deleting an object allocated with new until no
+			 *  reader can see it anymore.
+			 *  @param  ptr  The object.
+			 */
+			template <typename type>
+			void retire(type *ptr)
+			{
+				domain.retire(ptr);
+			}
+	};
+};
+
+inline flow_epoch_reclamation_tools::EpochThreadRecords::~EpochThreadRecords()
+{
+	for (std::pair<flow::EpochDomain *, EpochParticipant *>& entry : entries) {
+		entry.first->release_participant(entry.second);
+	}
+}
+
+#endif
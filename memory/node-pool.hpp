@@ -0,0 +1,516 @@
+#ifndef FLOW_NODE_POOL_HEADER
+#define FLOW_NODE_POOL_HEADER
+
+#include <bits/stdc++.h>
+
+#include "arena.hpp"
+
+namespace flow_node_pool_tools {
+	/**
+	 *  @brief  Storage for a single object of a NodePool. While the slot is
+	 *  free, its storage holds the pointer to the next free slot.
+	 */
+	template <typename type>
+	union NodePoolSlot {
+		NodePoolSlot<type> *next_free;
+		alignas(type) unsigned char storage[sizeof(type)];
+	};
+
+	/**
+	 *  @brief  Header at the start of every slab of a NodePool,
+	 *  the slots of the slab follow it.
+	 */
+	struct NodePoolSlab {
+		NodePoolSlab *next;
+		size_t slot_count;
+
+		// Slabs on an Arena are freed when the Arena is reset
+
+		bool on_arena;
+	};
+};
+
+namespace flow {
+	using namespace flow_node_pool_tools;
+
+	/**
+	 *  @brief  A slab allocator for objects of a single type, meant to be
+	 *  owned by a node based container, or shared by many small ones, like
+	 *  the buckets of a HashMap.
+	 *  Objects are handed out from slabs that grow geometrically, so a
+	 *  container of n nodes makes O(log n) allocations. Freed objects go on
+	 *  a freelist and are reused first, so allocating and freeing a node is
+	 *  a couple of pointer writes.
+	 *  Slabs are kept while objects are freed, so a container that shrinks
+	 *  a bit and grows again does not allocate again. Once more than half of
+	 *  the slots are free, and at least MIN_TRIM_FREE_SLOTS, the slabs
+	 *  without live objects are released with trim(). The next automatic
+	 *  trim() waits until twice as many slots are free as were left, so its
+	 *  cost is spread over the frees. All slabs are released when the
+	 *  NodePool is destroyed.
+	 *  A NodePool created while an ArenaScope is active allocates its slabs
+	 *  from the Arena of the scope, and from its Allocator otherwise.
+	 *  @tparam  type  The type of objects handed out.
+	 *  @tparam  Allocator  The allocator of the slabs, it is rebound to an
+	 *  over-aligned unit type. A stateless allocator takes up no space.
+	 *  @note  A NodePool is not thread safe.
+	 */
+	template <typename type, typename Allocator = std::allocator<type>>
+	class NodePool {
+		public:
+			static constexpr size_t MIN_SLAB_SLOTS = 4;
+			static constexpr size_t MAX_SLAB_BYTES = 64 * 1024;
+			static constexpr size_t MIN_TRIM_FREE_SLOTS = 64;
+
+		private:
+			using Slot = NodePoolSlot<type>;
+
+			static constexpr size_t SLAB_ALIGNMENT
+				= std::max(alignof(Slot), alignof(NodePoolSlab));
+
+			// Offset of the first slot from the start of a slab
+
+			static constexpr size_t SLOTS_OFFSET
+				= (sizeof(NodePoolSlab) + alignof(Slot) - 1)
+				/ alignof(Slot) * alignof(Slot);
+
+			static constexpr size_t MAX_SLAB_SLOTS = std::max(
+				MIN_SLAB_SLOTS, (MAX_SLAB_BYTES - SLOTS_OFFSET) / sizeof(Slot));
+
+			// Slabs are allocated as arrays of units, so the Allocator
+			// hands out memory that is aligned for both header and slots
+
+			struct alignas(SLAB_ALIGNMENT) SlabUnit {
+				unsigned char bytes[SLAB_ALIGNMENT];
+			};
+
+			using SlabAllocator = typename std::allocator_traits<Allocator>
+				::template rebind_alloc<SlabUnit>;
+
+			using SlabAllocatorTraits = std::allocator_traits<SlabAllocator>;
+
+			// Singly linked list of all slabs
+
+			NodePoolSlab *slabs = NULL;
+
+			// Freelist of slots that were handed out before
+
+			Slot *free_head = NULL;
+			Slot *free_tail = NULL;
+
+			// Slots of the newest slab that were never handed out
+
+			Slot *bump_next = NULL;
+			Slot *bump_end = NULL;
+
+			size_t live_count = 0;
+			size_t slot_capacity = 0;
+
+			// Number of free slots at which deallocate() trims the NodePool
+
+			size_t trim_threshold = MIN_TRIM_FREE_SLOTS;
+
+			// The Arena slabs are allocated from, NULL for the Allocator
+
+			Arena *arena = current_arena();
+
+			[[no_unique_address]] SlabAllocator slab_allocator;
+
+			static Slot *slab_slots(NodePoolSlab *slab)
+			{
+				return reinterpret_cast<Slot *>(
+					reinterpret_cast<char *>(slab) + SLOTS_OFFSET);
+			}
+
+			static size_t slab_units(size_t slot_count)
+			{
+				return (SLOTS_OFFSET + slot_count * sizeof(Slot)
+					+ sizeof(SlabUnit) - 1) / sizeof(SlabUnit);
+			}
+
+			void release_slab(NodePoolSlab *slab)
+			{
+				if (slab->on_arena) return;
+
+				SlabAllocatorTraits::deallocate(slab_allocator,
+					reinterpret_cast<SlabUnit *>(slab), slab_units(slab->slot_count));
+			}
+
+			/**
+			 *  @brief  Allocates a slab as big as all existing slabs together,
+			 *  and makes it the slab that new slots are bumped from.
+			 */
+			void add_slab()
+			{
+				size_t slot_count = std::clamp(
+					slot_capacity, MIN_SLAB_SLOTS, MAX_SLAB_SLOTS);
+
+				void *mem;
+
+				if (arena == NULL) {
+					mem = SlabAllocatorTraits::allocate(
+						slab_allocator, slab_units(slot_count));
+				} else {
+					mem = arena->allocate(
+						slab_units(slot_count) * sizeof(SlabUnit), SLAB_ALIGNMENT);
+				}
+
+				slabs = new (mem) NodePoolSlab { slabs, slot_count, arena != NULL };
+				slot_capacity += slot_count;
+
+				bump_next = slab_slots(slabs);
+				bump_end = bump_next + slot_count;
+			}
+
+			void push_free(Slot *slot)
+			{
+				slot->next_free = free_head;
+				if (free_head == NULL) free_tail = slot;
+				free_head = slot;
+			}
+
+			void release_all()
+			{
+				NodePoolSlab *slab = slabs;
+
+				while (slab != NULL) {
+					NodePoolSlab *next = slab->next;
+					release_slab(slab);
+					slab = next;
+				}
+
+				slabs = NULL;
+				free_head = NULL;
+				free_tail = NULL;
+				bump_next = NULL;
+				bump_end = NULL;
+				slot_capacity = 0;
+			}
+
+			void take(NodePool& other)
+			{
+				slabs = other.slabs;
+				free_head = other.free_head;
+				free_tail = other.free_tail;
+				bump_next = other.bump_next;
+				bump_end = other.bump_end;
+				live_count = other.live_count;
+				slot_capacity = other.slot_capacity;
+				trim_threshold = other.trim_threshold;
+				arena = other.arena;
+
+				other.slabs = NULL;
+				other.free_head = NULL;
+				other.free_tail = NULL;
+				other.bump_next = NULL;
+				other.bump_end = NULL;
+				other.live_count = 0;
+				other.slot_capacity = 0;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates a NodePool without any slabs.
+			 *  @param  allocator  The allocator of the slabs.
+			 */
+			NodePool(const Allocator& allocator = Allocator())
+				: slab_allocator(allocator) {}
+
+			NodePool(const NodePool& other) = delete;
+			NodePool& operator=(const NodePool& other) = delete;
+
+			/**
+			 *  @brief  Transfers all slabs of another NodePool to a new NodePool.
+			 *  Objects allocated by the other NodePool must be freed by the new one.
+			 */
+			NodePool(NodePool&& other)
+				: slab_allocator(std::move(other.slab_allocator))
+			{
+				take(other);
+			}
+
+			/**
+			 *  @brief  Releases all slabs of this NodePool and transfers all
+			 *  slabs of another NodePool to it. Objects allocated by the other
+			 *  NodePool must be freed by this one.
+			 */
+			NodePool& operator=(NodePool&& other)
+			{
+				if (this == &other) return *this;
+
+				release_all();
+				slab_allocator = other.slab_allocator;
+				take(other);
+
+				return *this;
+			}
+
+			/**
+			 *  @brief  Releases all slabs. Objects still alive are not destroyed.
+			 */
+			~NodePool()
+			{
+				release_all();
+			}
+
+			/**
+			 *  @brief  Returns the number of live objects.
+			 */
+			size_t size() const
+			{
+				return live_count;
+			}
+
+			/**
+			 *  @brief  Returns the Arena the slabs are allocated from,
+			 *  or NULL if they are allocated on the heap.
+			 */
+			Arena *get_arena() const
+			{
+				return arena;
+			}
+
+			/**
+			 *  @brief  Returns a copy of the allocator of the slabs.
+			 */
+			Allocator get_allocator() const
+			{
+				return Allocator(slab_allocator);
+			}
+
+			/**
+			 *  @brief  Returns the number of objects that fit in all slabs.
+			 */
+			size_t capacity() const
+			{
+				return slot_capacity;
+			}
+
+			/**
+			 *  @brief  Returns uninitialised storage for a single object.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
+			 */
+			type *allocate()
+			{
+				Slot *slot;
+
+				if (free_head != NULL) {
+					slot = free_head;
+					free_head = slot->next_free;
+					if (free_head == NULL) free_tail = NULL;
+				} else {
+					if (bump_next == bump_end) add_slab();
+					slot = bump_next++;
+				}
+
+				live_count++;
+				return reinterpret_cast<type *>(slot->storage);
+			}
+
+			/**
+			 *  @brief  Returns the storage of an object to the NodePool.
+			 *  The object must have been destroyed already. Releases the
+			 *  slabs without live objects once most slots are free.
+			 *  @param  ptr  Storage returned by allocate().
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1)
+			 */
+			void deallocate(type *ptr)
+			{
+				live_count--;
+				push_free(reinterpret_cast<Slot *>(ptr));
+
+				// Slabs on an Arena are never released, trimming them is useless
+
+				size_t free_count = slot_capacity - live_count;
+
+				if (arena == NULL && free_count >= trim_threshold && free_count > live_count) {
+					trim();
+					trim_threshold = std::max(MIN_TRIM_FREE_SLOTS,
+						2 * (slot_capacity - live_count));
+				}
+			}
+
+			/**
+			 *  @brief  Allocates and constructs an object. It is constructed
+			 *  on the Arena of the NodePool, or on the heap if it has none,
+			 *  whichever ArenaScope is active.
+			 *  @param  args  The arguments to pass to the constructor.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
+			 */
+			template <typename... Args>
+			type *create(Args&&... args)
+			{
+				type *ptr = allocate();
+				ArenaScope element_scope(arena);
+
+				try {
+					new (ptr) type(std::forward<Args>(args)...);
+				} catch (...) {
+					deallocate(ptr);
+					throw;
+				}
+
+				return ptr;
+			}
+
+			/**
+			 *  @brief  Destroys an object and returns its storage to the NodePool.
+			 *  @param  ptr  An object returned by create().
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1)
+			 */
+			void destroy(type *ptr)
+			{
+				ptr->~type();
+				deallocate(ptr);
+			}
+
+			/**
+			 *  @brief  Takes over all slabs of another NodePool, including the
+			 *  objects that are alive on them, which must now be freed by this
+			 *  NodePool. The other NodePool is left empty.
+			 *  Both NodePools must have allocators that compare equal.
+			 *  @param  other  The NodePool to take over.
+			 *  @note  Runtime: O(s + b), s = number of slabs of the other
+			 *  NodePool, b = number of never used slots on its newest slab
+			 *  @note  Memory: O(1)
+			 */
+			void adopt(NodePool& other)
+			{
+				if (this == &other || other.slabs == NULL) return;
+
+				// Hand the slots the other NodePool never bumped out
+				// to its freelist, this NodePool keeps bumping its own slab
+
+				while (other.bump_next != other.bump_end) {
+					other.push_free(other.bump_next++);
+				}
+
+				if (other.free_head != NULL) {
+					other.free_tail->next_free = free_head;
+					if (free_head == NULL) free_tail = other.free_tail;
+					free_head = other.free_head;
+				}
+
+				NodePoolSlab *last = other.slabs;
+				while (last->next != NULL) last = last->next;
+
+				last->next = slabs;
+				slabs = other.slabs;
+
+				live_count += other.live_count;
+				slot_capacity += other.slot_capacity;
+
+				other.slabs = NULL;
+				other.free_head = NULL;
+				other.free_tail = NULL;
+				other.bump_next = NULL;
+				other.bump_end = NULL;
+				other.live_count = 0;
+				other.slot_capacity = 0;
+			}
+
+			/**
+			 *  @brief  Releases all slabs that have no live objects on them.
+			 *  @note  Runtime: O(s log s + f), s = number of slabs,
+			 *  f = number of free slots
+			 *  @note  Memory: O(s), s = number of slabs
+			 */
+			void trim()
+			{
+				if (live_count == 0) {
+					release_all();
+					return;
+				}
+
+				struct SlabInfo {
+					Slot *begin;
+					NodePoolSlab *slab;
+					size_t free_count;
+				};
+
+				std::vector<SlabInfo> infos;
+
+				for (NodePoolSlab *slab = slabs; slab != NULL; slab = slab->next) {
+					infos.push_back({ slab_slots(slab), slab, 0 });
+				}
+
+				std::sort(infos.begin(), infos.end(),
+					[](const SlabInfo& a, const SlabInfo& b) { return a.begin < b.begin; });
+
+				auto find_info = [&](Slot *slot) -> SlabInfo& {
+					auto it = std::upper_bound(infos.begin(), infos.end(), slot,
+						[](Slot *slot, const SlabInfo& info) { return slot < info.begin; });
+
+					return *(it - 1);
+				};
+
+				// Count the free slots of every slab
+
+				if (bump_next != bump_end) {
+					find_info(bump_next).free_count += bump_end - bump_next;
+				}
+
+				for (Slot *slot = free_head; slot != NULL; slot = slot->next_free) {
+					find_info(slot).free_count++;
+				}
+
+				// Slabs on an Arena are only freed when the Arena is reset,
+				// so they are kept for reuse
+
+				auto releasable = [](const SlabInfo& info) {
+					return info.free_count == info.slab->slot_count
+						&& !info.slab->on_arena;
+				};
+
+				// Drop the slots of empty slabs from the freelist
+
+				Slot *slot = free_head;
+				free_head = NULL;
+				free_tail = NULL;
+
+				while (slot != NULL) {
+					Slot *next = slot->next_free;
+					SlabInfo& info = find_info(slot);
+
+					if (!releasable(info)) {
+						slot->next_free = NULL;
+						if (free_tail == NULL) free_head = slot;
+						else free_tail->next_free = slot;
+						free_tail = slot;
+					}
+
+					slot = next;
+				}
+
+				if (bump_next != bump_end) {
+					SlabInfo& info = find_info(bump_next);
+
+					if (releasable(info)) {
+						bump_next = NULL;
+						bump_end = NULL;
+					}
+				}
+
+				// Release the empty slabs
+
+				slabs = NULL;
+				slot_capacity = 0;
+
+				for (SlabInfo& info : infos) {
+					if (releasable(info)) {
+						release_slab(info.slab);
+					} else {
+						info.slab->next = slabs;
+						slabs = info.slab;
+						slot_capacity += info.slab->slot_count;
+					}
+				}
+			}
+	};
+};
+
+#endif
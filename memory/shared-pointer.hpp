@@ -3,26 +3,179 @@
 
 #include <bits/stdc++.h>
 
+#include "arena.hpp"
+
+namespace flow_shared_pointer_tools {
+	/**
+	 *  @brief  A reference count. The thread safe variant is atomic:
+	 *  increments are relaxed, since a new reference can only be made from
+	 *  an existing one, and decrements are acquire-release, so the last
+	 *  owner sees all writes of the other owners before destroying.
+	 *  @tparam  thread_safe  Whether the count can be shared between threads.
+	 */
+	template <bool thread_safe>
+	class RefCount;
+
+	template <>
+	class RefCount<false> {
+		private:
+			size_t count;
+
+		public:
+			RefCount(size_t count = 1) : count(count) {}
+
+			void increment()
+			{
+				count++;
+			}
+
+			/**
+			 *  @brief  Increments the count, unless it is 0.
+			 *  @returns  Whether the count was incremented.
+			 */
+			bool increment_if_not_zero()
+			{
+				if (count == 0) return false;
+
+				count++;
+				return true;
+			}
+
+			/**
+			 *  @brief  Decrements the count.
+			 *  @returns  Whether the count dropped to 0.
+			 */
+			bool decrement()
+			{
+				return --count == 0;
+			}
+
+			size_t get() const
+			{
+				return count;
+			}
+	};
+
+	template <>
+	class RefCount<true> {
+		private:
+			std::atomic<size_t> count;
+
+		public:
+			RefCount(size_t count = 1) : count(count) {}
+
+			void increment()
+			{
+				count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			/**
+			 *  @brief  Increments the count, unless it is 0.
+			 *  @returns  Whether the count was incremented.
+			 */
+			bool increment_if_not_zero()
+			{
+				size_t current = count.load(std::memory_order_relaxed);
+
+				while (current != 0) {
+					if (count.compare_exchange_weak(current, current + 1,
+						std::memory_order_acquire, std::memory_order_relaxed)) {
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			/**
+			 *  @brief  Decrements the count.
+			 *  @returns  Whether the count dropped to 0.
+			 */
+			bool decrement()
+			{
+				return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+			}
+
+			size_t get() const
+			{
+				return count.load(std::memory_order_relaxed);
+			}
+	};
+
+	/**
+	 *  @brief  The control block of a SharedPointer, holding the object and
+	 *  its counts. The object is destroyed when the last SharedPointer goes
+	 *  away, the block when the last WeakPointer goes away as well.
+	 *  All SharedPointers together hold a single weak reference.
+	 */
+	template <typename type, bool thread_safe>
+	struct SharedReference {
+		RefCount<thread_safe> strong_count;
+		RefCount<thread_safe> weak_count;
+		alignas(type) unsigned char storage[sizeof(type)];
+
+		template <typename... Args>
+		SharedReference(Args&&... args)
+		{
+			// The block is on the heap, keep the object off the Arena
+
+			flow::ArenaScope heap_scope(NULL);
+			new (storage) type(std::forward<Args>(args)...);
+		}
+
+		type *obj()
+		{
+			return std::launder(reinterpret_cast<type *>(storage));
+		}
+
+		void release_strong()
+		{
+			if (!strong_count.decrement()) return;
+
+			obj()->~type();
+			release_weak();
+		}
+
+		void release_weak()
+		{
+			if (weak_count.decrement()) delete this;
+		}
+	};
+};
+
 namespace flow {
+	using namespace flow_shared_pointer_tools;
+
+	template <typename type, bool thread_safe>
+	class WeakPointer;
+
 	/**
 	 *  @brief  Shared pointer implementation. The pointer is deleted when
 	 *  all SharedPointers referencing this object go out of scope.
+	 *  A moved-from SharedPointer is empty.
+	 *  @tparam  type  The type of the object, can be const to share an
+	 *  immutable object.
+	 *  @tparam  thread_safe  Whether SharedPointers to the same object can be
+	 *  copied and destroyed on different threads. The object itself is not
+	 *  protected.
 	 */
-	template <typename type>
+	template <typename type, bool thread_safe = false>
 	class SharedPointer {
 		public:
-			struct Reference {
-				size_t ref_count;
-				type obj;
-
-				Reference() : ref_count(1) {}
-				Reference(const type& obj) : ref_count(1), obj(obj) {}
-				Reference(type&& obj) : ref_count(1), obj(std::move(obj)) {}
-			};
+			using Reference = SharedReference<type, thread_safe>;
 
 		protected:
 			Reference *ptr;
 
+			SharedPointer(Reference *ptr) : ptr(ptr) {}
+
+			void release()
+			{
+				if (ptr != NULL) ptr->release_strong();
+			}
+
+			friend class WeakPointer<type, thread_safe>;
+
 		public:
 			/**
 			 *  @brief  Creates an uninitialised SharedPointer.
@@ -35,7 +188,15 @@ namespace flow {
 			/**
 			 *  @brief  Creates a new SharedPointer and initialises it.
 			 */
-			SharedPointer(type&& value)
+			SharedPointer(const type& value)
+			{
+				ptr = new Reference(value);
+			}
+
+			/**
+			 *  @brief  Creates a new SharedPointer and initialises it.
+			 */
+			SharedPointer(std::remove_const_t<type>&& value)
 			{
 				ptr = new Reference(std::move(value));
 			}
@@ -47,7 +208,7 @@ namespace flow {
 			 */
 			SharedPointer(const SharedPointer& other) : ptr(other.ptr)
 			{
-				ptr->ref_count++;
+				if (ptr != NULL) ptr->strong_count.increment();
 			}
 
 			/**
@@ -62,26 +223,28 @@ namespace flow {
 			/**
 			 *  @brief  Creates a new reference to an existing SharedPointer.
 			 *  The new reference will also own the reference and the reference
-			 *  count will be incremented.
+			 *  count will be incremented. The previous reference is released.
 			 */
 			SharedPointer& operator=(const SharedPointer& other)
 			{
-				if (this == &other) return *this;
+				if (ptr == other.ptr) return *this;
 
+				if (other.ptr != NULL) other.ptr->strong_count.increment();
+				release();
 				ptr = other.ptr;
-				ptr->ref_count++;
 
 				return *this;
 			}
 
 			/**
 			 *  @brief  Transfers ownership of another SharedPointer to
-			 *  this SharedPointer.
+			 *  this SharedPointer. The previous reference is released.
 			 */
 			SharedPointer& operator=(SharedPointer&& other)
 			{
 				if (this == &other) return *this;
 
+				release();
 				ptr = other.ptr;
 				other.ptr = NULL;
 
@@ -93,9 +256,7 @@ namespace flow {
 			 */
 			~SharedPointer()
 			{
-				if (ptr == NULL) return;
-				ptr->ref_count--;
-				if (ptr->ref_count == 0) delete ptr;
+				release();
 			}
 
 			/**
@@ -103,7 +264,7 @@ namespace flow {
 			 */
 			const type& operator*() const
 			{
-				return ptr->obj;
+				return *ptr->obj();
 			}
 
 			/**
@@ -111,7 +272,7 @@ namespace flow {
 			 */
 			type& operator*()
 			{
-				return ptr->obj;
+				return *ptr->obj();
 			}
 
 			/**
@@ -119,17 +280,286 @@ namespace flow {
 			 */
 			type *operator->()
 			{
-				return &(ptr->obj);
+				return ptr->obj();
+			}
+
+			/**
+			 *  @brief  Returns the read-only raw pointer of this SharedPointer.
+			 */
+			const type *operator->() const
+			{
+				return ptr->obj();
+			}
+
+			/**
+			 *  @brief  Returns the raw pointer of this SharedPointer,
+			 *  or NULL if it is empty.
+			 */
+			type *get() const
+			{
+				return ptr == NULL ? NULL : ptr->obj();
+			}
+
+			/**
+			 *  @brief  Returns whether this SharedPointer points at an object.
+			 */
+			explicit operator bool() const
+			{
+				return ptr != NULL;
 			}
 
 			/**
 			 *  @brief  Returns the number of references to this SharedPointer.
+			 *  @note  The count of a thread safe SharedPointer may be
+			 *  outdated by the time it is returned.
+			 */
+			size_t ref_count() const
+			{
+				return ptr == NULL ? 0 : ptr->strong_count.get();
+			}
+	};
+
+	/**
+	 *  @brief  A non-owning reference to an object owned by SharedPointers.
+	 *  The object can be accessed by locking the WeakPointer, which fails
+	 *  once all SharedPointers went away.
+	 *  @tparam  type  The type of the object.
+	 *  @tparam  thread_safe  Must match the SharedPointers of the object.
+	 */
+	template <typename type, bool thread_safe = false>
+	class WeakPointer {
+		private:
+			using Reference = SharedReference<type, thread_safe>;
+
+			Reference *ptr;
+
+		public:
+			/**
+			 *  @brief  Creates a WeakPointer that does not refer to anything.
+			 */
+			WeakPointer() : ptr(NULL) {}
+
+			/**
+			 *  @brief  Creates a WeakPointer to the object of a SharedPointer.
+			 */
+			WeakPointer(const SharedPointer<type, thread_safe>& shared)
+				: ptr(shared.ptr)
+			{
+				if (ptr != NULL) ptr->weak_count.increment();
+			}
+
+			WeakPointer(const WeakPointer& other) : ptr(other.ptr)
+			{
+				if (ptr != NULL) ptr->weak_count.increment();
+			}
+
+			WeakPointer(WeakPointer&& other) : ptr(other.ptr)
+			{
+				other.ptr = NULL;
+			}
+
+			WeakPointer& operator=(const WeakPointer& other)
+			{
+				if (ptr == other.ptr) return *this;
+
+				if (other.ptr != NULL) other.ptr->weak_count.increment();
+				if (ptr != NULL) ptr->release_weak();
+				ptr = other.ptr;
+
+				return *this;
+			}
+
+			WeakPointer& operator=(WeakPointer&& other)
+			{
+				if (this == &other) return *this;
+
+				if (ptr != NULL) ptr->release_weak();
+				ptr = other.ptr;
+				other.ptr = NULL;
+
+				return *this;
+			}
+
+			~WeakPointer()
+			{
+				if (ptr != NULL) ptr->release_weak();
+			}
+
+			/**
+			 *  @brief  Returns whether the object was destroyed already.
+			 */
+			bool expired() const
+			{
+				return ptr == NULL || ptr->strong_count.get() == 0;
+			}
+
+			/**
+			 *  @brief  Returns a SharedPointer to the object,
+			 *  or an empty SharedPointer if it was destroyed already.
+			 *  @note  Runtime: O(1)
+			 *  @note  Memory: O(1)
+			 */
+			SharedPointer<type, thread_safe> lock() const
+			{
+				if (ptr == NULL || !ptr->strong_count.increment_if_not_zero()) {
+					return SharedPointer<type, thread_safe>(static_cast<Reference *>(NULL));
+				}
+
+				return SharedPointer<type, thread_safe>(ptr);
+			}
+	};
+
+	/**
+	 *  @brief  Base class for objects that carry their own reference count,
+	 *  so they can be owned by IntrusivePointers.
+	 *  @tparam  thread_safe  Whether IntrusivePointers to the same object can
+	 *  be copied and destroyed on different threads.
+	 */
+	template <bool thread_safe = true>
+	class RefCounted {
+		private:
+			mutable RefCount<thread_safe> intrusive_ref_count = 0;
+
+		public:
+			RefCounted() {}
+
+			// A copy is a new object, so it starts without references
+
+			RefCounted(const RefCounted&) {}
+			RefCounted& operator=(const RefCounted&) { return *this; }
+
+			void retain() const
+			{
+				intrusive_ref_count.increment();
+			}
+
+			/**
+			 *  @brief  Drops a reference.
+			 *  @returns  Whether it was the last reference.
+			 */
+			bool release() const
+			{
+				return intrusive_ref_count.decrement();
+			}
+
+			size_t ref_count() const
+			{
+				return intrusive_ref_count.get();
+			}
+	};
+
+	/**
+	 *  @brief  Shared pointer to an object that carries its own reference
+	 *  count, e.g. by deriving from RefCounted. There is no separate control
+	 *  block, so an IntrusivePointer is a single raw pointer, and one can be
+	 *  made again from a raw pointer to the object.
+	 *  The object is deleted when the last IntrusivePointer goes away.
+	 *  @tparam  type  The type of the object, must have retain(), release()
+	 *  and ref_count() methods.
+	 */
+	template <typename type>
+	class IntrusivePointer {
+		private:
+			type *ptr;
+
+			void release()
+			{
+				if (ptr != NULL && ptr->release()) delete ptr;
+			}
+
+		public:
+			/**
+			 *  @brief  Creates an empty IntrusivePointer.
+			 */
+			IntrusivePointer() : ptr(NULL) {}
+
+			/**
+			 *  @brief  Creates an IntrusivePointer to an object allocated with
+			 *  new, and adds a reference to it.
+			 */
+			IntrusivePointer(type *ptr) : ptr(ptr)
+			{
+				if (ptr != NULL) ptr->retain();
+			}
+
+			IntrusivePointer(const IntrusivePointer& other) : ptr(other.ptr)
+			{
+				if (ptr != NULL) ptr->retain();
+			}
+
+			IntrusivePointer(IntrusivePointer&& other) noexcept : ptr(other.ptr)
+			{
+				other.ptr = NULL;
+			}
+
+			IntrusivePointer& operator=(const IntrusivePointer& other)
+			{
+				if (ptr == other.ptr) return *this;
+
+				if (other.ptr != NULL) other.ptr->retain();
+				release();
+				ptr = other.ptr;
+
+				return *this;
+			}
+
+			IntrusivePointer& operator=(IntrusivePointer&& other)
+			{
+				if (this == &other) return *this;
+
+				release();
+				ptr = other.ptr;
+				other.ptr = NULL;
+
+				return *this;
+			}
+
+			~IntrusivePointer()
+			{
+				release();
+			}
+
+			type& operator*() const
+			{
+				return *ptr;
+			}
+
+			type *operator->() const
+			{
+				return ptr;
+			}
+
+			/**
+			 *  @brief  Returns the raw pointer, or NULL if it is empty.
+			 */
+			type *get() const
+			{
+				return ptr;
+			}
+
+			explicit operator bool() const
+			{
+				return ptr != NULL;
+			}
+
+			/**
+			 *  @brief  Returns the number of references to the object.
 			 */
 			size_t ref_count() const
 			{
-				return ptr->ref_count;
+				return ptr == NULL ? 0 : ptr->ref_count();
 			}
 	};
+
+	/**
+	 *  @brief  Creates an object and returns an IntrusivePointer to it.
+	 *  @param  args  The arguments to pass to the constructor.
+	 */
+	template <typename type, typename... Args>
+	IntrusivePointer<type> make_intrusive(Args&&... args)
+	{
+		return IntrusivePointer<type>(new type(std::forward<Args>(args)...));
+	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,162 @@
+#ifndef FLOW_TRACKING_ALLOCATOR_HEADER
+#define FLOW_TRACKING_ALLOCATOR_HEADER
+
+#include <bits/stdc++.h>
+#include <cxxabi.h>
+
+#include "../data-structures/string.hpp"
+
+namespace flow_tracking_allocator_tools {
+	/**
+	 *  @brief  Allocation counters of all TrackingAllocators of a single tag.
+	 *  Counters are updated with relaxed atomics, so they can be read at any
+	 *  time, but are only exact once all threads are done allocating.
+	 */
+	struct AllocationStats {
+		// Mangled name of the tag
+
+		const char *tag_name;
+
+		std::atomic<size_t> allocations = 0;
+		std::atomic<size_t> deallocations = 0;
+		std::atomic<size_t> bytes_allocated = 0;
+		std::atomic<size_t> bytes_in_use = 0;
+		std::atomic<size_t> peak_bytes_in_use = 0;
+
+		// Next stats in the registry
+
+		AllocationStats *next = NULL;
+
+		AllocationStats(const char *tag_name);
+
+		void record_allocation(size_t bytes)
+		{
+			allocations.fetch_add(1, std::memory_order_relaxed);
+			bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+
+			size_t in_use = bytes_in_use.fetch_add(bytes,
+				std::memory_order_relaxed) + bytes;
+			size_t peak = peak_bytes_in_use.load(std::memory_order_relaxed);
+
+			while (in_use > peak && !peak_bytes_in_use.compare_exchange_weak(
+				peak, in_use, std::memory_order_relaxed));
+		}
+
+		void record_deallocation(size_t bytes)
+		{
+			deallocations.fetch_add(1, std::memory_order_relaxed);
+			bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+	};
+
+	// All AllocationStats that were created, newest first
+
+	inline std::atomic<AllocationStats *> stats_registry = NULL;
+
+	inline AllocationStats::AllocationStats(const char *tag_name)
+		: tag_name(tag_name)
+	{
+		next = stats_registry.load(std::memory_order_relaxed);
+
+		while (!stats_registry.compare_exchange_weak(next, this,
+			std::memory_order_release, std::memory_order_relaxed));
+	}
+};
+
+namespace flow {
+	using namespace flow_tracking_allocator_tools;
+
+	/**
+	 *  @brief  Returns the allocation counters of a tag.
+	 *  @tparam  Tag  The tag to get the counters of.
+	 */
+	template <typename Tag>
+	AllocationStats& allocation_stats()
+	{
+		static AllocationStats stats(typeid(Tag).name());
+		return stats;
+	}
+
+	/**
+	 *  @brief  An allocator that counts the allocations and bytes of every
+	 *  container it is used by, on top of std::allocator.
+	 *  The counters are kept per tag, and the tag is kept when the allocator
+	 *  is rebound, so nested containers and nodes count towards the container
+	 *  the allocator was given to. It is stateless, so it takes up no space
+	 *  inside containers.
+	 *  Example: HashMap<String, int, TrackingAllocator<KeyValuePair<String, int>>>
+	 *  @tparam  type  The type of objects allocated.
+	 *  @tparam  Tag  The type the counters are kept under, defaults to type.
+	 */
+	template <typename type, typename Tag = type>
+	class TrackingAllocator {
+		public:
+			using value_type = type;
+			using is_always_equal = std::true_type;
+
+			template <typename other_type>
+			struct rebind {
+				using other = TrackingAllocator<other_type, Tag>;
+			};
+
+			TrackingAllocator() {}
+
+			template <typename other_type>
+			TrackingAllocator(const TrackingAllocator<other_type, Tag>& other) {}
+
+			/**
+			 *  @brief  Allocates uninitialised storage for a number of objects.
+			 *  @param  count  The number of objects.
+			 */
+			type *allocate(size_t count)
+			{
+				type *ptr = std::allocator<type>().allocate(count);
+				allocation_stats<Tag>().record_allocation(count * sizeof(type));
+				return ptr;
+			}
+
+			/**
+			 *  @brief  Frees storage returned by allocate().
+			 *  @param  ptr  The storage to free.
+			 *  @param  count  The number of objects passed to allocate().
+			 */
+			void deallocate(type *ptr, size_t count)
+			{
+				allocation_stats<Tag>().record_deallocation(count * sizeof(type));
+				std::allocator<type>().deallocate(ptr, count);
+			}
+
+			template <typename other_type>
+			bool operator==(const TrackingAllocator<other_type, Tag>& other) const
+			{
+				return true;
+			}
+	};
+
+	/**
+	 *  @brief  Prints the allocation counters of all tags that allocated.
+	 *  @param  stream  The stream to print to.
+	 */
+	inline void print_allocation_stats(FILE *stream = stdout)
+	{
+		for (AllocationStats *stats = stats_registry.load(std::memory_order_acquire);
+			stats != NULL; stats = stats->next) {
+			int status;
+			char *demangled = abi::__cxa_demangle(stats->tag_name, NULL, NULL, &status);
+
+			String::format("%s: %llu allocations, %llu deallocations, "
+				"%llu bytes allocated, %llu bytes in use, %llu bytes peak",
+				status == 0 ? demangled : stats->tag_name,
+				(unsigned long long) stats->allocations.load(std::memory_order_relaxed),
+				(unsigned long long) stats->deallocations.load(std::memory_order_relaxed),
+				(unsigned long long) stats->bytes_allocated.load(std::memory_order_relaxed),
+				(unsigned long long) stats->bytes_in_use.load(std::memory_order_relaxed),
+				(unsigned long long) stats->peak_bytes_in_use.load(std::memory_order_relaxed)
+			).print(stream);
+
+			free(demangled);
+		}
+	}
+};
+
+#endif
@@ -2,13 +2,159 @@
 #define FLOW_SOCKET_SERVER_HEADER
 
 #include <bits/stdc++.h>
+#include <poll.h>
 
 #include "../data-structures/dynamic-array.hpp"
+#include "../debug/logger.hpp"
 #include "../data-structures/string.hpp"
+#include "../data-structures/queue.hpp"
+#include "../data-structures/priority-queue.hpp"
 #include "../networking/socket.hpp"
+#include "../concurrency/thread-pool.hpp"
+
+namespace flow_socket_server_tools {
+	typedef flow::InplaceFunction<void()> timer_callback_t;
+
+	/**
+	 *  @brief  A callback that runs on the server loop once its deadline
+	 *  passed. Timers with the same deadline run in the order they were set.
+	 */
+	struct SocketServerTimer {
+		std::chrono::steady_clock::time_point deadline;
+		uint64_t sequence;
+		timer_callback_t callback;
+	};
+
+	struct SocketServerTimerOrder {
+		bool operator()(const SocketServerTimer& a, const SocketServerTimer& b) const
+		{
+			if (a.deadline != b.deadline) return a.deadline < b.deadline;
+			return a.sequence < b.sequence;
+		}
+	};
+
+	typedef flow::InplaceFunction<void()> watch_callback_t;
+
+	/**
+	 *  @brief  A file descriptor other than a socket, e.g. of a FileWatcher,
+	 *  and the callback that runs on the server loop when it is readable.
+	 */
+	struct SocketServerWatch {
+		int fd;
+		watch_callback_t callback;
+	};
+};
 
 namespace flow {
+	using namespace flow_socket_server_tools;
+
+	class SocketServer;
+
+	/**
+	 *  @brief  Awaiter of SocketServer::sleep_for().
+	 */
+	struct SleepAwaiter {
+		SocketServer& server;
+		std::chrono::steady_clock::duration delay;
+		Suspension suspension;
+
+		bool await_ready()
+		{
+			return delay <= std::chrono::steady_clock::duration::zero();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() {}
+	};
+
 	class SocketServer {
+		private:
+			// Functions posted from other threads, run by the server loop
+
+			std::mutex posted_mutex;
+			Queue<task_t> posted;
+			std::atomic<bool> has_posted = false;
+
+			// The thread that runs the server loop
+
+			std::atomic<std::thread::id> loop_thread;
+
+			PriorityQueue<SocketServerTimer, SocketServerTimerOrder> timers;
+			uint64_t timer_sequence = 0;
+
+			// Watched file descriptors, poll_fds[i] belongs to watches[i].
+			// Watches removed while callbacks run get fd -1 until the run ends
+
+			DynamicArray<SocketServerWatch> watches;
+			DynamicArray<struct pollfd> poll_fds;
+			bool running_watches = false;
+
+			void run_timers()
+			{
+				if (timers.size() == 0) return;
+
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+				// Callbacks may set new timers, the expired timer is popped first
+
+				while (timers.size() != 0 && timers.top().deadline <= now) {
+					SocketServerTimer timer = timers.pop();
+					timer.callback();
+				}
+			}
+
+			/**
+			 *  @brief  Runs the callbacks of the readable watched file
+			 *  descriptors, checked with one poll() that does not wait.
+			 */
+			void run_watches()
+			{
+				if (watches.size() == 0) return;
+				if (::poll(poll_fds.data(), poll_fds.size(), 0) <= 0) return;
+
+				// Watches added by callbacks are appended after watch_count
+
+				size_t watch_count = watches.size();
+				running_watches = true;
+
+				for (size_t i = 0; i < watch_count; i++) {
+					if (poll_fds[i].revents == 0 || watches[i].fd < 0) continue;
+
+					// The callback is moved out, callbacks may add watches
+
+					int fd = watches[i].fd;
+					watch_callback_t callback = std::move(watches[i].callback);
+					callback();
+
+					if (watches[i].fd == fd) watches[i].callback = std::move(callback);
+				}
+
+				running_watches = false;
+				remove_watch(-1);
+			}
+
+			void run_posted()
+			{
+				if (!has_posted.load(std::memory_order_acquire)) return;
+
+				while (true) {
+					task_t fn;
+
+					{
+						std::lock_guard<std::mutex> lock(posted_mutex);
+
+						if (posted.size() == 0) {
+							has_posted.store(false, std::memory_order_relaxed);
+							return;
+						}
+
+						fn = posted.pop();
+					}
+
+					fn();
+				}
+			}
+
 		public:
 			int socket_fd;
 			uint16_t port;
@@ -25,11 +171,111 @@ namespace flow {
 				if (socket_fd < 0) throw "Error opening socket";
 			}
 
+			/**
+			 *  @brief  Runs a function on the thread of the server loop.
+			 *  Sockets are not thread safe, so a thread that wants to write
+			 *  to a socket posts a function that does so.
+			 *  May be called from any thread.
+			 *  @param  fn  The function to run, its captures must fit in a task_t.
+			 *  @note  Runtime: O(1) amortised
+			 *  @note  Memory: O(1) amortised
+			 */
+			void post(task_t&& fn)
+			{
+				std::lock_guard<std::mutex> lock(posted_mutex);
+				posted.push(std::move(fn));
+				has_posted.store(true, std::memory_order_release);
+			}
+
+			/**
+			 *  @brief  Returns whether the calling thread runs the server loop.
+			 */
+			bool runs_on_current_thread() const
+			{
+				return loop_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+			}
+
+			/**
+			 *  @brief  Runs a callback on the server loop after a delay.
+			 *  Must be called from the thread of the server loop.
+			 *  @param  delay  The minimum time to wait.
+			 *  @param  callback  The callback, its captures must fit in a
+			 *  timer_callback_t.
+			 *  @note  Runtime: O(log n), n = number of pending timers
+			 *  @note  Memory: O(1) amortised
+			 */
+			void set_timeout(
+				std::chrono::steady_clock::duration delay,
+				timer_callback_t&& callback
+			) {
+				timers.push(SocketServerTimer {
+					std::chrono::steady_clock::now() + delay,
+					timer_sequence++,
+					std::move(callback)
+				});
+			}
+
+			/**
+			 *  @brief  Watches a file descriptor that is not a socket, e.g. of
+			 *  inotify or an eventfd, and runs a callback on the server loop
+			 *  whenever it is readable. The callback should read until the
+			 *  descriptor would block, it runs again on the next iteration
+			 *  otherwise. Must be called from the thread of the server loop.
+			 *  @param  fd  The file descriptor, should be non-blocking.
+			 *  @param  callback  The callback, its captures must fit in a
+			 *  watch_callback_t.
+			 */
+			void add_watch(int fd, watch_callback_t&& callback)
+			{
+				watches.append(SocketServerWatch { fd, std::move(callback) });
+				poll_fds.append(pollfd { fd, POLLIN, 0 });
+			}
+
+			/**
+			 *  @brief  Stops watching a file descriptor. May be called from a
+			 *  watch callback, also the one of the file descriptor itself.
+			 *  @returns  Whether the file descriptor was watched.
+			 */
+			bool remove_watch(int fd)
+			{
+				bool removed = false;
+
+				for (size_t i = watches.size(); i-- != 0;) {
+					if (watches[i].fd != fd) continue;
+
+					removed = true;
+
+					if (running_watches) {
+						watches[i].fd = -1;
+						poll_fds[i].fd = -1;
+						continue;
+					}
+
+					std::swap(watches[i], watches.back());
+					std::swap(poll_fds[i], poll_fds.back());
+					watches.extract_rear();
+					poll_fds.extract_rear();
+				}
+
+				return removed;
+			}
+
+			/**
+			 *  @brief  Suspends a coroutine running on the server loop for a
+			 *  while: `co_await server.sleep_for(std::chrono::seconds(1));`.
+			 *  @param  delay  The minimum time to sleep.
+			 */
+			SleepAwaiter sleep_for(std::chrono::steady_clock::duration delay)
+			{
+				return SleepAwaiter { *this, delay, Suspension() };
+			}
+
 			void listen_to(
 				uint16_t port,
 				std::function<void (SocketServer&)> callback = NULL
 			) {
 				this->port = port;
+				loop_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
 
 				server_address.sin_family = AF_INET;
 				server_address.sin_addr.s_addr = net::inaddr_any;
@@ -47,7 +293,7 @@ namespace flow {
 				int client_socket_fd;
 
 				struct net::sockaddr_in client_address;
-				net::socklen_t client_address_length = sizeof(client_address);
+				socklen_t client_address_length = sizeof(client_address);
 
 				// Server started successfully, fire the callback
 
@@ -65,8 +311,7 @@ namespace flow {
 
 						new_socket_event.trigger(socket);
 					} else if (errno != EWOULDBLOCK) {
-						String::format("accept() error %d, errno = %d\n",
-							client_socket_fd, errno).print();
+						log_error("accept() error %d, errno = %d", client_socket_fd, errno);
 					}
 
 					// Handle IO on sockets
@@ -74,9 +319,24 @@ namespace flow {
 					for (size_t i = 0; i < client_sockets.size(); i++) {
 						client_sockets[i]->handle_io();
 					}
+
+					run_watches();
+					run_posted();
+					run_timers();
 				}
 			}
 	};
+
+	inline void SleepAwaiter::await_suspend(std::coroutine_handle<> handle)
+	{
+		suspension.suspend(handle);
+		// The timer keeps its own copy of the Suspension, it does not
+		// depend on the awaiter once the coroutine is resumed
+
+		server.set_timeout(delay, [suspension = suspension]() mutable {
+			suspension.resume();
+		});
+	}
 };
 
 #endif
\ No newline at end of file
@@ -3,9 +3,19 @@
 
 #include <bits/stdc++.h>
 
+// Included before the net namespace, so these stay global for other headers
+
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "../data-structures/stream.hpp"
+#include "../debug/logger.hpp"
 #include "../data-structures/string.hpp"
+#include "../data-structures/string-view.hpp"
 #include "../data-structures/queue.hpp"
+#include "../events/coroutine.hpp"
 
 #ifndef FLOW_SOCKET_READ_BUFFER_SIZE
 #define FLOW_SOCKET_READ_BUFFER_SIZE (size_t) 4096
@@ -21,7 +31,48 @@
 
 namespace flow_socket_tools {
 	enum class SocketReadingStates { READING, END };
-	enum class SocketWritingStates { IDLE, WRITING };
+	enum class SocketWritingStates { IDLE, WRITING, FAILED };
+};
+
+namespace flow {
+	class Socket;
+
+	enum class SocketErrors {
+		CONCURRENT_READ,
+		CONCURRENT_WRITE
+	};
+};
+
+namespace flow_socket_tools {
+	/**
+	 *  @brief  Awaiter of Socket::read(), resumed with the next chunk.
+	 */
+	struct SocketReadAwaiter {
+		flow::Socket& socket;
+		flow::Suspension suspension;
+
+		// The chunk that was read, only valid during await_resume()
+
+		const flow::String *chunk = NULL;
+
+		bool await_ready();
+		void await_suspend(std::coroutine_handle<> handle);
+		flow::StringView await_resume();
+	};
+
+	/**
+	 *  @brief  Awaiter of Socket::write(), resumed once the
+	 *  write queue of the Socket is empty or writing failed.
+	 */
+	struct SocketWriteAwaiter {
+		flow::Socket& socket;
+		const flow::String& data;
+		flow::Suspension suspension;
+
+		bool await_ready();
+		void await_suspend(std::coroutine_handle<> handle);
+		bool await_resume();
+	};
 };
 
 namespace flow {
@@ -40,12 +91,14 @@ namespace flow {
 
 		ssize_t read(int socket_fd, String& dest)
 		{
-			return read(socket_fd, dest.data(), dest.current_capacity());
+			return ::read(socket_fd, dest.data(), dest.current_capacity());
 		}
 
 		ssize_t write(int socket_fd, const String& src)
 		{
-			return write(socket_fd, src.data(), src.size());
+			// A peer that closed the Socket results in EPIPE instead of SIGPIPE
+
+			return send(socket_fd, src.data(), src.size(), MSG_NOSIGNAL);
 		}
 
 		int set_nonblocking(int fd)
@@ -68,7 +121,51 @@ namespace flow {
 			enum SocketWritingStates writing_state = SocketWritingStates::IDLE;
 
 			String reading_buffer;
-			Queue<String *> write_queue;
+			Queue<String> write_queue;
+
+			// Coroutines waiting in read() and write()
+
+			SocketReadAwaiter *reader = NULL;
+			SocketWriteAwaiter *writer = NULL;
+
+			friend struct flow_socket_tools::SocketReadAwaiter;
+			friend struct flow_socket_tools::SocketWriteAwaiter;
+
+			/**
+			 *  @brief  Splits data into chunks and adds them to the write queue.
+			 */
+			void queue_write(const String& data)
+			{
+				// Nothing more reaches a Socket that failed to be written
+
+				if (writing_state == SocketWritingStates::FAILED) return;
+
+				// Chunks can outlive the request that wrote them,
+				// so they are kept off its Arena
+
+				ArenaScope heap_scope(NULL);
+
+				// Split String into chunks and add the chunks to the write queue
+
+				size_t i = 0;
+				size_t data_size = data.size();
+
+				while (i < data_size) {
+					size_t chunk_size = std::min(data_size - i,
+						FLOW_SOCKET_WRITE_BUFFER_SIZE);
+
+					String chunk(chunk_size);
+					chunk.unsafe_increment_element_count(chunk_size);
+					memcpy(chunk.data(), data.data() + i, chunk_size);
+
+					write_queue.push(std::move(chunk));
+					i += chunk_size;
+				}
+
+				// Enable writing state
+
+				writing_state = SocketWritingStates::WRITING;
+			}
 
 			void io_handle_read()
 			{
@@ -77,37 +174,113 @@ namespace flow {
 				// Read a chunk
 
 				ssize_t bytes_rw = net::read(socket_fd, reading_buffer);
-				reading_buffer.unsafe_set_element_count(bytes_rw);
 
 				if (bytes_rw < 0) {
-					if (errno != EWOULDBLOCK && errno != EAGAIN)
-						String::format("read() error %ld", bytes_rw).print();
+					if (errno == EWOULDBLOCK || errno == EAGAIN) return;
 
+					// Nothing more can be read, so the Socket ends as if
+					// the peer closed it
+
+					log_error("read() error %ld, errno = %d", bytes_rw, errno);
+
+					reading_state = SocketReadingStates::END;
+
+					if (reader != NULL) {
+						SocketReadAwaiter *awaiter = reader;
+						reader = NULL;
+
+						awaiter->suspension.resume();
+					}
+
+					in.end();
 					return;
 				}
 
-				// On reading end, end the reading state
+				reading_buffer.unsafe_set_element_count(bytes_rw);
+
+				// The reading end is only reached when the peer closes its
+				// side, a short read just means nothing more has arrived yet
 
-				if (bytes_rw < FLOW_SOCKET_READ_BUFFER_SIZE) {
+				if (bytes_rw == 0) {
 					reading_state = SocketReadingStates::END;
 				}
 
+				// The reader gets the chunk before the listeners of the in
+				// Stream, which may modify it
+
+				if (reader != NULL) {
+					SocketReadAwaiter *awaiter = reader;
+					reader = NULL;
+
+					awaiter->chunk = &reading_buffer;
+					awaiter->suspension.resume();
+				}
+
 				in.write(reading_buffer);
+
+				if (reading_state == SocketReadingStates::END) in.end();
+			}
+
+			/**
+			 *  @brief  Resumes the coroutine waiting in write(), if any.
+			 */
+			void resume_writer()
+			{
+				if (writer == NULL) return;
+
+				SocketWriteAwaiter *awaiter = writer;
+				writer = NULL;
+
+				awaiter->suspension.resume();
 			}
 
 			void io_handle_write()
 			{
-				if (writing_state == SocketWritingStates::IDLE) return;
-				if (write_queue.size() == 0) {
-					writing_state = SocketWritingStates::IDLE;
-					return;
-				}
+				if (writing_state != SocketWritingStates::WRITING) return;
 
 				// Write the next chunk
 
-				String *chunk = write_queue.pop();
-				ssize_t bytes_rw = net::write(socket_fd, *chunk);
-				delete chunk;
+				if (write_queue.size() != 0) {
+					String& chunk = write_queue.front();
+					ssize_t bytes_rw = net::write(socket_fd, chunk);
+
+					if (bytes_rw < 0) {
+						if (errno == EWOULDBLOCK || errno == EAGAIN) return;
+
+						// The unwritten chunks can never be delivered, drop
+						// them and end the out Stream to report the failure
+
+						log_error("write() error %ld, errno = %d", bytes_rw, errno);
+
+						ArenaScope heap_scope(NULL);
+
+						write_queue = Queue<String>();
+						writing_state = SocketWritingStates::FAILED;
+
+						out.end();
+						resume_writer();
+						return;
+					}
+
+					// The unwritten tail of a short write stays at the
+					// front of the queue, to be written on the next tick
+
+					if ((size_t) bytes_rw < chunk.size()) {
+						ArenaScope heap_scope(NULL);
+
+						String tail = chunk.substring(bytes_rw);
+						write_queue.pop();
+						write_queue.prepend(std::move(tail));
+						return;
+					}
+
+					write_queue.pop();
+				}
+
+				if (write_queue.size() == 0) {
+					writing_state = SocketWritingStates::IDLE;
+					resume_writer();
+				}
 			}
 
 		public:
@@ -129,30 +302,7 @@ namespace flow {
 				out.start();
 
 				out.on_data([this](String& data) {
-					// Split String into chunks and add the chunks to the write queue
-
-					String *chunk;
-					size_t i = 0;
-					size_t data_size = data.size();
-
-					while (i < data_size) {
-						size_t chunk_size = std::min(data_size,
-							FLOW_SOCKET_WRITE_BUFFER_SIZE);
-
-						chunk = new String(chunk_size);
-						chunk->unsafe_increment_element_count(chunk_size);
-
-						for (size_t j = 0; j < chunk_size; j++) {
-							chunk->set_at_index(j, data[i + j]);
-						}
-
-						write_queue.push(chunk);
-						i += chunk_size;
-					}
-
-					// Enable writing state
-
-					writing_state = SocketWritingStates::WRITING;
+					queue_write(data);
 				});
 			}
 
@@ -162,7 +312,76 @@ namespace flow {
 				io_event.trigger(in, out);
 				io_handle_write();
 			}
+
+			/**
+			 *  @brief  Reads the next chunk from the Socket in a coroutine:
+			 *  `StringView chunk = co_await socket.read();`.
+			 *  Only one coroutine may read from a Socket at a time.
+			 *  Chunks that arrived before the coroutine started waiting only
+			 *  went to the in Stream, e.g. to the parser of an HTTP request.
+			 *  @returns  An awaitable that results in a view of the chunk,
+			 *  which is empty once the peer closed the Socket or reading it
+			 *  failed. The view is only valid until the coroutine is
+			 *  suspended again, the chunk must be copied to keep it.
+			 */
+			SocketReadAwaiter read()
+			{
+				return SocketReadAwaiter { *this, Suspension() };
+			}
+
+			/**
+			 *  @brief  Writes data to the Socket in a coroutine and waits
+			 *  until all queued data was written: `co_await socket.write(data);`.
+			 *  Only one coroutine may wait for a Socket to be written at a time.
+			 *  The data does not go through the out Stream.
+			 *  @param  data  The data to write, it is copied immediately.
+			 *  @returns  An awaitable that results in whether all data was
+			 *  written, false once writing to the Socket failed.
+			 */
+			SocketWriteAwaiter write(const String& data)
+			{
+				return SocketWriteAwaiter { *this, data, Suspension() };
+			}
 	};
 };
 
+namespace flow_socket_tools {
+	inline bool SocketReadAwaiter::await_ready()
+	{
+		if (socket.reader != NULL) throw flow::SocketErrors::CONCURRENT_READ;
+		return socket.reading_state == SocketReadingStates::END;
+	}
+
+	inline void SocketReadAwaiter::await_suspend(std::coroutine_handle<> handle)
+	{
+		suspension.suspend(handle);
+		socket.reader = this;
+	}
+
+	inline flow::StringView SocketReadAwaiter::await_resume()
+	{
+		if (chunk == NULL) return flow::StringView();
+		return flow::StringView(*chunk);
+	}
+
+	inline bool SocketWriteAwaiter::await_ready()
+	{
+		if (socket.writer != NULL) throw flow::SocketErrors::CONCURRENT_WRITE;
+
+		socket.queue_write(data);
+		return socket.write_queue.size() == 0;
+	}
+
+	inline void SocketWriteAwaiter::await_suspend(std::coroutine_handle<> handle)
+	{
+		suspension.suspend(handle);
+		socket.writer = this;
+	}
+
+	inline bool SocketWriteAwaiter::await_resume()
+	{
+		return socket.writing_state != SocketWritingStates::FAILED;
+	}
+};
+
 #endif
\ No newline at end of file